@@ -3,6 +3,10 @@
 #include "chess_piece.h"
 #include "chess_board.h"
 #include "chess_utils.h"
+#include "chess_position.h"
+#include "chess_history.h"
+#include "chess_seqlock.h"
+#include <algorithm>
 #include <iostream>
 
 // This Class is specifically tailor-made for standard chess, that's why we have specific values/constants, and not user-defined. 
@@ -12,49 +16,157 @@
 // We have the option to customize piece positions to non-standard ones using the exposed API add_piece and remove_piece. If you want to add new piece TYPES as well,
 // you need to make the member piece_types as public!
 class _Chess {
-    const static int BOARD_SIZE;
+    static constexpr int BOARD_SIZE = 8;                        // Board & moves are compiled for this size (see Board<N>)
     const static int PAWN_OFFSET , PIECE_OFFSET, START_OFFSET;
     const static std::string color_name[Color::MAX];
 
-    Piece_type* pawn_info;
-    PType_set piece_types;
+    // Piece-level side of the game : piece types, the board used for setting up positions by hand (add_piece / remove_piece, then
+    // start() copies it into the rules state below) and the SAN reader built on those types. Only made on first use, so a game that
+    // just plays moves, and every fork(), never allocates it.
+    struct Setup {
+        Piece_type* pawn_info;
+        PType_set piece_types;
+        PieceID_map<BOARD_SIZE> avl_pieces[Color::MAX];
+        Board<BOARD_SIZE> board;
+        Move<BOARD_SIZE> move_in;
+
+        Setup() : board(START_OFFSET + PIECE_OFFSET), move_in(&piece_types) {
+            assert(PAWN_OFFSET != PIECE_OFFSET);
+            [[maybe_unused]] int max_row = std::max(PAWN_OFFSET, PIECE_OFFSET);
+            assert(START_OFFSET + max_row < BOARD_SIZE - 1 - START_OFFSET - max_row);
+
+            pawn_info = new Pawn();
+            piece_types.insert(new Knight());
+            piece_types.insert(new Bishop());
+            piece_types.insert(new Rook());
+            piece_types.insert(new Queen());
+            piece_types.insert(new King());
+
+            reset();
+        }
 
-    PieceID_map avl_pieces[Color::MAX];
-    
-    Board board;
+        ~Setup() {
+            delete pawn_info;
+            pawn_info = nullptr;
+            for (auto& ptype_ptr : piece_types)
+                delete ptype_ptr;
+            piece_types.clear();
+        }
+
+        // Default starting position of standard chess on the board
+        void reset() {
+            for (Color c = WHITE; c < Color::MAX; c = (Color) ((int) c + 1)) {
+                for (auto& [id, p] : avl_pieces[c])
+                    board.vacate(p.rank(), p.file());
+                avl_pieces[c].clear();
+            }
+            for (Color c = WHITE; c < Color::MAX; c = (Color) ((int) c + 1)) {
+                // Place pawns (using default for standard chess)
+                int pawn_rank = (c == WHITE)? (START_OFFSET + PAWN_OFFSET) : (BOARD_SIZE - 1 - START_OFFSET - PAWN_OFFSET);
+                for (int file=0; file < BOARD_SIZE; file++)
+                    avl_pieces[c].push_back(Piece<BOARD_SIZE>(pawn_info, c, {pawn_rank, file}, &board));
+                // Place pieces
+                int piece_rank = (c == WHITE)? (START_OFFSET + PIECE_OFFSET) : (BOARD_SIZE - 1 - START_OFFSET - PIECE_OFFSET);
+                for (auto& ptype : piece_types) {
+                    assert(ptype->count() <= 2);
+                    for (int i=0, start_file=0; i < ptype->count(); i++, start_file += BOARD_SIZE - 1) {
+                        // 0 to 1, 1 to -1? Eqn is -2x + 1
+                        int file = start_file + (1 - 2*i) * (START_OFFSET + ptype->file_offset_default());
+                        assert(board[piece_rank][file] == nullptr);
+                        avl_pieces[c].push_back(Piece<BOARD_SIZE>(ptype, c, {piece_rank, file}, &board));
+                    }
+                }
+            }
+            assert(board.validate());       // Asserting to ensure reset game is valid, else crash. As this does not accept user args
+                                            // It is programmer's responsibility to ensure reset() produces valid board!
+        }
+
+        // FEN of the pieces currently on board, white to move. Castling allowed where king & rook still stand on their home squares
+        std::string fen() {
+            std::string fen;
+            for (int rank = BOARD_SIZE - 1; rank >= 0; rank--) {
+                int empty = 0;
+                for (int file = 0; file < BOARD_SIZE; file++) {
+                    Piece_ptr<BOARD_SIZE>& cell = board[rank][file];
+                    if (cell == nullptr) {
+                        empty++;
+                        continue;
+                    }
+                    if (empty) fen += (char) ('0' + empty);
+                    empty = 0;
+                    char shorthand = (cell->type == pawn_info) ? 'P' : cell->type->shorthand;
+                    fen += (cell->color == WHITE) ? shorthand : (char) std::tolower(shorthand);
+                }
+                if (empty) fen += (char) ('0' + empty);
+                if (rank) fen += '/';
+            }
+            std::string castling;
+            for (Color c = WHITE; c < Color::MAX; c = (Color) ((int) c + 1)) {
+                int home = (c == WHITE) ? START_OFFSET + PIECE_OFFSET : BOARD_SIZE - 1 - START_OFFSET - PIECE_OFFSET;
+                auto is = [&](int file, char shorthand) {
+                    Piece_ptr<BOARD_SIZE>& cell = board[home][file];
+                    return cell != nullptr && cell->color == c && cell->type->shorthand == shorthand;
+                };
+                if (!is(piece_types['K']->file_offset_default(), 'K'))
+                    continue;
+                if (is(BOARD_SIZE - 1, 'R')) castling += (c == WHITE) ? 'K' : 'k';
+                if (is(0, 'R')) castling += (c == WHITE) ? 'Q' : 'q';
+            }
+            return fen + " w " + (castling.empty() ? "-" : castling) + " - 0 1";
+        }
+    };
+
+    Setup* setup;                               // nullptr until setup_board() first needs it
     bool valid_game;
     
     bool ongoing_game;
     int captured_points[Color::MAX];
     Color turn;
-    Move move_in;
     int win;
 
+    // Rules state for playing moves : legality, check, game end
+    Position position;
+    Game_history history;                       // Moves played & the keys they led to (repetition), shared with snapshots
+    Seqlock<Game_view> feed;                    // Latest state for other threads (view()), republished after every change
+
+    static_assert(BOARD_SIZE == 8, "Position (move rules) only handles the standard 8x8 board");
+
+    Setup& setup_board() {
+        if (!setup)
+            setup = new Setup();
+        return *setup;
+    }
+
+    // Check for game end after a move (or a new position) : mate, stalemate, 50 moves, threefold repetition, dead position
+    void update_status() {
+        if (!position.has_legal_moves())
+            win = position.in_check() ? 1 - position.turn : Color::MAX;
+        else if (position.halfmove_clock >= 100 || history.repetitions(position.halfmove_clock) >= 2 || position.insufficient_material())
+            win = Color::MAX;
+        ongoing_game = (win == -1);
+    }
+
+    void publish() {
+        int ply = history.size() - 1;
+        feed.store(Game_view{position, history[ply].move, (uint16_t) ply, (int8_t) win, ongoing()});
+    }
+
 public:
-    _Chess() : board(BOARD_SIZE, START_OFFSET + PIECE_OFFSET), move_in(&piece_types, BOARD_SIZE) {
-        assert(PAWN_OFFSET != PIECE_OFFSET);
-        int max_row = std::max(PAWN_OFFSET, PIECE_OFFSET);
-        assert(START_OFFSET + max_row < BOARD_SIZE - 1 - START_OFFSET - max_row);
-
-        pawn_info = new Pawn();
-        piece_types.insert(new Knight());
-        piece_types.insert(new Bishop());
-        piece_types.insert(new Rook());
-        piece_types.insert(new Queen());
-        piece_types.insert(new King());
-        
+    _Chess() : setup(nullptr) {
         reset_game();
     }
 
+    // Continuing from a saved state : the rules state only, no piece-level setup
+    _Chess(const Chess_snapshot& snapshot) : setup(nullptr), captured_points{} {
+        restore(snapshot);
+    }
+
     ~_Chess() {
-        delete pawn_info;
-        pawn_info = nullptr;
-        for (auto& ptype_ptr : piece_types)
-            delete ptype_ptr;
-        piece_types.clear();
+        delete setup;
+        setup = nullptr;
     }
 
-    // Reset to default starting position of standard chess. Board validity to be ensured after reset!
+    // Reset to default starting position of standard chess
     void reset_game() {
         win = -1;
         valid_game = true;
@@ -62,31 +174,11 @@ public:
         turn = WHITE;
         std::fill_n(captured_points, Color::MAX, 0);
 
-        for (Color c = WHITE; c < Color::MAX; c = (Color) ((int) c + 1)) {
-            for (auto& [id, p] : avl_pieces[c])
-                board[p.rank()][p.file()] = nullptr;
-            avl_pieces[c].clear();
-        }
-        // std::cout << std::endl;
-        for (Color c = WHITE; c < Color::MAX; c = (Color) ((int) c + 1)) {
-            // Place pawns (using default for standard chess)
-            int pawn_rank = (c == WHITE)? (START_OFFSET + PAWN_OFFSET) : (BOARD_SIZE - 1 - START_OFFSET - PAWN_OFFSET);
-            for (int file=0; file < BOARD_SIZE; file++)
-                avl_pieces[c].push_back(Piece(pawn_info, c, {pawn_rank, file}, &board));
-            // Place pieces
-            int piece_rank = (c == WHITE)? (START_OFFSET + PIECE_OFFSET) : (BOARD_SIZE - 1 - START_OFFSET - PIECE_OFFSET);
-            for (auto& ptype : piece_types) {
-                assert(ptype->count() <= 2);
-                for (int i=0, start_file=0; i < ptype->count(); i++, start_file += BOARD_SIZE - 1) {
-                    // 0 to 1, 1 to -1? Eqn is -2x + 1
-                    int file = start_file + (1 - 2*i) * (START_OFFSET + ptype->file_offset_default());
-                    assert(board[piece_rank][file] == nullptr);
-                    avl_pieces[c].push_back(Piece(ptype, c, {piece_rank, file}, &board));
-                }
-            }
-        }
-        assert(board.validate());       // Asserting to ensure reset game is valid, else crash. As this does not accept user args
-                                        // It is programmer's responsibility to ensure reset_game() produces valid board!
+        position.set_start();
+        history.reset(position.key);
+        if (setup)
+            setup->reset();
+        publish();
     }
 
     // Reset move counters for all pieces on board to 0, without moving any piece
@@ -96,43 +188,148 @@ public:
 
     // Add a piece of type with given shorthand, to board[piece_rank][piece_file], if empty. Return true if added.
     bool add_piece(char shorthand, Color c, int rank, int file) {
-        if (board[rank][file] != nullptr)
+        Setup& s = setup_board();
+        if (s.board[rank][file] != nullptr)
             return false;                                   // Occupied cell
-        if (piece_types[shorthand] == nullptr)
+        if (s.piece_types[shorthand] == nullptr)
             return false;                                   // Invalid piece type
         
-        avl_pieces[c].push_back(Piece(piece_types[shorthand], c, {rank, file}, &board));
+        s.avl_pieces[c].push_back(Piece<BOARD_SIZE>(s.piece_types[shorthand], c, {rank, file}, &s.board));
         valid_game = false;
+        publish();
         return true;
     }
 
     // Remove piece if it exists, from board[piece_rank][piece_file]
     void remove_piece(int piece_rank, int piece_file) {
-        Piece_ptr* piece_ptr_ptr = &(board[piece_rank][piece_file]);
+        Setup& s = setup_board();
+        Piece_ptr<BOARD_SIZE>* piece_ptr_ptr = &(s.board[piece_rank][piece_file]);
         if (*piece_ptr_ptr == nullptr)
             return;
         
-        avl_pieces[(*piece_ptr_ptr)->color].remove(piece_ptr_ptr);
+        s.avl_pieces[(*piece_ptr_ptr)->color].remove(piece_ptr_ptr);
         valid_game = false;
+        publish();
     }
 
     // Must manually call this after adding/removing pieces, to start game again
     bool start() {
         if (valid_game) return true;
-        return valid_game = board.validate();
+        Setup& s = setup_board();
+        if (!s.board.validate() || !set_fen(s.fen()))
+            return false;
+        return valid_game;
+    }
+
+    // Start from an arbitrary position instead (the piece-level board is left as it was)
+    bool set_fen(const std::string& fen) {
+        Position parsed;
+        if (!parsed.set_fen(fen))
+            return false;
+        position = parsed;
+        history.reset(position.key);
+        turn = position.turn;
+        win = -1;
+        valid_game = true;
+        update_status();
+        publish();
+        return true;
+    }
+
+    // Play a move given in SAN, if legal. Returns false (nothing played) otherwise
+    bool play_move(const std::string& move) {
+        setup_board().move_in = move;
+        return play_parsed_move();
+    }
+
+    bool play_parsed_move() {
+        if (!ongoing())
+            return false;
+        Move16 m = position.find_move(setup_board().move_in);
+        return !m.is_null() && play_move(m);
+    }
+
+    // Play a move from Position's generator (engines), if legal
+    bool play_move(Move16 move) {
+        if (!ongoing())
+            return false;
+        Move16 list[MAX_MOVES];
+        int n = position.generate_moves(list);
+        if (std::find(list, list + n, move) == list + n)
+            return false;
+        position.play(move);
+        history.push(move, position.key);
+        turn = position.turn;
+        update_status();
+        publish();
+        return true;
+    }
+
+    size_t replay(std::span<const Move16> moves, bool trusted, std::span<uint64_t> keys, std::span<Position> positions) {
+        assert(keys.empty() || keys.size() >= moves.size());
+        assert(positions.empty() || positions.size() >= moves.size());
+        size_t played = 0;
+        if (!trusted) {
+            for (; played < moves.size() && play_move(moves[played]); played++) {
+                if (!keys.empty()) keys[played] = position.key;
+                if (!positions.empty()) positions[played] = position;
+            }
+            return played;
+        }
+        if (!ongoing())
+            return 0;
+        for (; played < moves.size(); played++) {
+            Move16 move = moves[played];
+#ifndef NDEBUG
+            Move16 list[MAX_MOVES];
+            int n = position.generate_moves(list);
+            assert(std::find(list, list + n, move) != list + n && "Illegal move in a trusted replay");
+#endif
+            position.play(move);
+            history.push(move, position.key);
+            if (!keys.empty()) keys[played] = position.key;
+            if (!positions.empty()) positions[played] = position;
+        }
+        turn = position.turn;
+        update_status();
+        publish();
+        return played;
     }
 
     // This function should be called to allow next move to be taken as input from stdin/file
     void play_move() {
-        if (!valid_game) return;
+        if (!ongoing()) return;
         do {
             std::cout << "Enter a move in std notation: ";
-            std::cin >> move_in;
-        } while (!board.play_if_valid(turn, move_in));
-        
-        turn = (Color) (((int) turn + 1) % (int) Color::MAX);       // Generic turn -- 2-player (1 - turn) is better
+            std::cin >> setup_board().move_in;
+            if (!std::cin) return;                                  // Input closed, no move
+        } while (!play_parsed_move());
+    }
+
+    const Position& get_position() {
+        return position;
+    }
+
+    Game_view view() const {
+        return feed.load();
+    }
+
+    Key_history get_history() {
+        return history.keys();
+    }
 
-        // NEED TO SET WIN AFTER GAME OVER!
+    Chess_snapshot snapshot() {
+        return Chess_snapshot{position, history, (int8_t) win, valid_game, ongoing_game};
+    }
+
+    void restore(const Chess_snapshot& snap) {
+        position = snap.position;
+        history = snap.history;
+        win = snap.win;
+        valid_game = snap.valid_game;
+        ongoing_game = snap.ongoing_game;
+        turn = position.turn;
+        publish();
     }
 
     // This function draws the board in a file
@@ -141,7 +338,7 @@ public:
     }
 
     bool ongoing() {
-        return valid_game;
+        return valid_game && ongoing_game;
     }
 
     bool is_draw() {
@@ -158,7 +355,6 @@ public:
     }
 };
 
-const int _Chess::BOARD_SIZE = 8;
 const int _Chess::PAWN_OFFSET = 1;                               // Assume all pawns are placed initially on the same rank (by default)
 const int _Chess::PIECE_OFFSET = 0;                              // Assume all pieces are placed initially on the same rank (by default)
 const int _Chess::START_OFFSET = 0;                              // Assume we start placing from 0th rank and file (and symmetrically so)
@@ -170,6 +366,17 @@ Chess::Chess() {
     chess = new _Chess();
 }
 
+Chess::Chess(_Chess* chess) : chess(chess) {}
+
+Chess::Chess(Chess&& other) : chess(other.chess) {
+    other.chess = nullptr;
+}
+
+Chess& Chess::operator=(Chess&& other) {
+    std::swap(chess, other.chess);
+    return *this;
+}
+
 Chess::~Chess() {
     delete chess;
 }
@@ -186,6 +393,46 @@ void Chess::play_move() {
     chess->play_move();
 }
 
+bool Chess::play_move(const std::string& move) {
+    return chess->play_move(move);
+}
+
+bool Chess::play_move(Move16 move) {
+    return chess->play_move(move);
+}
+
+bool Chess::set_fen(const std::string& fen) {
+    return chess->set_fen(fen);
+}
+
+const Position& Chess::position() {
+    return chess->get_position();
+}
+
+Key_history Chess::history() {
+    return chess->get_history();
+}
+
+Chess_snapshot Chess::snapshot() {
+    return chess->snapshot();
+}
+
+void Chess::restore(const Chess_snapshot& snapshot) {
+    chess->restore(snapshot);
+}
+
+size_t Chess::replay(std::span<const Move16> moves, bool trusted, std::span<uint64_t> keys, std::span<Position> positions) {
+    return chess->replay(moves, trusted, keys, positions);
+}
+
+Game_view Chess::view() const {
+    return chess->view();
+}
+
+Chess Chess::fork() {
+    return Chess(new _Chess(snapshot()));
+}
+
 void Chess::show_board() {
     chess->show_board();
 }
@@ -216,4 +463,12 @@ bool Chess::is_draw() {
 
 std::string Chess::winner() {
     return chess->winner();
-}
\ No newline at end of file
+}
+
+Chess_stats Chess::stats() {
+    return chess_ns::collect_stats();
+}
+
+void Chess::reset_stats() {
+    chess_ns::reset_stats();
+}
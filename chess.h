@@ -1,20 +1,90 @@
 #include <string>
+#include "chess_stats.h"
+#include "chess_position.h"
+#include "chess_history.h"
+#include <span>
+#include <type_traits>
 
 class _Chess;           // Hidden implementation
 
+// Rules state of a game at some point, to go back to with Chess::restore() (any number of times, into any Chess object). Position is
+// flat & trivially copyable, the move history is shared with the game it was taken from until one of them plays on (copy-on-write).
+// The piece-level setup board (add_piece / remove_piece) is not part of it.
+struct Chess_snapshot {
+    Position position;
+    Game_history history;
+    int8_t win;                         // Color that won, Color::MAX for a draw, -1 while undecided
+    bool valid_game;
+    bool ongoing_game;
+};
+
+static_assert(std::is_trivially_copyable_v<Position> && sizeof(Position) <= 200, "Snapshots rely on a small flat position");
+
+// What spectators see of a live game, published by the game after every change (see Chess::view())
+struct Game_view {
+    Position position;
+    Move16 last_move;                   // Null at the start position
+    uint16_t ply;                       // Moves played since the start position
+    int8_t win;                         // As in Chess_snapshot
+    bool ongoing;
+};
+
 class Chess {
     _Chess* chess;
+
+    Chess(_Chess* chess);
 public:
     Chess();
 
+    Chess(const Chess&) = delete;                   // See fork()
+
+    Chess(Chess&& other);
+
+    Chess& operator=(Chess&& other);
+
     ~Chess();
 
     void reset_game();
 
     bool ongoing();
 
+    // Read moves from stdin until a legal one is entered, and play it
     void play_move();
 
+    // Play a move in SAN / from Position's move generator. Returns false if illegal (or game over), nothing is played then
+    bool play_move(const std::string& move);
+
+    bool play_move(Move16 move);
+
+    // Play a whole sequence of moves, e.g. a stored game. trusted : moves are known legal (our own records), they're only asserted
+    // in debug builds, and game end (mate, draws) is looked at once after the last one instead of after every move. Otherwise each
+    // move is checked like play_move(Move16), stopping at the first illegal one. Returns the number of moves played.
+    // keys / positions, if not empty (then at least moves.size() long) : Zobrist key / flat position after each move played, for
+    // analytics that want every intermediate position (features are then taken from the positions).
+    size_t replay(std::span<const Move16> moves, bool trusted = true, std::span<uint64_t> keys = {}, std::span<Position> positions = {});
+
+    // Start the game from a FEN position instead of the pieces on board
+    bool set_fen(const std::string& fen);
+
+    // Current position, for engines
+    const Position& position();
+
+    // Keys of the positions played so far, for searches to see repetitions against the game
+    Key_history history();
+
+    // Save the game state / go back to a saved one. Cheap : a flat position copy plus a shared history pointer
+    Chess_snapshot snapshot();
+
+    void restore(const Chess_snapshot& snapshot);
+
+    // Independent game continuing from the current state (which this one keeps), e.g. to explore a candidate line. About as cheap as
+    // snapshot() : the piece-level setup board isn't copied, the fork's starts out as a new game's (standard setup) if it's ever used
+    Chess fork();
+
+    // Latest position & last move, callable from any thread while the game's own thread keeps playing : a consistent copy, never a
+    // half-played move. Published through a seqlock, so readers don't lock anything and the game thread never waits on them
+    Game_view view() const;
+
     void show_board();
 
     bool add_piece_white(char piece_shorthand, int rank, int file);
@@ -30,4 +100,9 @@ public:
     bool is_draw();
 
     std::string winner();
+
+    // Instrumentation counters summed over all threads (see chess_stats.h ; all zero unless built with CHESS_STATS)
+    static Chess_stats stats();
+
+    static void reset_stats();
 };
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "chess_arena.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+Arena::Arena(size_t block_size) : first(nullptr), current(nullptr), cursor(nullptr), limit(nullptr), block_size(block_size),
+    free_lists{}, heap_blocks(0) {}
+
+Arena::~Arena() {
+    while (first) {
+        Block* next = first->next;
+        std::free(first);
+        first = next;
+    }
+}
+
+void* Arena::grow(size_t bytes, size_t align) {
+    size_t needed = bytes + align;
+    Block* next = current ? current->next : first;
+    if (!next || next->size < needed) {
+        // New block goes right after the current one, blocks further down the chain are still there for later
+        size_t size = std::max(block_size, needed);
+        Block* block = static_cast<Block*>(std::malloc(sizeof(Block) + size));
+        if (!block)
+            throw std::bad_alloc();
+        heap_blocks++;
+        block->size = size;
+        block->next = next;
+        if (current) current->next = block;
+        else first = block;
+        next = block;
+    }
+    current = next;
+    cursor = reinterpret_cast<char*>(current + 1);
+    limit = cursor + current->size;
+    return allocate(bytes, align);
+}
+
+void* Arena::allocate_recycled(size_t bytes) {
+    size_t size_class = (bytes + SMALL_CLASS - 1) / SMALL_CLASS;
+    if (size_class == 0 || size_class > (size_t) SMALL_CLASSES)
+        return allocate(bytes, SMALL_CLASS);
+    void*& head = free_lists[size_class - 1];
+    if (head) {
+        void* p = head;
+        head = *static_cast<void**>(p);
+        return p;
+    }
+    return allocate(size_class * SMALL_CLASS, SMALL_CLASS);
+}
+
+void Arena::recycle(void* p, size_t bytes) {
+    size_t size_class = (bytes + SMALL_CLASS - 1) / SMALL_CLASS;
+    if (!p || size_class == 0 || size_class > (size_t) SMALL_CLASSES)
+        return;
+    *static_cast<void**>(p) = free_lists[size_class - 1];
+    free_lists[size_class - 1] = p;
+}
+
+void Arena::rewind(const Mark& m) {
+    // Recycled blocks may lie past the mark, start over with none (ones below it are simply left unused until the next rewind)
+    std::fill_n(free_lists, SMALL_CLASSES, nullptr);
+    current = m.block;
+    cursor = m.cursor;
+    limit = current ? reinterpret_cast<char*>(current + 1) + current->size : nullptr;
+}
@@ -0,0 +1,130 @@
+#ifndef CHESS_ARENA_H
+#define CHESS_ARENA_H
+
+#include "chess_common.h"
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// Bump allocator for short-lived data that has a clear owner scope : one search, one game being parsed or played. Allocating is a
+// pointer bump, and everything is released together by rewinding to a mark (or reset() to empty), O(1) whatever was allocated.
+// Blocks stay with the arena across rewinds, so once warmed up a scope does no heap allocation at all.
+// No destructors are run on rewind : arrays (make_array) must be trivially destructible, anything else goes in a container using
+// Arena_allocator, which destroys its elements itself. Not thread-safe, an arena belongs to one thread (one Search, one game).
+class Arena {
+    struct Block {
+        Block* next;
+        size_t size;                    // Usable bytes, right after the header
+    };
+
+    static constexpr size_t SMALL_CLASS = 16;           // Size class granularity for recycled small allocations, also their alignment
+    static constexpr int SMALL_CLASSES = 16;            // Up to 256 bytes
+
+    Block* first;
+    Block* current;                     // Block being bumped into, nullptr if nothing allocated yet
+    char* cursor;
+    char* limit;
+    size_t block_size;
+    void* free_lists[SMALL_CLASSES];    // Small allocations handed back by recycle(), by size class
+    uint64_t heap_blocks;
+
+    // Slow path of allocate() : move on to the next block, or get a new one from the heap
+    void* grow(size_t bytes, size_t align);
+
+public:
+    struct Mark {
+        Block* block;
+        char* cursor;
+    };
+
+    explicit Arena(size_t block_size = 64 << 10);
+
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        char* p = (char*) (((uintptr_t) cursor + align - 1) & ~(uintptr_t) (align - 1));
+        if (!current || p + bytes > limit)
+            return grow(bytes, align);
+        cursor = p + bytes;
+        return p;
+    }
+
+    // n value-initialized T (zeroed if plain data)
+    template<typename T>
+    T* make_array(size_t n) {
+        static_assert(std::is_trivially_destructible_v<T>, "Arena never runs destructors");
+        T* p = static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+        std::uninitialized_value_construct_n(p, n);
+        return p;
+    }
+
+    // For containers that free as they go (Arena_allocator) : small blocks handed back are reused by later allocations of the same
+    // size class, so a long-lived container that keeps inserting & erasing nodes doesn't grow the arena. Bigger ones stay until rewind
+    void* allocate_recycled(size_t bytes);
+
+    void recycle(void* p, size_t bytes);
+
+    Mark mark() const {
+        return Mark{current, cursor};
+    }
+
+    // Release everything allocated since m
+    void rewind(const Mark& m);
+
+    // Release everything. Keeps the blocks
+    void reset() {
+        rewind(Mark{nullptr, nullptr});
+    }
+
+    // Blocks taken from the heap so far (a warm arena stops adding to this)
+    uint64_t heap_block_count() const {
+        return heap_blocks;
+    }
+};
+
+// Releases everything allocated in the arena during its lifetime
+class Arena_scope {
+    Arena& arena;
+    Arena::Mark start;
+
+public:
+    Arena_scope(Arena& arena) : arena(arena), start(arena.mark()) {}
+
+    ~Arena_scope() {
+        arena.rewind(start);
+    }
+};
+
+// Standard allocator over an Arena, for containers whose whole contents are released with their scope
+template<typename T>
+struct Arena_allocator {
+    typedef T value_type;
+
+    Arena* arena;
+
+    Arena_allocator(Arena* arena) : arena(arena) {}
+
+    template<typename U>
+    Arena_allocator(const Arena_allocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        if (alignof(T) > 16)
+            return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        return static_cast<T*>(arena->allocate_recycled(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (alignof(T) <= 16)
+            arena->recycle(p, n * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const Arena_allocator<U>& other) const {
+        return arena == other.arena;
+    }
+};
+
+#endif
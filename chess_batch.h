@@ -0,0 +1,77 @@
+#ifndef CHESS_BATCH_H
+#define CHESS_BATCH_H
+
+#include "chess_common.h"
+#include "chess_position.h"
+#include "chess_history.h"
+#include <span>
+#include <string_view>
+
+// Move validation for many games at once, for servers hosting thousands of games that get a batch of moves every tick.
+// Games live in a Game_table, laid out structure-of-arrays : the positions every move touches are packed together (one cache-line
+// aligned slot each), the per-game state next to them is a byte, and the key histories only read for repetition are off to the side.
+// No Chess / Board objects involved, a game is its flat Position.
+
+typedef uint32_t Game_ref;              // Index into a Game_table
+typedef std::string_view Move_text;     // SAN, see parse_san()
+
+typedef enum game_state {
+    GAME_ONGOING,
+    GAME_WHITE_WON,
+    GAME_BLACK_WON,
+    GAME_DRAWN
+} Game_state;
+
+typedef enum move_status {
+    MOVE_PLAYED,
+    MOVE_BAD_NOTATION,                  // Not SAN
+    MOVE_ILLEGAL,                       // Or ambiguous
+    MOVE_GAME_OVER,                     // Game had already ended, nothing played
+    MOVE_NO_GAME                        // Game_ref out of range
+} Move_status;
+
+struct Batch_result {
+    Move16 move;                        // Move played, null if none
+    uint8_t status;                     // Move_status
+    uint8_t state;                      // Game_state after it
+};
+
+class Game_table {
+    // Padding a position to whole cache lines, so prefetching a game pulls in nothing but that game
+    struct alignas(64) Slot {
+        Position position;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint8_t> states;        // Game_state
+    std::vector<Key_history> keys;      // Cold : one store per move, only scanned once a threefold is possible (halfmove clock >= 8)
+    std::vector<San_move> parsed;       // Scratch for validate_batch(), kept to not allocate every batch
+
+    // Play an already resolved legal move on game g, update its state
+    void apply(Game_ref g, Move16 move);
+
+public:
+    // New game from the standard start position, or a FEN. Returns its ref, or size() (nothing added) if the FEN is bad
+    Game_ref add();
+
+    Game_ref add(const std::string& fen);
+
+    size_t size() const {
+        return slots.size();
+    }
+
+    const Position& position(Game_ref g) const {
+        return slots[g].position;
+    }
+
+    Game_state state(Game_ref g) const {
+        return (Game_state) states[g];
+    }
+
+    // results[i] = outcome of playing moves[i] in game games[i], in that order (a game can appear more than once, its moves then
+    // apply one after the other). All three spans must be the same size. Moves are all parsed first, then played game after game
+    // with the next game's position prefetched.
+    void validate_batch(std::span<const Game_ref> games, std::span<const Move_text> moves, std::span<Batch_result> results);
+};
+
+#endif
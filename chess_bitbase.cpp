@@ -0,0 +1,617 @@
+#include "chess_bitbase.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+namespace chess_ns {
+    const uint32_t BITBASE_FILE_KIND = 0x53414242;          // "BBAS"
+    const uint64_t BITBASE_INDEX_REVISION = 1;              // Bump when the index layout changes
+
+    // Name order of pieces after the king, and their weight in telling the stronger side
+    const Piece_index NAME_ORDER[5] = {QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+    const int STRENGTH[PIECE_MAX] = {1, 3, 3, 5, 9, 0};
+
+    // White king squares of pawnless tables : the a1-d1-d4 triangle
+    inline constexpr auto TRIANGLE = [] {
+        std::array<int8_t, SQUARE_MAX> t{};
+        int n = 0;
+        for (int sq = 0; sq < SQUARE_MAX; sq++)
+            t[sq] = (file_of(sq) <= 3 && rank_of(sq) <= file_of(sq)) ? n++ : -1;
+        return t;
+    }();
+
+    inline constexpr auto TRIANGLE_SQUARE = [] {
+        std::array<int8_t, 10> s{};
+        for (int sq = 0; sq < SQUARE_MAX; sq++)
+            if (TRIANGLE[sq] >= 0)
+                s[TRIANGLE[sq]] = (int8_t) sq;
+        return s;
+    }();
+
+    // Board symmetry t : bit 0 mirrors files, bit 1 ranks, bit 2 swaps them (the a1-h8 diagonal)
+    inline int transform(int sq, int t) {
+        int r = rank_of(sq), f = file_of(sq);
+        if (t & 1) f = 7 - f;
+        if (t & 2) r = 7 - r;
+        if (t & 4) std::swap(r, f);
+        return square(r, f);
+    }
+
+    static uint64_t file_salt(const std::string& name) {
+        return checksum64(name.data(), name.size(), BITBASE_INDEX_REVISION);
+    }
+}
+
+using namespace chess_ns;
+
+
+// ------------------------------------------------------------------------------ Material ------------------------------------------------------------------------------
+
+Bitbase_material::Bitbase_material() {
+    std::memset(count, 0, sizeof(count));
+}
+
+bool Bitbase_material::parse(const std::string& name) {
+    std::memset(count, 0, sizeof(count));
+    size_t second_king = name.find('K', 1);
+    if (name.empty() || name[0] != 'K' || second_king == std::string::npos)
+        return false;
+    for (size_t i = 0; i < name.size(); i++) {
+        Color c = (i < second_king) ? WHITE : BLACK;
+        Piece_index p = (name[i] == 'P') ? PAWN : piece_index(name[i]);
+        if (p == PIECE_MAX || (p == KING && i != 0 && i != second_king))
+            return false;
+        count[c][p]++;
+    }
+    return men() <= BITBASE_MAX_MEN;
+}
+
+Bitbase_material Bitbase_material::of(const Position& pos) {
+    Bitbase_material m;
+    for (int c = WHITE; c < Color::MAX; c++)
+        for (int p = PAWN; p < PIECE_MAX; p++)
+            m.count[c][p] = (uint8_t) popcount(pos.pieces((Color) c, (Piece_index) p));
+    return m;
+}
+
+std::string Bitbase_material::name() const {
+    std::string out;
+    for (int c = WHITE; c < Color::MAX; c++) {
+        out += std::string(count[c][KING], 'K');
+        for (Piece_index p : NAME_ORDER)
+            out += std::string(count[c][p], (p == PAWN) ? 'P' : PIECE_SHORTHAND[p]);
+    }
+    return out;
+}
+
+int Bitbase_material::men() const {
+    int n = 0;
+    for (int c = WHITE; c < Color::MAX; c++)
+        for (int p = PAWN; p < PIECE_MAX; p++)
+            n += count[c][p];
+    return n;
+}
+
+bool Bitbase_material::has_pawns() const {
+    return count[WHITE][PAWN] || count[BLACK][PAWN];
+}
+
+Bitbase_material Bitbase_material::flipped() const {
+    Bitbase_material m;
+    std::memcpy(m.count[WHITE], count[BLACK], PIECE_MAX);
+    std::memcpy(m.count[BLACK], count[WHITE], PIECE_MAX);
+    return m;
+}
+
+bool Bitbase_material::is_canonical() const {
+    int strength[Color::MAX] = {0, 0};
+    for (int c = WHITE; c < Color::MAX; c++)
+        for (int p = PAWN; p < PIECE_MAX; p++)
+            strength[c] += STRENGTH[p] * count[c][p];
+    if (strength[WHITE] != strength[BLACK])
+        return strength[WHITE] > strength[BLACK];
+    for (Piece_index p : NAME_ORDER)
+        if (count[WHITE][p] != count[BLACK][p])
+            return count[WHITE][p] > count[BLACK][p];
+    return true;
+}
+
+bool Bitbase_material::is_trivial_draw() const {
+    for (int c = WHITE; c < Color::MAX; c++)
+        if (count[c][PAWN] || count[c][ROOK] || count[c][QUEEN])
+            return false;
+    return count[WHITE][KNIGHT] + count[WHITE][BISHOP] + count[BLACK][KNIGHT] + count[BLACK][BISHOP] <= 1;
+}
+
+uint64_t Bitbase_material::key() const {
+    uint64_t k = 0;
+    for (int c = WHITE; c < Color::MAX; c++)
+        for (int p = PAWN; p < PIECE_MAX; p++)
+            k = (k << 3) | count[c][p];
+    return k;
+}
+
+bool Bitbase_material::operator==(const Bitbase_material& other) const {
+    return std::memcmp(count, other.count, sizeof(count)) == 0;
+}
+
+
+// ------------------------------------------------------------------------------ Index -------------------------------------------------------------------------------
+
+namespace chess_ns {
+    void Bitbase_layout::init(const Bitbase_material& m) {
+        material = m;
+        pieces = 0;
+        for (int c = WHITE; c < Color::MAX; c++) {
+            color[pieces] = (uint8_t) c;
+            type[pieces++] = KING;
+            for (Piece_index p : NAME_ORDER)
+                for (int n = 0; n < m.count[c][p]; n++) {
+                    color[pieces] = (uint8_t) c;
+                    type[pieces++] = p;
+                }
+        }
+        size = 2;
+        for (int i = 0; i < pieces; i++) {
+            bool same = i > 0 && color[i] == color[i - 1] && type[i] == type[i - 1];
+            group[i] = same ? group[i - 1] : (uint8_t) i;
+            domain[i] = (i == 0) ? (m.has_pawns() ? 32 : 10) : (type[i] == PAWN) ? 48 : 64;
+            size *= domain[i];
+        }
+    }
+
+    uint64_t Bitbase_layout::index(const int* squares, Color turn) const {
+        uint64_t best = UINT64_MAX;
+        int symmetries = material.has_pawns() ? 2 : 8;
+        for (int t = 0; t < symmetries; t++) {
+            int s[BITBASE_MAX_MEN];
+            for (int i = 0; i < pieces; i++)
+                s[i] = transform(squares[i], t);
+            int king = material.has_pawns() ? ((file_of(s[0]) <= 3) ? rank_of(s[0]) * 4 + file_of(s[0]) : -1) : TRIANGLE[s[0]];
+            if (king < 0)
+                continue;
+            for (int i = 1; i < pieces; i++)
+                for (int j = i; j > group[i] && s[j - 1] > s[j]; j--)
+                    std::swap(s[j - 1], s[j]);
+            uint64_t idx = (uint64_t) turn * domain[0] + king;
+            for (int i = 1; i < pieces; i++)
+                idx = idx * domain[i] + ((type[i] == PAWN) ? s[i] - 8 : s[i]);
+            best = std::min(best, idx);
+        }
+        return best;
+    }
+
+    void Bitbase_layout::decode(uint64_t index, int* squares, Color& turn) const {
+        for (int i = pieces - 1; i > 0; i--) {
+            int local = (int) (index % domain[i]);
+            index /= domain[i];
+            squares[i] = (type[i] == PAWN) ? local + 8 : local;
+        }
+        int king = (int) (index % domain[0]);
+        squares[0] = material.has_pawns() ? square(king / 4, king % 4) : TRIANGLE_SQUARE[king];
+        turn = (Color) (index / domain[0]);
+    }
+
+    void Bitbase_layout::squares_of(const Position& pos, bool flip, int* squares) const {
+        Bitboard b = 0;
+        for (int i = 0; i < pieces; i++) {
+            if (group[i] == i)
+                b = pos.pieces((Color) (flip ? 1 - color[i] : color[i]), (Piece_index) type[i]);
+            int sq = pop_lsb(b);
+            squares[i] = flip ? sq ^ 56 : sq;
+        }
+    }
+
+    void Bitbase_layout::set_position(Position& pos, const int* squares, Color turn) const {
+        pos.clear();
+        for (int i = 0; i < pieces; i++)
+            pos.put_piece((Color) color[i], (Piece_index) type[i], squares[i]);
+        pos.turn = turn;
+    }
+}
+
+
+// ------------------------------------------------------------------------------ Probing -----------------------------------------------------------------------------
+
+std::string bitbase_path(const std::string& dir, const Bitbase_material& material) {
+    return dir + "/" + material.name() + ".bb";
+}
+
+Bitbase::Bitbase() : values(nullptr) {}
+
+Mapped_status Bitbase::open(const std::string& path, const Bitbase_material& material, bool verify) {
+    layout.init(material);
+    Mapped_status status = file.open_readonly(path, BITBASE_FILE_KIND, file_salt(material.name()), verify);
+    if (status != MAPPED_WARM)
+        return status;
+    if (file.payload_size() != (layout.size + 31) / 32 * sizeof(uint64_t)) {
+        file.close();
+        return MAPPED_STALE;
+    }
+    values = static_cast<const uint64_t*>(file.payload());
+    return MAPPED_WARM;
+}
+
+Wdl Bitbase::probe(const Position& pos) const {
+    bool flip = !(Bitbase_material::of(pos) == layout.material);
+    int squares[BITBASE_MAX_MEN];
+    layout.squares_of(pos, flip, squares);
+    return value(layout.index(squares, (Color) (flip ? 1 - pos.turn : pos.turn)));
+}
+
+Bitbases::Bitbases() : men(0) {}
+
+Mapped_status Bitbases::load(const std::string& dir, const std::string& material, bool verify) {
+    Bitbase_material m;
+    if (!m.parse(material))
+        return MAPPED_FAILED;
+    if (!m.is_canonical())
+        m = m.flipped();
+    auto table = std::make_unique<Bitbase>();
+    Mapped_status status = table->open(bitbase_path(dir, m), m, verify);
+    if (status == MAPPED_WARM) {
+        men = std::max(men, m.men());
+        tables[m.key()] = std::move(table);
+    }
+    return status;
+}
+
+int Bitbases::load_dir(const std::string& dir, bool verify) {
+    int loaded = 0;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, error))
+        if (entry.path().extension() == ".bb")
+            loaded += load(dir, entry.path().stem().string(), verify) == MAPPED_WARM;
+    return loaded;
+}
+
+bool Bitbases::probe(const Position& pos, Wdl& result) const {
+    if (pos.castle_rights)
+        return false;
+    Bitbase_material m = Bitbase_material::of(pos);
+    if (m.is_trivial_draw()) {
+        result = WDL_DRAW;
+        return true;
+    }
+    auto it = tables.find((m.is_canonical() ? m : m.flipped()).key());
+    if (it == tables.end())
+        return false;
+    if (pos.ep_square < 0) {
+        result = it->second->probe(pos);
+        return true;
+    }
+
+    // En passant : the position without it, plus what the captures it allows lead to
+    Position plain = pos;
+    plain.ep_square = -1;
+    Wdl v = it->second->probe(plain);
+    Move16 list[MAX_MOVES];
+    int n = pos.generate_moves(list);
+    bool draw = false;
+    for (int i = 0; i < n; i++) {
+        if (list[i].flag() != Move16::EN_PASSANT)
+            continue;
+        Position next = pos;
+        next.play(list[i]);
+        Wdl after;
+        if (!probe(next, after))
+            return false;
+        if (after == WDL_LOSS) {
+            result = WDL_WIN;
+            return true;
+        }
+        draw |= after == WDL_DRAW;
+    }
+    result = (v == WDL_LOSS && draw) ? WDL_DRAW : v;
+    return true;
+}
+
+
+// ------------------------------------------------------------------------------ Generation --------------------------------------------------------------------------
+
+Bitbase_options::Bitbase_options() : threads(std::max(1u, std::thread::hardware_concurrency())) {}
+
+namespace chess_ns {
+    // One table being generated. Values & bitmaps are shared by all threads : 2-bit values only ever go from 0 (unsettled) to
+    // settled, and bitmap bits from 0 to 1, so both are set with an atomic or on their word
+    class Bitbase_generator {
+        const Bitbase_layout& layout;
+        const Bitbases& smaller;            // Tables captures & promotions lead to
+        uint64_t* values;
+        uint64_t* settled;                  // Flagged by the previous level (or the first pass)
+        uint64_t* next;                     // Flagged by this level
+        int threads;
+        std::atomic<uint64_t> flagged;
+
+        Wdl get(uint64_t i) const {
+            uint64_t word = std::atomic_ref<uint64_t>(values[i >> 5]).load(std::memory_order_relaxed);
+            return (Wdl) ((word >> (2 * (i & 31))) & 3);
+        }
+
+        void set(uint64_t i, Wdl v) {
+            std::atomic_ref<uint64_t>(values[i >> 5]).fetch_or((uint64_t) v << (2 * (i & 31)), std::memory_order_relaxed);
+        }
+
+        void flag(uint64_t i) {
+            std::atomic_ref<uint64_t>(next[i >> 6]).fetch_or(1ULL << (i & 63), std::memory_order_relaxed);
+            flagged.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Value of a position reached by a move, for its side to move : as settled so far if it's of this table, else the smaller
+        // table's. With en passant possible, the captures it allows count too (they always leave this table)
+        Wdl reached(const Position& pos) const {
+            Position plain = pos;
+            plain.ep_square = -1;
+            Wdl v = WDL_DRAW;
+            if (Bitbase_material::of(plain) == layout.material) {
+                int squares[BITBASE_MAX_MEN];
+                layout.squares_of(plain, false, squares);
+                v = get(layout.index(squares, plain.turn));
+            }
+            else {
+                [[maybe_unused]] bool covered = smaller.probe(plain, v);
+                assert(covered);
+            }
+            if (pos.ep_square < 0)
+                return v;
+            // Bitbases::probe()'s en passant step, with this table's value for the position without it
+            Move16 list[MAX_MOVES];
+            int n = pos.generate_moves(list);
+            bool draw = false;
+            for (int i = 0; i < n; i++) {
+                if (list[i].flag() != Move16::EN_PASSANT)
+                    continue;
+                Position next = pos;
+                next.play(list[i]);
+                Wdl after = WDL_DRAW;
+                smaller.probe(next, after);
+                if (after == WDL_LOSS)
+                    return WDL_WIN;
+                draw |= after == WDL_DRAW;
+            }
+            return (v == WDL_LOSS && draw) ? WDL_DRAW : v;
+        }
+
+        // What pos's moves settle it as : a move reaching a loss wins, all of them reaching wins loses. WDL_DRAW if neither (yet).
+        // lost_only : pos is known not to be won through its settled moves, stop at the first move that doesn't reach a win
+        Wdl examine(const Position& pos, bool lost_only = false) const {
+            Move16 list[MAX_MOVES];
+            int n = pos.generate_moves(list);
+            if (n == 0)
+                return pos.in_check() ? WDL_LOSS : WDL_DRAW;
+            bool all_wins = true;
+            for (int i = 0; i < n; i++) {
+                Position child = pos;
+                child.play(list[i]);
+                Wdl v = reached(child);
+                if (v == WDL_LOSS)
+                    return WDL_WIN;
+                all_wins &= v == WDL_WIN;
+                if (lost_only && !all_wins)
+                    return WDL_DRAW;
+            }
+            return all_wins ? WDL_LOSS : WDL_DRAW;
+        }
+
+        // work(first, last) over the index space in chunks (whole bitmap words), on all threads
+        template<typename Work>
+        void parallel(Work work) {
+            const uint64_t CHUNK = 1 << 16;
+            std::atomic<uint64_t> next_chunk(0);
+            auto run = [&]() {
+                for (uint64_t first; (first = next_chunk.fetch_add(CHUNK)) < layout.size; )
+                    work(first, std::min(layout.size, first + CHUNK));
+            };
+            std::vector<std::thread> pool;
+            for (int t = 1; t < threads; t++)
+                pool.emplace_back(run);
+            run();
+            for (auto& thread : pool)
+                thread.join();
+        }
+
+        // First pass : illegal slots, and whatever is settled without this table's values (mates, stalemates, captures &
+        // promotions into smaller tables)
+        void first_pass(uint64_t first, uint64_t last) {
+            int squares[BITBASE_MAX_MEN];
+            Color turn;
+            Position pos;
+            for (uint64_t i = first; i < last; i++) {
+                layout.decode(i, squares, turn);
+                Bitboard occupied = 0;
+                bool legal = true;
+                for (int p = 0; p < layout.pieces; p++) {
+                    legal &= !(occupied & bit(squares[p]));
+                    occupied |= bit(squares[p]);
+                }
+                legal = legal && layout.index(squares, turn) == i;
+                if (legal) {
+                    layout.set_position(pos, squares, turn);
+                    legal = !pos.attacked(pos.king_square((Color) (1 - turn)), turn);
+                }
+                if (!legal) {
+                    set(i, WDL_ILLEGAL);
+                    continue;
+                }
+                Wdl v = examine(pos);
+                if (v != WDL_DRAW) {
+                    set(i, v);
+                    flag(i);
+                }
+            }
+        }
+
+        // One level : parents of what the last one settled
+        void level(uint64_t first, uint64_t last) {
+            int squares[BITBASE_MAX_MEN], parent[BITBASE_MAX_MEN];
+            Color turn;
+            Position pos;
+            for (uint64_t w = first >> 6; w < (last + 63) >> 6; w++) {
+                for (uint64_t bits = settled[w]; bits; ) {
+                    uint64_t i = (w << 6) + pop_lsb(bits);
+                    Wdl v = get(i);
+                    layout.decode(i, squares, turn);
+                    Color mover = (Color) (1 - turn);
+                    Bitboard occupied = 0;
+                    for (int p = 0; p < layout.pieces; p++)
+                        occupied |= bit(squares[p]);
+
+                    for (int p = 0; p < layout.pieces; p++) {
+                        if (layout.color[p] != mover)
+                            continue;
+                        int from = squares[p];
+                        Bitboard origins, double_push = 0;
+                        if (layout.type[p] == PAWN) {
+                            int back = (mover == WHITE) ? -8 : 8, rank = (mover == WHITE) ? rank_of(from) : 7 - rank_of(from);
+                            origins = (rank >= 2 && !(occupied & bit(from + back))) ? bit(from + back) : 0;
+                            if (rank == 3 && origins && !(occupied & bit(from + 2 * back)))
+                                double_push = bit(from + 2 * back);
+                            origins |= double_push;
+                        }
+                        else
+                            origins = piece_attacks((Piece_index) layout.type[p], from, occupied) & ~occupied;
+
+                        while (origins) {
+                            int origin = pop_lsb(origins);
+                            std::copy(squares, squares + layout.pieces, parent);
+                            parent[p] = origin;
+                            layout.set_position(pos, parent, mover);
+                            if (pos.attacked(pos.king_square(turn), mover))
+                                continue;                   // Side not to move in check, not a position
+                            uint64_t j = layout.index(parent, mover);
+                            if (get(j) != WDL_DRAW)
+                                continue;
+                            // A double push may give the other side an en passant capture, so that one is looked at in full. A parent
+                            // of a win with a move to a loss was settled by that loss (or will be, next level)
+                            Wdl r = (v == WDL_WIN) ? examine(pos, true) : (double_push & bit(origin)) ? examine(pos) : WDL_WIN;
+                            if (r != WDL_DRAW) {
+                                set(j, r);
+                                flag(j);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+    public:
+        Bitbase_generator(const Bitbase_layout& layout, const Bitbases& smaller, uint64_t* values, uint64_t* settled, uint64_t* next,
+                          int threads) : layout(layout), smaller(smaller), values(values), settled(settled), next(next),
+            threads(std::max(1, threads)), flagged(0) {}
+
+        // Returns levels run
+        int run() {
+            size_t bitmap_bytes = (layout.size + 63) / 64 * sizeof(uint64_t);
+            parallel([&](uint64_t first, uint64_t last) { first_pass(first, last); });
+            int levels = 0;
+            while (flagged.load()) {
+                std::swap(settled, next);
+                std::memset(next, 0, bitmap_bytes);
+                flagged = 0;
+                parallel([&](uint64_t first, uint64_t last) { level(first, last); });
+                levels++;
+            }
+            return levels;
+        }
+    };
+
+    // Materials one capture and / or promotion away, canonical, without trivial draws
+    static std::vector<Bitbase_material> successors(const Bitbase_material& m) {
+        std::vector<Bitbase_material> out;
+        auto add = [&](Bitbase_material s) {
+            if (!s.is_canonical())
+                s = s.flipped();
+            if (!s.is_trivial_draw() && std::find(out.begin(), out.end(), s) == out.end())
+                out.push_back(s);
+        };
+        const Piece_index PROMOTIONS[4] = {QUEEN, ROOK, BISHOP, KNIGHT};
+        for (int c = WHITE; c < Color::MAX; c++) {
+            for (int captured = PAWN; captured <= PIECE_MAX; captured++) {
+                if (captured == KING || (captured < PIECE_MAX && !m.count[1 - c][captured]))
+                    continue;
+                for (int promo = -1; promo < 4; promo++) {
+                    if (captured == PIECE_MAX && promo < 0)
+                        continue;                           // Neither
+                    if (promo >= 0 && (!m.count[c][PAWN] || captured == PAWN))
+                        continue;                           // No pawn to promote, or a promotion that takes a pawn
+                    Bitbase_material s = m;
+                    if (captured < PIECE_MAX)
+                        s.count[1 - c][captured]--;
+                    if (promo >= 0) {
+                        s.count[c][PAWN]--;
+                        s.count[c][PROMOTIONS[promo]]++;
+                    }
+                    add(s);
+                }
+            }
+        }
+        return out;
+    }
+
+    static bool generate(const Bitbase_material& m, const std::string& dir, const Bitbase_options& options) {
+        std::string path = bitbase_path(dir, m);
+        {
+            Bitbase existing;
+            if (m.is_trivial_draw() || existing.open(path, m) == MAPPED_WARM)
+                return true;
+        }
+        Bitbases smaller;
+        for (const Bitbase_material& s : successors(m))
+            if (!generate(s, dir, options) || smaller.load(dir, s.name()) != MAPPED_WARM)
+                return false;
+
+        auto start = std::chrono::steady_clock::now();
+        Bitbase_layout layout;
+        layout.init(m);
+        std::string name = m.name(), scratch = options.scratch_dir.empty() ? dir : options.scratch_dir;
+        std::string temp = path + ".tmp", settled_path = scratch + "/" + name + ".settled", next_path = scratch + "/" + name + ".next";
+        Mapped_file values, settled, next;
+        std::remove(temp.c_str());
+        std::remove(settled_path.c_str());
+        std::remove(next_path.c_str());
+        size_t bitmap_bytes = (layout.size + 63) / 64 * sizeof(uint64_t);
+        if (values.open(temp, BITBASE_FILE_KIND, file_salt(name), (layout.size + 31) / 32 * sizeof(uint64_t)) > MAPPED_CORRUPT)
+            return false;
+        bool ok = settled.open(settled_path, 0, 0, bitmap_bytes) <= MAPPED_CORRUPT && next.open(next_path, 0, 0, bitmap_bytes) <= MAPPED_CORRUPT;
+        int levels = 0;
+        if (ok) {
+            Bitbase_generator generator(layout, smaller, static_cast<uint64_t*>(values.payload()), static_cast<uint64_t*>(settled.payload()),
+                                        static_cast<uint64_t*>(next.payload()), options.threads);
+            levels = generator.run();
+        }
+        settled.close();
+        next.close();
+        std::remove(settled_path.c_str());
+        std::remove(next_path.c_str());
+
+        Bitbase_stats stats{name, 0, 0, 0, 0, levels, 0.0};
+        const uint64_t* v = static_cast<const uint64_t*>(values.payload());
+        for (uint64_t i = 0; ok && i < layout.size; i++) {
+            Wdl w = (Wdl) ((v[i >> 5] >> (2 * (i & 31))) & 3);
+            stats.wins += w == WDL_WIN;
+            stats.draws += w == WDL_DRAW;
+            stats.losses += w == WDL_LOSS;
+        }
+        stats.positions = stats.wins + stats.draws + stats.losses;
+        ok = values.close(stats.positions) && ok && std::rename(temp.c_str(), path.c_str()) == 0;
+        if (!ok) {
+            std::remove(temp.c_str());
+            return false;
+        }
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (options.on_table)
+            options.on_table(stats);
+        return true;
+    }
+}
+
+bool generate_bitbase(const std::string& material, const std::string& dir, const Bitbase_options& options) {
+    Bitbase_material m;
+    if (!m.parse(material) || m.men() < 2)
+        return false;
+    return chess_ns::generate(m.is_canonical() ? m : m.flipped(), dir, options);
+}
@@ -0,0 +1,169 @@
+#ifndef CHESS_BITBASE_H
+#define CHESS_BITBASE_H
+
+#include "chess_common.h"
+#include "chess_mapped.h"
+#include "chess_position.h"
+#include <functional>
+#include <map>
+#include <memory>
+
+// Endgame bitbases : win / draw / loss (side to move's point of view, with best play) of every position of a small material, up to
+// 5 men kings included. Two bits per position, stored in a Mapped_file (chess_mapped.h) and probed in place through the mapping.
+//
+// Index : side to move, then each piece's square in material order (white king, white pieces, black king, black pieces, queens
+// first). Symmetry folds the white king to a1-d1-d4 (8 board symmetries, pawnless) or to files a-d (mirror only, with pawns), and
+// pawns only take ranks 2-7. A position's index is the smallest one among its symmetric images, with identical pieces' squares
+// sorted : every other slot of the index space is marked illegal. Tables are stored for the stronger side as white, the other
+// way round is probed with colors swapped. Castling isn't covered ; en passant is, one ply deep, from the position without it.
+// The 50 move rule isn't taken into account (a win may take longer than that).
+//
+// Generation is retrograde, by levels : a first pass settles mates, stalemates and positions decided by a capture or promotion
+// (which lead into smaller tables, generated first), then each level un-moves from the positions settled by the previous one. A
+// parent of a loss is a win ; a parent of a win is re-examined, and lost if all of its moves now reach wins. Whatever is left
+// unsettled is a draw. Levels run on all threads, settled positions are flagged in two bitmaps (this level's, the next one's).
+// Table & bitmaps all live in mapped files, so a table bigger than RAM is paged by the OS rather than failing (slowly, parents
+// and children are scattered over the index space).
+
+constexpr int BITBASE_MAX_MEN = 5;
+
+typedef enum wdl {
+    WDL_DRAW,                           // Also "not settled yet" while generating
+    WDL_WIN,
+    WDL_LOSS,
+    WDL_ILLEGAL                         // Not a position (overlap, side not to move in check), or not the canonical slot of one
+} Wdl;
+
+// Side to move's result turned into the opponent's
+inline Wdl wdl_negate(Wdl v) {
+    return (v == WDL_WIN) ? WDL_LOSS : (v == WDL_LOSS) ? WDL_WIN : v;
+}
+
+// Pieces of each side, as in "KQKR" : white king & queen against black king & rook
+struct Bitbase_material {
+    uint8_t count[Color::MAX][PIECE_MAX];
+
+    Bitbase_material();
+
+    // Kings first on each side, "KRPKR". False if malformed, or more than BITBASE_MAX_MEN
+    bool parse(const std::string& name);
+
+    static Bitbase_material of(const Position& pos);
+
+    std::string name() const;
+
+    int men() const;
+
+    bool has_pawns() const;
+
+    // Colors swapped
+    Bitbase_material flipped() const;
+
+    // White is the stronger side (or both are the same) : the way tables are stored
+    bool is_canonical() const;
+
+    // Neither side can ever mate (lone kings, or one minor piece between them), draws without a table
+    bool is_trivial_draw() const;
+
+    // Distinct per material, for lookups (3 bits per count)
+    uint64_t key() const;
+
+    bool operator==(const Bitbase_material& other) const;
+};
+
+namespace chess_ns {
+    // Index space of one material
+    struct Bitbase_layout {
+        Bitbase_material material;
+        int pieces;
+        uint8_t color[BITBASE_MAX_MEN], type[BITBASE_MAX_MEN];
+        uint8_t group[BITBASE_MAX_MEN];         // First piece of the run of identical pieces this one belongs to
+        uint8_t domain[BITBASE_MAX_MEN];        // Squares each piece can take in the index
+        uint64_t size;                          // Slots, both sides to move
+
+        void init(const Bitbase_material& m);
+
+        // Canonical index of a position given by its squares (layout order, pieces must be on squares they can stand on)
+        uint64_t index(const int* squares, Color turn) const;
+
+        void decode(uint64_t index, int* squares, Color& turn) const;
+
+        // Squares of pos's pieces in layout order. flip : pos has the material with colors swapped, read it mirrored
+        void squares_of(const Position& pos, bool flip, int* squares) const;
+
+        void set_position(Position& pos, const int* squares, Color turn) const;
+    };
+}
+
+// One table, mapped read-only
+class Bitbase {
+    Mapped_file file;
+    chess_ns::Bitbase_layout layout;
+    const uint64_t* values;
+
+public:
+    Bitbase();
+
+    // verify = false skips the checksum pass, see Mapped_file::open_readonly()
+    Mapped_status open(const std::string& path, const Bitbase_material& material, bool verify = true);
+
+    const chess_ns::Bitbase_layout& index_layout() const {
+        return layout;
+    }
+
+    Wdl value(uint64_t index) const {
+        return (Wdl) ((values[index >> 5] >> (2 * (index & 31))) & 3);
+    }
+
+    // Position of this material or its flipped one, ignoring castling & en passant
+    Wdl probe(const Position& pos) const;
+};
+
+// Path of material's table in dir
+std::string bitbase_path(const std::string& dir, const Bitbase_material& material);
+
+// Set of tables the engine probes. Loaded once, then read-only (any number of threads can probe)
+class Bitbases {
+    std::map<uint64_t, std::unique_ptr<Bitbase>> tables;        // By canonical material key()
+    int men;
+
+public:
+    Bitbases();
+
+    // Opens dir's table for material (canonical or not) : anything but MAPPED_WARM leaves it out
+    Mapped_status load(const std::string& dir, const std::string& material, bool verify = true);
+
+    // Every table found in dir, returns how many
+    int load_dir(const std::string& dir, bool verify = true);
+
+    // Most men any loaded table has, 0 if none
+    int max_men() const {
+        return men;
+    }
+
+    // Value for the side to move. False if the position isn't covered : no table for its material (or for the one an en passant
+    // capture leads to), or castling rights left
+    bool probe(const Position& pos, Wdl& result) const;
+};
+
+struct Bitbase_stats {
+    std::string name;
+    uint64_t positions;                 // Legal & canonical
+    uint64_t wins, draws, losses;       // Side to move's
+    int levels;                         // Retrograde levels until nothing changed
+    double seconds;
+};
+
+struct Bitbase_options {
+    int threads;
+    std::string scratch_dir;            // Working bitmaps go there (mapped files, removed after), defaults to the output dir
+    std::function<void(const Bitbase_stats&)> on_table;        // After every table generated, dependencies included
+
+    Bitbase_options();
+};
+
+// Generates material's table into dir (bitbase_path()), after every smaller table it leads to by captures & promotions that isn't
+// there yet. Tables already in dir are kept. False on a malformed material or I/O failure
+bool generate_bitbase(const std::string& material, const std::string& dir, const Bitbase_options& options = Bitbase_options());
+
+#endif
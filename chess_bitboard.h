@@ -0,0 +1,395 @@
+#ifndef CHESS_BITBOARD_H
+#define CHESS_BITBOARD_H
+
+#include "chess_common.h"
+#include <cstdint>
+#include <array>
+#include <bit>
+#include <type_traits>
+
+// Bitboard helpers for the standard 8x8 board. Square index is rank * 8 + file, same orientation as board[rank][file] in Board,
+// i.e. square 0 is white's a1 and square 63 is black's h8. All tables are generated at compile time, nothing to initialize at startup.
+
+typedef uint64_t Bitboard;
+
+typedef enum piece_index {
+    PAWN,
+    KNIGHT,
+    BISHOP,
+    ROOK,
+    QUEEN,
+    KING,
+    PIECE_MAX           // Also used as the "empty cell" value in Position::cells
+} Piece_index;
+
+constexpr int SQUARE_MAX = 64;
+constexpr Bitboard FILE_A = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H = FILE_A << 7;
+constexpr Bitboard RANK_1 = 0xFFULL;
+constexpr Bitboard RANK_8 = RANK_1 << 56;
+
+// Shorthands as in Piece_type::shorthand (pawn has none)
+constexpr char PIECE_SHORTHAND[PIECE_MAX] = {'\0', 'N', 'B', 'R', 'Q', 'K'};
+
+constexpr int square(int rank, int file) {
+    return rank * 8 + file;
+}
+
+constexpr int rank_of(int sq) {
+    return sq >> 3;
+}
+
+constexpr int file_of(int sq) {
+    return sq & 7;
+}
+
+constexpr Bitboard bit(int sq) {
+    return 1ULL << sq;
+}
+
+inline int lsb(Bitboard b) {
+    return std::countr_zero(b);
+}
+
+inline int msb(Bitboard b) {
+    return 63 - std::countl_zero(b);
+}
+
+inline int pop_lsb(Bitboard& b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+inline int popcount(Bitboard b) {
+    return std::popcount(b);
+}
+
+inline Piece_index piece_index(char shorthand) {
+    for (int p = KNIGHT; p < PIECE_MAX; p++)
+        if (PIECE_SHORTHAND[p] == shorthand)
+            return (Piece_index) p;
+    return PIECE_MAX;
+}
+
+namespace chess_ns {
+    // 8 ray directions. First 4 go towards higher square indices (blocker found with lsb), last 4 towards lower ones (msb)
+    constexpr int RAY_STEP[8][2] = { {1,0}, {1,1}, {0,1}, {1,-1}, {-1,0}, {-1,-1}, {0,-1}, {-1,1} };   // {rank step, file step}
+    constexpr int ROOK_DIRS[4] = {0, 2, 4, 6};
+    constexpr int BISHOP_DIRS[4] = {1, 3, 5, 7};
+
+    constexpr Bitboard step_targets(int sq, const int (*steps)[2], int n) {
+        Bitboard b = 0;
+        for (int i = 0; i < n; i++) {
+            int r = rank_of(sq) + steps[i][0], f = file_of(sq) + steps[i][1];
+            if (r >= 0 && r < 8 && f >= 0 && f < 8)
+                b |= bit(square(r, f));
+        }
+        return b;
+    }
+
+    constexpr int KNIGHT_STEP[8][2] = { {1,2}, {2,1}, {2,-1}, {1,-2}, {-1,-2}, {-2,-1}, {-2,1}, {-1,2} };
+    constexpr int KING_STEP[8][2] = { {1,0}, {1,1}, {0,1}, {-1,1}, {-1,0}, {-1,-1}, {0,-1}, {1,-1} };
+    constexpr int PAWN_STEP[Color::MAX][2][2] = { { {1,-1}, {1,1} }, { {-1,-1}, {-1,1} } };
+
+    inline constexpr auto KNIGHT_ATTACKS = [] {
+        std::array<Bitboard, SQUARE_MAX> t{};
+        for (int sq = 0; sq < SQUARE_MAX; sq++) t[sq] = step_targets(sq, KNIGHT_STEP, 8);
+        return t;
+    }();
+
+    inline constexpr auto KING_ATTACKS = [] {
+        std::array<Bitboard, SQUARE_MAX> t{};
+        for (int sq = 0; sq < SQUARE_MAX; sq++) t[sq] = step_targets(sq, KING_STEP, 8);
+        return t;
+    }();
+
+    inline constexpr auto PAWN_ATTACKS = [] {
+        std::array<std::array<Bitboard, SQUARE_MAX>, Color::MAX> t{};
+        for (int c = 0; c < Color::MAX; c++)
+            for (int sq = 0; sq < SQUARE_MAX; sq++) t[c][sq] = step_targets(sq, PAWN_STEP[c], 2);
+        return t;
+    }();
+
+    // RAYS[dir][sq] = all squares from sq (exclusive) to the board edge in direction dir
+    inline constexpr auto RAYS = [] {
+        std::array<std::array<Bitboard, SQUARE_MAX>, 8> t{};
+        for (int d = 0; d < 8; d++)
+            for (int sq = 0; sq < SQUARE_MAX; sq++) {
+                int r = rank_of(sq) + RAY_STEP[d][0], f = file_of(sq) + RAY_STEP[d][1];
+                for (; r >= 0 && r < 8 && f >= 0 && f < 8; r += RAY_STEP[d][0], f += RAY_STEP[d][1])
+                    t[d][sq] |= bit(square(r, f));
+            }
+        return t;
+    }();
+
+    // BETWEEN[a][b] = squares strictly between a and b if they share a line, else 0. Used for pins and check blocking.
+    inline constexpr auto BETWEEN = [] {
+        std::array<std::array<Bitboard, SQUARE_MAX>, SQUARE_MAX> t{};
+        for (int a = 0; a < SQUARE_MAX; a++)
+            for (int d = 0; d < 8; d++) {
+                Bitboard path = 0;
+                int r = rank_of(a) + RAY_STEP[d][0], f = file_of(a) + RAY_STEP[d][1];
+                for (; r >= 0 && r < 8 && f >= 0 && f < 8; r += RAY_STEP[d][0], f += RAY_STEP[d][1]) {
+                    t[a][square(r, f)] = path;
+                    path |= bit(square(r, f));
+                }
+            }
+        return t;
+    }();
+
+    inline Bitboard ray_attacks(int sq, int dir, Bitboard occ) {
+        Bitboard attacks = RAYS[dir][sq];
+        Bitboard blockers = attacks & occ;
+        if (blockers)
+            attacks ^= RAYS[dir][(dir < 4) ? lsb(blockers) : msb(blockers)];
+        return attacks;
+    }
+}
+
+inline Bitboard knight_attacks(int sq) {
+    return chess_ns::KNIGHT_ATTACKS[sq];
+}
+
+inline Bitboard king_attacks(int sq) {
+    return chess_ns::KING_ATTACKS[sq];
+}
+
+inline Bitboard pawn_attacks(Color c, int sq) {
+    return chess_ns::PAWN_ATTACKS[c][sq];
+}
+
+inline Bitboard rook_attacks(int sq, Bitboard occ) {
+    return chess_ns::ray_attacks(sq, 0, occ) | chess_ns::ray_attacks(sq, 2, occ) |
+           chess_ns::ray_attacks(sq, 4, occ) | chess_ns::ray_attacks(sq, 6, occ);
+}
+
+inline Bitboard bishop_attacks(int sq, Bitboard occ) {
+    return chess_ns::ray_attacks(sq, 1, occ) | chess_ns::ray_attacks(sq, 3, occ) |
+           chess_ns::ray_attacks(sq, 5, occ) | chess_ns::ray_attacks(sq, 7, occ);
+}
+
+inline Bitboard between(int a, int b) {
+    return chess_ns::BETWEEN[a][b];
+}
+
+// Attack set of a non-pawn piece standing on sq
+inline Bitboard piece_attacks(Piece_index p, int sq, Bitboard occ) {
+    switch (p) {
+        case KNIGHT: return knight_attacks(sq);
+        case BISHOP: return bishop_attacks(sq, occ);
+        case ROOK:   return rook_attacks(sq, occ);
+        case QUEEN:  return rook_attacks(sq, occ) | bishop_attacks(sq, occ);
+        case KING:   return king_attacks(sq);
+        default:     return 0;
+    }
+}
+
+// ------------------------------------------------------------------- Bitboards for other grid sizes ----------------------------------------------------------------
+
+constexpr int MIN_GRID_SIZE = 6;            // Castling needs rooks on both sides of the king's default file (King::file_offset_default)
+constexpr int MAX_GRID_SIZE = 16;           // Files are single letters a-p in SAN, and 16 x 16 cells still fit in 256 bits
+
+namespace chess_ns {
+    // GCC / Clang vector types (vector_size can't depend on a template parameter, hence one typedef per width)
+    typedef uint64_t Lanes_128 __attribute__((vector_size(16)));
+    typedef uint64_t Lanes_256 __attribute__((vector_size(32)));
+
+    template<int W> struct Lanes;
+    template<> struct Lanes<2> { typedef Lanes_128 type; };
+    template<> struct Lanes<4> { typedef Lanes_256 type; };
+}
+
+// Bitboard wider than 64 bits, for grids above 8x8. W lanes of 64 bits (lane 0 = squares 0-63), held in a vector type so that
+// and / or / xor / not compile to single SSE / AVX / NEON instructions. Shifts carry bits from lane to lane.
+template<int W>
+struct Wide_bitboard {
+    typedef typename chess_ns::Lanes<W>::type Lanes;
+    Lanes v;
+
+    Wide_bitboard() : v{} {}
+
+    static Wide_bitboard bit(int sq) {
+        Wide_bitboard b;
+        b.v[sq >> 6] = 1ULL << (sq & 63);
+        return b;
+    }
+
+    explicit operator bool() const {
+        uint64_t any = 0;
+        for (int i = 0; i < W; i++)
+            any |= v[i];
+        return any != 0;
+    }
+
+    bool operator==(const Wide_bitboard& other) const {
+        return !(*this ^ other);
+    }
+
+    Wide_bitboard operator&(const Wide_bitboard& other) const { Wide_bitboard b; b.v = v & other.v; return b; }
+    Wide_bitboard operator|(const Wide_bitboard& other) const { Wide_bitboard b; b.v = v | other.v; return b; }
+    Wide_bitboard operator^(const Wide_bitboard& other) const { Wide_bitboard b; b.v = v ^ other.v; return b; }
+    Wide_bitboard operator~() const { Wide_bitboard b; b.v = ~v; return b; }
+    Wide_bitboard& operator&=(const Wide_bitboard& other) { v &= other.v; return *this; }
+    Wide_bitboard& operator|=(const Wide_bitboard& other) { v |= other.v; return *this; }
+    Wide_bitboard& operator^=(const Wide_bitboard& other) { v ^= other.v; return *this; }
+
+    // Shift by 0 < s < 64 (one rank is at most 16 squares, so that's all board shifts ever need)
+    Wide_bitboard operator<<(int s) const {
+        Wide_bitboard b;
+        b.v = v << s;
+        for (int i = W - 1; i > 0; i--)
+            b.v[i] |= v[i - 1] >> (64 - s);
+        return b;
+    }
+
+    Wide_bitboard operator>>(int s) const {
+        Wide_bitboard b;
+        b.v = v >> s;
+        for (int i = 0; i < W - 1; i++)
+            b.v[i] |= v[i + 1] << (64 - s);
+        return b;
+    }
+};
+
+template<int W>
+inline int popcount(const Wide_bitboard<W>& b) {
+    int n = 0;
+    for (int i = 0; i < W; i++)
+        n += std::popcount(b.v[i]);
+    return n;
+}
+
+template<int W>
+inline int lsb(const Wide_bitboard<W>& b) {
+    for (int i = 0; i < W; i++)
+        if (b.v[i])
+            return i * 64 + std::countr_zero(b.v[i]);
+    return W * 64;
+}
+
+template<int W>
+inline int pop_lsb(Wide_bitboard<W>& b) {
+    for (int i = 0; i < W; i++) {
+        if (b.v[i]) {
+            int sq = i * 64 + std::countr_zero(b.v[i]);
+            b.v[i] &= b.v[i] - 1;
+            return sq;
+        }
+    }
+    return W * 64;
+}
+
+// Compile-time description of an N x N grid : square indexing (rank * N + file, like the 8x8 helpers above) and its bitboard type.
+// 8x8 and below get the plain 64-bit Bitboard, so the standard board pays nothing for the other sizes ; up to 11x11 fit in 128 bits,
+// up to 16x16 in 256.
+template<int N>
+struct Grid {
+    static_assert(N >= 1 && N <= MAX_GRID_SIZE, "Grid size out of range");
+
+    static constexpr int SIZE = N;
+    static constexpr int CELLS = N * N;
+    typedef std::conditional_t<(CELLS <= 64), Bitboard, Wide_bitboard<(CELLS <= 128) ? 2 : 4>> Bits;
+
+    static constexpr int square(int rank, int file) {
+        return rank * N + file;
+    }
+
+    static constexpr bool on_board(int rank, int file) {
+        return (unsigned) rank < (unsigned) N && (unsigned) file < (unsigned) N;
+    }
+
+    static Bits bit(int sq) {
+        if constexpr (CELLS <= 64)
+            return 1ULL << sq;
+        else
+            return Bits::bit(sq);
+    }
+
+    static Bits make_file_mask(int file) {
+        Bits b{};
+        for (int rank = 0; rank < N; rank++)
+            b |= bit(square(rank, file));
+        return b;
+    }
+
+    static Bits make_rank_mask(int rank) {
+        Bits b{};
+        for (int file = 0; file < N; file++)
+            b |= bit(square(rank, file));
+        return b;
+    }
+
+    static Bits all_cells() {
+        Bits b{};
+        for (int sq = 0; sq < CELLS; sq++)
+            b |= bit(sq);
+        return b;
+    }
+
+    static inline const Bits ALL = all_cells();
+    static inline const Bits NOT_FIRST_FILE = all_cells() & ~make_file_mask(0);
+    static inline const Bits NOT_LAST_FILE = all_cells() & ~make_file_mask(N - 1);
+
+    // Every file / rank, built once per N. (Members above don't read these : static members of a class template have no defined
+    // initialization order, so each one is built from the loops directly.)
+    static inline const std::array<Bits, N> FILES = [] {
+        std::array<Bits, N> t;
+        for (int i = 0; i < N; i++) t[i] = make_file_mask(i);
+        return t;
+    }();
+    static inline const std::array<Bits, N> RANKS = [] {
+        std::array<Bits, N> t;
+        for (int i = 0; i < N; i++) t[i] = make_rank_mask(i);
+        return t;
+    }();
+
+    static const Bits& file_mask(int file) {
+        return FILES[file];
+    }
+
+    static const Bits& rank_mask(int rank) {
+        return RANKS[rank];
+    }
+
+    // One step towards higher ranks / lower ranks / higher files / lower files, dropping what falls off the board
+    static Bits north(const Bits& b) {
+        return (b << N) & ALL;
+    }
+
+    static Bits south(const Bits& b) {
+        return b >> N;
+    }
+
+    static Bits east(const Bits& b) {
+        return (b << 1) & NOT_FIRST_FILE;
+    }
+
+    static Bits west(const Bits& b) {
+        return (b >> 1) & NOT_LAST_FILE;
+    }
+};
+
+// ------------------------------------------------------------------------------ Pawn keys ------------------------------------------------------------------------------
+
+namespace chess_ns {
+    constexpr uint64_t splitmix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Zobrist keys of pawns only, indexed by Grid<N>::square() (so rank * N + file, i.e. the plain square on 8x8). Board<N> and
+    // Position both keep a pawn key from this one table, so for standard chess the two agree. Separate seed from ZOBRIST
+    inline constexpr std::array<std::array<uint64_t, MAX_GRID_SIZE * MAX_GRID_SIZE>, Color::MAX> PAWN_ZOBRIST = [] {
+        std::array<std::array<uint64_t, MAX_GRID_SIZE * MAX_GRID_SIZE>, Color::MAX> z{};
+        uint64_t state = 0x7A3C5E1F9B2D4C68ULL;
+        for (int c = 0; c < Color::MAX; c++)
+            for (int sq = 0; sq < MAX_GRID_SIZE * MAX_GRID_SIZE; sq++)
+                z[c][sq] = splitmix64(state);
+        return z;
+    }();
+}
+
+#endif
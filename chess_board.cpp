@@ -1,12 +1,14 @@
 
 #include "chess_utils.h"
 #include "chess_board.h"
+#include "chess_stats.h"
 #include <iostream>
 
 
 // ----------------------------------------------------------------------------- Piece Info -------------------------------------------------------------------------------------
 
-Piece::Piece() {
+template<int N>
+Piece<N>::Piece() {
     type = nullptr;
     color = Color::MAX;
     pos = {-1,-1};
@@ -14,7 +16,8 @@ Piece::Piece() {
     move_count = 0;
 }
 
-Piece::Piece(Piece_type* type, Color color, std::pair<int,int> pos, Board* board) {
+template<int N>
+Piece<N>::Piece(Piece_type* type, Color color, std::pair<int,int> pos, Board<N>* board) {
     this->type = type;
     this->color = color;
     this->pos = pos;
@@ -22,21 +25,25 @@ Piece::Piece(Piece_type* type, Color color, std::pair<int,int> pos, Board* board
     move_count = 0;
 }
 
-int Piece::rank() {
+template<int N>
+int Piece<N>::rank() {
     return pos.first;
 }
 
-int Piece::file() {
+template<int N>
+int Piece<N>::file() {
     return pos.second;
 }
 
-int& Piece::id() {
+template<int N>
+int& Piece<N>::id() {
     return u_id;
 }
 
 // -------------------------------- Wrapper class for Piece Pointer -----------------------------------
 
-Piece_ptr::Piece_ptr() : piece_ptr(nullptr) {
+template<int N>
+Piece_ptr<N>::Piece_ptr() : piece_ptr(nullptr) {
     // std::cout << "DEFAULT CONSTRUCT" << std::endl;
 }
 
@@ -48,7 +55,8 @@ Piece_ptr::Piece_ptr() : piece_ptr(nullptr) {
 // And of course new pieces added to board via construction/assignment, or pieces REMOVED (not captured), also need the same.
 // Should have Destructor as well!
 
-Piece_ptr::Piece_ptr(Piece* piece_ptr) : piece_ptr(piece_ptr) {
+template<int N>
+Piece_ptr<N>::Piece_ptr(Piece<N>* piece_ptr) : piece_ptr(piece_ptr) {
     // std::cout << "Piece* CONSTRUCT : ";
     if (piece_ptr && piece_ptr->board)
         piece_ptr->board->process_inp(*this);
@@ -56,11 +64,13 @@ Piece_ptr::Piece_ptr(Piece* piece_ptr) : piece_ptr(piece_ptr) {
     //     std::cout << "NOT PROCESSED" << std::endl;
 }
 
-Piece_ptr::Piece_ptr(std::nullptr_t null) : piece_ptr(null) {
+template<int N>
+Piece_ptr<N>::Piece_ptr(std::nullptr_t null) : piece_ptr(null) {
     // std::cout << "NULL CONSTRUCT" << std::endl;
 }
 
-Piece_ptr::Piece_ptr(const Piece_ptr& other) : piece_ptr(other.piece_ptr) {
+template<int N>
+Piece_ptr<N>::Piece_ptr(const Piece_ptr& other) : piece_ptr(other.piece_ptr) {
     // std::cout << "COPY CONSTRUCT : ";
     if (piece_ptr && piece_ptr->board)
         piece_ptr->board->process_inp(*this);
@@ -68,7 +78,8 @@ Piece_ptr::Piece_ptr(const Piece_ptr& other) : piece_ptr(other.piece_ptr) {
     //     std::cout << "NOT PROCESSED" << std::endl;
 }
 
-Piece_ptr::Piece_ptr(Piece_ptr&& other) noexcept : 
+template<int N>
+Piece_ptr<N>::Piece_ptr(Piece_ptr&& other) noexcept : 
     piece_ptr(std::exchange(other.piece_ptr, nullptr)) {
     // std::cout << "MOVE CONSTRUCT : ";
     if (piece_ptr && piece_ptr->board)
@@ -77,7 +88,8 @@ Piece_ptr::Piece_ptr(Piece_ptr&& other) noexcept :
     //     std::cout << "NOT PROCESSED" << std::endl;
 }
 
-void Piece_ptr::operator=(Piece* other) {
+template<int N>
+void Piece_ptr<N>::operator=(Piece<N>* other) {
     // std::cout << "Piece* ASSIGN : ";
     piece_ptr = other;
     if (piece_ptr && piece_ptr->board)
@@ -86,7 +98,8 @@ void Piece_ptr::operator=(Piece* other) {
     //     std::cout << "NOT PROCESSED" << std::endl;
 }
 
-void Piece_ptr::operator=(const Piece_ptr& other) {
+template<int N>
+void Piece_ptr<N>::operator=(const Piece_ptr& other) {
     // std::cout << "COPY ASSIGN : ";       // No move assign, not sure if it would be used if present
     piece_ptr = other.piece_ptr;
     if (piece_ptr && piece_ptr->board)
@@ -95,27 +108,33 @@ void Piece_ptr::operator=(const Piece_ptr& other) {
     //     std::cout << "NOT PROCESSED" << std::endl;
 }
 
-Piece* Piece_ptr::operator->() {
+template<int N>
+Piece<N>* Piece_ptr<N>::operator->() const {
     return piece_ptr;
 }
 
-Piece& Piece_ptr::operator*() {
+template<int N>
+Piece<N>& Piece_ptr<N>::operator*() const {
     return *piece_ptr;
 }
 
-bool Piece_ptr::operator==(const Piece*& other) {
+template<int N>
+bool Piece_ptr<N>::operator==(const Piece<N>*& other) {
     return piece_ptr == other;
 }
 
-bool Piece_ptr::operator==(const Piece_ptr& other) {
+template<int N>
+bool Piece_ptr<N>::operator==(const Piece_ptr& other) {
     return piece_ptr == other.piece_ptr;
 }
 
-bool Piece_ptr::operator!=(const Piece*& other) {
+template<int N>
+bool Piece_ptr<N>::operator!=(const Piece<N>*& other) {
     return piece_ptr != other;
 }
 
-bool Piece_ptr::operator!=(const Piece_ptr& other) {
+template<int N>
+bool Piece_ptr<N>::operator!=(const Piece_ptr& other) {
     return piece_ptr != other.piece_ptr;
 }
 
@@ -124,9 +143,34 @@ bool Piece_ptr::operator!=(const Piece_ptr& other) {
 
 // _Move is hidden implementation of Move wrapper. 
 // Why we need separate class: The type PType_set is only available to use in src files, and not headers
+template<int N>
 class _Move {
     PType_set& piece_types;
-    int game_grid_size;
+
+    // Longest valid move string. Example Max case for pawn - cxd8=Q+ ; Max case for other piece - Nc3xd5+, either way 7.... O-O-O+ is 6.
+    // From 10x10 on, ranks take 2 digits and both the src & dst rank can be 2 digits : Nc10xd12+ is 9
+    static constexpr int MAX_LENGTH = (N >= 10) ? 9 : 7;
+
+    // Read a rank number (1 to N, one or two digits) off the end of str, and return it 0-based. Returns N if there are no digits at the
+    // end (unspecified), -1 if the number is not a rank of this board (leading zero included)
+    static int pop_rank(std::string& str) {
+        constexpr int MAX_DIGITS = (N >= 10) ? 2 : 1;
+        int digits = 0, size = str.size();
+        while (digits < size && digits < MAX_DIGITS && std::isdigit(str[size - 1 - digits]))
+            digits++;
+        if (digits == 0)
+            return N;
+        if (digits < size && std::isdigit(str[size - 1 - digits]))
+            return -1;                                          // Too many digits
+        if (str[size - digits] == '0')
+            return -1;
+        int rank = 0;
+        for (int i = size - digits; i < size; i++)
+            rank = rank * 10 + (str[i] - '0');
+        str.resize(size - digits);
+        return (rank <= N) ? rank - 1 : -1;
+    }
+
 public:
     std::string move;
     
@@ -142,28 +186,14 @@ public:
 
     Piece_type* promo_type;         // For pawn, if promotion, what piece promoted to. ptype and promo_type cannot both be non-null!
 
-    std::pair<int,int> src;         // {rank/row, file/col} ; Optional - {_,_} if info present, else, {grid_size,grid_size}/{_,gs}/{gs,_} ... _ is 0-(gs-1)
-    std::pair<int,int> dst;         // {rank/row, file/col} ; Mandatory - {0-(gs-1),0-(gs-1)} 
+    std::pair<int,int> src;         // {rank/row, file/col} ; Optional - {_,_} if info present, else, {N,N}/{_,N}/{N,_} ... _ is 0-(N-1)
+    std::pair<int,int> dst;         // {rank/row, file/col} ; Mandatory - {0-(N-1),0-(N-1)} 
 
     _Move(PType_set& piece_types) : piece_types(piece_types) {
-        game_grid_size = 8;
         reset();
     }
 
     _Move(std::string& move, PType_set& piece_types) : piece_types(piece_types)  {
-        game_grid_size = 8;
-        reset();
-        this->move = move;
-        parse_move();
-    }
-
-    _Move(PType_set& piece_types, int game_grid_size) : piece_types(piece_types) {
-        this->game_grid_size = game_grid_size;
-        reset();
-    }
-
-    _Move(std::string& move, PType_set& piece_types, int game_grid_size) : piece_types(piece_types)  {
-        this->game_grid_size = game_grid_size;
         reset();
         this->move = move;
         parse_move();
@@ -175,8 +205,8 @@ public:
         castle_type = CASTLE_MAX;
         is_check = false;
         is_capture = false;
-        src = {game_grid_size, game_grid_size};
-        dst = {game_grid_size, game_grid_size};
+        src = {N, N};
+        dst = {N, N};
         ptype = nullptr;
         promo_type = nullptr;
     }
@@ -213,9 +243,8 @@ public:
         return move[i];
     }
 
-    // TODO : Fix - Currently this has a bug, if grid size >= 10 (because it assumes rank takes one char/single digit). 
-    // Fix later - Just check 2 chars (will allow max 26 for consistency)
     void parse_move() {
+        CHESS_STAT_TIMER(STAT_PARSE_MOVE);
         std::string move = this->move;
         // Following are valid prefixes :
         // 1. O-O or O-O-O
@@ -225,9 +254,8 @@ public:
         //    Promo info - =?(Piece_type)? Optional (present if it's a pawn and it promotes)
         // Valid suffix : Either + or # or nothing.
         
-        // Example Max case for pawn - cxd8=Q+ ; Max case for other piece - Nc3xd5+, either way 7.... O-O-O+ is 6.
-        // Min size is 2 chars - Dst info. Enforcing both min/max
-        if (move.size() < 2 || move.size() > 7) return;
+        // Min size is 2 chars - Dst info. Enforcing both min/max (see MAX_LENGTH)
+        if (move.size() < 2 || move.size() > MAX_LENGTH) return;
         // Check for check/mate suffix
         if (move.back() == '+' || move.back() == '#') {
             move.pop_back();
@@ -262,12 +290,12 @@ public:
                 return;
         }
     
-        // Look for valid dst cell at end (mandatory)
-        int dst_rank = (int) move.back() - (int) '1'; move.pop_back();
-        int dst_file = (int) move.back() - (int) 'a'; move.pop_back();
-        if (dst_rank < 0 || dst_rank >= game_grid_size)
+        // Look for valid dst cell at end (mandatory). Rank may be 2 digits on big boards, file is always a single letter
+        int dst_rank = pop_rank(move);
+        if (dst_rank < 0 || dst_rank >= N || move.empty())
             return;
-        if (dst_file < 0 || dst_file >= game_grid_size)
+        int dst_file = (int) move.back() - (int) 'a'; move.pop_back();
+        if (dst_file < 0 || dst_file >= N)
             return;
         dst = {dst_rank, dst_file};
     
@@ -286,20 +314,16 @@ public:
         // Only P? src_file? src_rank? shoule be left. But at least one char must be present (file/P), only dst pawn move already handled
         if (move.empty())
             return;
-        int src_rank = game_grid_size;               // Default invalid / unspecified rank
-        if (isdigit(move.back())) {
-            src_rank = (int) move.back() - (int) '1';
-            if (src_rank < 0 || src_rank >= game_grid_size)
-                return;
-            move.pop_back();
-        }
+        int src_rank = pop_rank(move);              // N (default invalid / unspecified rank) if not given
+        if (src_rank < 0)
+            return;
         // Only P? src_file? shoule be left. But at least one char must be present (file/P)
         if (move.empty())
             return;
-        int src_file = game_grid_size;               // Default invalid / unspecified file
+        int src_file = N;                           // Default invalid / unspecified file
         if (islower(move.back())) {
             src_file = (int) move.back() - (int) 'a';
-            if (src_file < 0 || src_file >= game_grid_size)
+            if (src_file < 0 || src_file >= N)
                 return;
             move.pop_back();
         }
@@ -310,7 +334,7 @@ public:
             // For non-capture pawn move, src part should ALWAYS be empty in standard notation (as per chess.com article)
             // If non-capture reached here => either file/rank/both info was given in src part, so should reject it. ONLY allowing captures here
             // Even in capture, only file should be given and rank should be unspecified/empty as well in SAN (again as per article)
-            if (is_capture && src_rank == game_grid_size && src_file != game_grid_size)
+            if (is_capture && src_rank == N && src_file != N)
                 is_valid = true;
             return;
         }
@@ -327,161 +351,202 @@ public:
     }
 };
 
-void operator>>(std::istream& cin, _Move& move) {
+template<int N>
+void operator>>(std::istream& cin, _Move<N>& move) {
     move.reset();
     cin >> move.move;
     // If we want to allow chaining istream like std::cin >> move >> var2 >> var3 >> ..., we should return cin back
     move.parse_move();
 }
 
-bool operator==(const std::string& other, _Move& move) {
+template<int N>
+bool operator==(const std::string& other, _Move<N>& move) {
     return move.move == other;
 }
 
 // ------------------------------------------- Move : Wrapper around _Move ---------------------------------------------
 
-Move::Move(void* piece_types_ptr) {
-    _move = new _Move(*((PType_set*) piece_types_ptr));
-}
-
-Move::Move(std::string& move, void* piece_types_ptr) {
-    _move = new _Move(move, *((PType_set*) piece_types_ptr));
-}
-
-Move::Move(void* piece_types_ptr, int game_grid_size) {
-    _move = new _Move(*((PType_set*) piece_types_ptr), game_grid_size);
+template<int N>
+Move<N>::Move(void* piece_types_ptr) {
+    _move = new _Move<N>(*((PType_set*) piece_types_ptr));
 }
 
-Move::Move(std::string& move, void* piece_types_ptr, int game_grid_size)  {
-    _move = new _Move(move, *((PType_set*) piece_types_ptr), game_grid_size);
+template<int N>
+Move<N>::Move(std::string& move, void* piece_types_ptr) {
+    _move = new _Move<N>(move, *((PType_set*) piece_types_ptr));
 }
 
-Move::~Move() {
+template<int N>
+Move<N>::~Move() {
     delete _move;
 }
 
-void Move::reset() {
+template<int N>
+void Move<N>::reset() {
     _move->reset();
 }
 
-bool Move::operator==(const Move& other) {
+template<int N>
+bool Move<N>::operator==(const Move& other) {
     return *_move == *(other._move);
 }
 
-bool Move::operator!=(const Move& other) {
+template<int N>
+bool Move<N>::operator!=(const Move& other) {
     return *_move != *(other._move);
 }
 
-bool Move::operator==(const std::string& other) {
+template<int N>
+bool Move<N>::operator==(const std::string& other) {
     return *_move == other;
 }
 
-bool Move::operator!=(const std::string& other) {
+template<int N>
+bool Move<N>::operator!=(const std::string& other) {
     return *_move != other;
 }
 
-void Move::operator=(const Move& other) {
+template<int N>
+void Move<N>::operator=(const Move& other) {
     *_move = *(other._move);
 }
 
-void Move::operator=(const std::string& other) {
+template<int N>
+void Move<N>::operator=(const std::string& other) {
     *_move = other;
 }
 
-char Move::operator[](int i) {
+template<int N>
+char Move<N>::operator[](int i) {
     return (*_move)[i];
 }
 
-bool Move::is_valid() {
+template<int N>
+bool Move<N>::is_valid() {
     return _move->is_valid;
 }
 
-bool Move::is_check() {
+template<int N>
+bool Move<N>::is_check() {
     return _move->is_check;
 }
 
-bool Move::is_capture() {
+template<int N>
+bool Move<N>::is_capture() {
     return _move->is_capture;
 }
 
-Castle_type Move::castle_type() {
+template<int N>
+Castle_type Move<N>::castle_type() {
     return _move->castle_type;
 }
 
-Piece_type* Move::piece_type() {
+template<int N>
+Piece_type* Move<N>::piece_type() {
     return _move->ptype;
 }
 
-Piece_type* Move::promo_type() {
+template<int N>
+Piece_type* Move<N>::promo_type() {
     return _move->promo_type;
 }
 
-std::pair<int,int> Move::src() {
+template<int N>
+std::pair<int,int> Move<N>::src() {
     return _move->src;
 }
 
-std::pair<int,int> Move::dst() {
+template<int N>
+std::pair<int,int> Move<N>::dst() {
     return _move->dst;
 }
 
-void operator>>(std::istream& cin, Move& move) {
+template<int N>
+void operator>>(std::istream& cin, Move<N>& move) {
     cin >> *(move._move);
 }
 
-bool operator==(const std::string& other, Move& move) {
+template<int N>
+bool operator==(const std::string& other, Move<N>& move) {
     return other == *(move._move);
 }
 
-bool operator!=(const std::string& other, Move& move) {
+template<int N>
+bool operator!=(const std::string& other, Move<N>& move) {
     return other != *(move._move);
 }
 
 
 // ----------------------------------------------------------------------------- Board Info ------------------------------------------------------------------------------------------
 
-Board::Row_reference::Row_reference(std::vector<Piece_ptr>& row) : row(row) {}
+template<int N>
+Board<N>::Row_reference::Row_reference(Row& row) : row(row) {}
 
-Piece_ptr& Board::Row_reference::operator[](int i) {
-    static Piece_ptr null; null = nullptr;
-    if (i < 0 || i >= row.size()) return null;
+template<int N>
+Piece_ptr<N>& Board<N>::Row_reference::operator[](int i) {
+    if ((unsigned) i >= (unsigned) N) {                     // Also catches i < 0
+        static Piece_ptr<N> null; null = nullptr;
+        return null;
+    }
     return row[i];
 }
 
-Board::Board() : Board(8) {}
-
-Board::Board(int grid_size) : Board(grid_size, 0, grid_size-1, grid_size-1, grid_size-3, 0, 3) {}
+template<int N>
+Board<N>::Board() : Board(0) {}
 
-// (grid_size-1, grid_size-3, 0, 3) above (^) and below (v) --> Offset-independent castling
+// (N-1, N-3, 0, 3) below (v) --> Offset-independent castling
 // Enforce specific rook ABSOLUTE positions only where castling is allowed
 
-Board::Board(int grid_size, int piece_rank_offset) : Board(grid_size, piece_rank_offset, grid_size-1-piece_rank_offset, grid_size-1, grid_size-3, 0, 3) {}
+template<int N>
+Board<N>::Board(int piece_rank_offset) : Board(piece_rank_offset, N-1-piece_rank_offset, N-1, N-3, 0, 3) {}
 
-Board::Board(int grid_size, int piece_rank_offset, int promo_rank_offset, int pre_short, int post_short, int pre_long, int post_long) {
-    board = std::vector<std::vector<Piece_ptr>> (grid_size, std::vector<Piece_ptr> (grid_size, nullptr));
+template<int N>
+Board<N>::Board(int piece_rank_offset, int promo_rank_offset, int pre_short, int post_short, int pre_long, int post_long) : occupied{}, pawns{}, pawn_key(0) {
     piece_ranks[WHITE] = piece_rank_offset;
-    piece_ranks[BLACK] = grid_size - 1 - piece_rank_offset;
+    piece_ranks[BLACK] = N - 1 - piece_rank_offset;
     promo_ranks[WHITE] = promo_rank_offset;
-    promo_ranks[BLACK] = grid_size - 1 - promo_rank_offset;
+    promo_ranks[BLACK] = N - 1 - promo_rank_offset;
     rook_pos_precastle[SHORT] = pre_short;
     rook_pos_precastle[LONG] = pre_long;
     rook_pos_postcastle[SHORT] = post_short;   // Kingside / Short
     rook_pos_postcastle[LONG] = post_long;     // Queenside / Long
 }
 
-Board::Row_reference Board::operator[](int i) {
-    static std::vector<Piece_ptr> empty; empty.clear();
-    if (i < 0 || i >= board.size()) return Row_reference(empty);
+template<int N>
+typename Board<N>::Row_reference Board<N>::operator[](int i) {
+    if ((unsigned) i >= (unsigned) N) {
+        static Row empty; empty.fill(nullptr);         // Writes to an off-board row land here, and are wiped on next access
+        return Row_reference(empty);
+    }
     return Row_reference(board[i]);
 }
 
-bool Board::validate() {
+template<int N>
+void Board<N>::vacate(int rank, int file) {
+    if (!Grid<N>::on_board(rank, file))
+        return;
+    board[rank][file] = nullptr;
+    int sq = Grid<N>::square(rank, file);
+    Bits keep = ~Grid<N>::bit(sq);
+    occupied[WHITE] &= keep;
+    occupied[BLACK] &= keep;
+    for (int c = WHITE; c < Color::MAX; c++) {
+        if (pawns[c] & ~keep)
+            pawn_key ^= chess_ns::PAWN_ZOBRIST[c][sq];
+        pawns[c] &= keep;
+    }
+}
+
+template<int N>
+bool Board<N>::validate() {
     return true;
 }
 
-void Board::remove_castle_at(int rank, int file) {
+template<int N>
+void Board<N>::remove_castle_at(int rank, int file) {
     if ((*this)[rank][file] == nullptr)
         return;
-    Piece_ptr p_ptr = board[rank][file];
+    Piece_ptr<N> p_ptr = board[rank][file];
     if (rank == piece_ranks[p_ptr->color]) {
         if (p_ptr->type->shorthand == 'R' && (file == rook_pos_precastle[SHORT] || file == rook_pos_precastle[LONG]))
             can_castle[p_ptr->color][(file == rook_pos_precastle[LONG])] = false;
@@ -491,12 +556,25 @@ void Board::remove_castle_at(int rank, int file) {
     }
 }
 
-void Board::process_inp(const Piece_ptr& piece_ptr) {
+template<int N>
+void Board<N>::process_inp(const Piece_ptr<N>& piece_ptr) {
     // std::cout << "PROCESSED" << std::endl;
     // If piece was just added, move_count == 0, check certain things.
+    Piece<N>& piece = *piece_ptr;
+    if (piece.color < Color::MAX && Grid<N>::on_board(piece.rank(), piece.file())) {
+        int sq = Grid<N>::square(piece.rank(), piece.file());
+        Bits cell = Grid<N>::bit(sq);
+        occupied[piece.color] |= cell;
+        if (piece.type->shorthand == (char) NULL && !(pawns[piece.color] & cell)) {     // Pawn, see Pawn in chess_piece.h
+            pawns[piece.color] |= cell;
+            pawn_key ^= chess_ns::PAWN_ZOBRIST[piece.color][sq];
+        }
+    }
 }
 
-bool Board::castle(Color& player_color, Move& move) {
+template<int N>
+bool Board<N>::castle(Color& player_color, Move<N>& move) {
+    CHESS_STAT_TIMER(STAT_CASTLE);
     if (!can_castle[player_color][move.castle_type()])
         return false;
     
@@ -516,11 +594,46 @@ bool Board::castle(Color& player_color, Move& move) {
     return true;
 }
 
-bool Board::move_pawn(Color& player_color, Move& move) {
-    return true;
+// No per-pawn loop : the destination is shifted back the way pawns come (one / two steps back for pushes, diagonally back for captures)
+// and intersected with all of the player's pawns at once. The move is valid if exactly one pawn is left (capture source file narrows
+// it down). En passant isn't possible here, the board keeps no last-move state. File / rank masks come from Grid's per-N tables.
+template<int N>
+bool Board<N>::valid_pawn_move(Color& player_color, Move<N>& move) {
+    typedef Grid<N> G;
+    auto [dst_rank, dst_file] = move.dst();
+    auto [src_rank, src_file] = move.src();
+    bool white = (player_color == WHITE);
+    auto back = [white](const Bits& b) { return white ? G::south(b) : G::north(b); };
+
+    // Promotion piece given if and only if reaching the promotion rank
+    if ((dst_rank == promo_ranks[player_color]) != (move.promo_type() != nullptr))
+        return false;
+
+    Bits dst = G::bit(G::square(dst_rank, dst_file));
+    Bits own = pawns[player_color];
+    Bits sources{};
+    if (move.is_capture()) {
+        if (!(occupied[1 - player_color] & dst))
+            return false;
+        Bits from = back(dst);
+        sources = (G::east(from) | G::west(from)) & own;
+        if (G::on_board(0, src_file))
+            sources &= G::file_mask(src_file);
+    }
+    else {
+        Bits one = back(dst);
+        sources = one & own;
+        // Double step : from the rank right in front of the pieces, over an empty cell
+        Bits empty = G::ALL & ~(occupied[WHITE] | occupied[BLACK]);
+        Bits start_rank = G::rank_mask(piece_ranks[player_color] + (white ? 1 : -1));
+        if (!sources && (one & empty))
+            sources = back(one) & own & start_rank;
+    }
+    return popcount(sources) == 1;
 }
 
-bool Board::move_piece(Color& player_color, Move& move) {
+template<int N>
+bool Board<N>::move_piece(Color& player_color, Move<N>& move) {
     return true;
 }
 
@@ -533,7 +646,14 @@ bool is_direct_check() {
     return true;
 }
 
-bool Board::play_if_valid(Color& player_color, Move& move) {
+template<int N>
+bool Board<N>::under_check(Color& player_color) {
+    return false;
+}
+
+template<int N>
+bool Board<N>::play_if_valid(Color& player_color, Move<N>& move) {
+    CHESS_STAT_TIMER(STAT_PLAY_IF_VALID);
     if (!move.is_valid())
         return false;
     
@@ -541,12 +661,12 @@ bool Board::play_if_valid(Color& player_color, Move& move) {
     if (move.castle_type() < CASTLE_MAX)
         return castle(player_color, move);
     
-    // If there's a src position specified, check if it is within board limits
-    if (move.src() != std::make_pair(-1, -1) )
+    // Source coordinates that were given (N marks an unspecified rank / file, see _Move::src) must be within board limits
+    auto [src_rank, src_file] = move.src();
+    if ((src_rank != N && !Grid<N>::on_board(src_rank, 0)) || (src_file != N && !Grid<N>::on_board(0, src_file)))
         return false;
 
     auto [dst_rank, dst_file] = move.dst();
-    auto [src_rank, src_file] = move.src();
     
     // After making the move, need to verify few things:
     // 1. Should not be in check yourself after making move
@@ -554,24 +674,21 @@ bool Board::play_if_valid(Color& player_color, Move& move) {
     // 3. Same for capture. Also need to process the captured piece (if any) in a unified function regardless of pawn/piece capturer!
 
     // If dst cell is occupied by a piece of same color, cannot make the move.
-    if (board[dst_rank][dst_file] != nullptr && board[dst_rank][dst_file]->color == player_color)
+    Bits dst_bit = Grid<N>::bit(Grid<N>::square(dst_rank, dst_file));
+    if (occupied[player_color] & dst_bit)
         return false;
 
     // If the move is not declared as a capture, but if the dst square is occupied, then ALSO cannot make move.
-    if (!move.is_capture() && board[dst_rank][dst_file] != nullptr)
+    if (!move.is_capture() && ((occupied[WHITE] | occupied[BLACK]) & dst_bit))
         return false;
 
     // If it's a pawn move
     if (move.piece_type() == nullptr) {
-        if (!move_pawn(player_color, move))
+        if (!valid_pawn_move(player_color, move))
             return false;
     }
-    else {
-
-    }
 
-    // 
-    if (move.is_check() && !under_check(player_color))
+    // A "+" / "#" suffix isn't enforced (same as Position::find_move) : under_check() can't tell yet
 
     return true;
 }
@@ -579,4 +696,27 @@ bool Board::play_if_valid(Color& player_color, Move& move) {
 // Combining both, no need to verify if initially under check. Just need to ensure there's no check after playing the move (in both cases).
 
 // Need to decide how to handle pawn promotion as it involves creation of a new piece. And that requires the pmap new unique id??
-// No actually, what if we just modify the pawn's ptype to make it appropriate piece? YES! That way don't need any external support.
\ No newline at end of file
+// No actually, what if we just modify the pawn's ptype to make it appropriate piece? YES! That way don't need any external support.
+
+// ------------------------------------------------------------------------ Explicit instantiations ----------------------------------------------------------------------
+
+#define INSTANTIATE_GRID(N) \
+    template class Piece<N>; \
+    template class Piece_ptr<N>; \
+    template class Move<N>; \
+    template class Board<N>; \
+    template void operator>>(std::istream& cin, Move<N>& move); \
+    template bool operator==(const std::string& other, Move<N>& move); \
+    template bool operator!=(const std::string& other, Move<N>& move);
+
+INSTANTIATE_GRID(6)
+INSTANTIATE_GRID(7)
+INSTANTIATE_GRID(8)
+INSTANTIATE_GRID(9)
+INSTANTIATE_GRID(10)
+INSTANTIATE_GRID(11)
+INSTANTIATE_GRID(12)
+INSTANTIATE_GRID(13)
+INSTANTIATE_GRID(14)
+INSTANTIATE_GRID(15)
+INSTANTIATE_GRID(16)
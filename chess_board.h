@@ -3,6 +3,8 @@
 
 #include "chess_common.h"
 #include "chess_piece.h"
+#include "chess_bitboard.h"
+#include <array>
 
 typedef enum castle {
     SHORT,
@@ -10,22 +12,26 @@ typedef enum castle {
     CASTLE_MAX    // Hardcoding 2 castle-able rooks. There can be more rooks, These are just the ones you can castle with! Castle_type must be < CASTLE_MAX
 } Castle_type;
 
-class Board;
+// Everything tied to a board is templated on its grid size N (N x N cells, MIN_GRID_SIZE to MAX_GRID_SIZE), so that bounds and loops
+// are compile-time constants, and the 8x8 board gets 64-bit bitboards while bigger variants get wide ones (see Grid in chess_bitboard.h).
+// Definitions are in chess_board.cpp, explicitly instantiated there for every supported size.
+template<int N> class Board;
 
 // -------------------------------------------------------------------------- Piece Info -----------------------------------------------------------------------------
 
+template<int N>
 class Piece {
     int u_id;                           // Unique piece id to help track and remove piece
     std::pair<int,int> pos;             // If captured, pos = {-1,-1}
     int move_count;
 public:
-    Board* board;
+    Board<N>* board;
     Piece_type* type;
     Color color;
 
     Piece();
 
-    Piece(Piece_type* type, Color color, std::pair<int,int> pos = {-1,-1}, Board* board = nullptr);
+    Piece(Piece_type* type, Color color, std::pair<int,int> pos = {-1,-1}, Board<N>* board = nullptr);
 
     int rank();
 
@@ -36,14 +42,15 @@ public:
 
 // ----------------------------------- Wrapper class for Piece Pointer ----------------------------------
 
+template<int N>
 class Piece_ptr {
-    Piece* piece_ptr;
+    Piece<N>* piece_ptr;
     // bool processed;
     // int rank, file
 public:
     Piece_ptr();
 
-    Piece_ptr(Piece* piece_ptr);
+    Piece_ptr(Piece<N>* piece_ptr);
 
     Piece_ptr(std::nullptr_t null);     // If more than one overload accepts a pointer type, overload for std::nullptr_t is necessary to accept a nullptr argument
 
@@ -51,19 +58,19 @@ public:
     
     Piece_ptr(Piece_ptr&& other) noexcept;
 
-    void operator=(Piece* other);
+    void operator=(Piece<N>* other);
 
     void operator=(const Piece_ptr& other);
 
-    Piece* operator->();
+    Piece<N>* operator->() const;
 
-    Piece& operator*();
+    Piece<N>& operator*() const;
 
-    bool operator==(const Piece*& other);
+    bool operator==(const Piece<N>*& other);
 
     bool operator==(const Piece_ptr& other);
 
-    bool operator!=(const Piece*& other);
+    bool operator!=(const Piece<N>*& other);
 
     bool operator!=(const Piece_ptr& other);
 };
@@ -71,20 +78,17 @@ public:
 
 // ------------------------------------------------------------------------ Move Info (Wrapper class) --------------------------------------------------------------------
 
-class _Move;
+template<int N> class _Move;
 
+template<int N>
 class Move {
 public:
-    _Move* _move;
+    _Move<N>* _move;
     
     Move(void* piece_types_ptr);
 
     Move(std::string& move, void* piece_types_ptr);
 
-    Move(void* piece_types_ptr, int game_grid_size);
-
-    Move(std::string& move, void* piece_types_ptr, int game_grid_size);
-
     ~Move();
 
     void reset();
@@ -120,27 +124,42 @@ public:
     std::pair<int,int> dst();
 };
 
-void operator>>(std::istream& cin, Move& move);
+template<int N>
+void operator>>(std::istream& cin, Move<N>& move);
 
-bool operator==(const std::string& other, Move& move);
+template<int N>
+bool operator==(const std::string& other, Move<N>& move);
 
-bool operator!=(const std::string& other, Move& move);
+template<int N>
+bool operator!=(const std::string& other, Move<N>& move);
 
 
 // ------------------------------------------------------------------------------ Board Info ------------------------------------------------------------------------------------
 
+template<int N>
 class Board {
+    static_assert(N >= MIN_GRID_SIZE && N <= MAX_GRID_SIZE, "Unsupported board size");
+    typedef typename Grid<N>::Bits Bits;
+    typedef std::array<Piece_ptr<N>, N> Row;
+
     class Row_reference {
     public:
-        std::vector<Piece_ptr>& row;
+        Row& row;
 
-        Row_reference(std::vector<Piece_ptr>& row);
+        Row_reference(Row& row);
 
-        Piece_ptr& operator[](int i);
+        Piece_ptr<N>& operator[](int i);
     };
 
     // Actual board to denote position, a cell is NULL if empty, otherwise valid reference if some piece exists
-    std::vector<std::vector<Piece_ptr>> board;
+    std::array<Row, N> board;
+
+    // Cells occupied by each color, kept in sync with board : set when a piece is processed onto a cell, cleared by vacate()
+    Bits occupied[Color::MAX];
+    // Subset of the above holding pawns, so pawn moves are worked out for all pawns of a color at once (see valid_pawn_move)
+    Bits pawns[Color::MAX];
+    // Zobrist key of the pawns above (chess_ns::PAWN_ZOBRIST), same value as Position::pawn_key on the standard board
+    uint64_t pawn_key;
 
     // Set rank where pieces are placed initially. We allow castling only in this rank, regardless of where else rooks may be placed.
     int piece_ranks[Color::MAX];
@@ -157,30 +176,45 @@ class Board {
 public:
     Board();
 
-    Board(int grid_size);
+    Board(int piece_rank_offset);
 
-    Board(int grid_size, int piece_rank_offset);
+    Board(int piece_rank_offset, int promo_rank_offset, int pre_short, int post_short, int pre_long, int post_long);
 
-    Board(int grid_size, int piece_rank_offset, int promo_rank_offset, int pre_short, int post_short, int pre_long, int post_long);
+    static constexpr int size() {
+        return N;
+    }
 
     Row_reference operator[](int i);
 
+    const Bits& occupancy(Color c) const {
+        return occupied[c];
+    }
+
+    uint64_t pawn_hash() const {
+        return pawn_key;
+    }
+
+    // Empty the cell at board[rank][file] (if on board), without touching the piece itself
+    void vacate(int rank, int file);
+
     // Check if a valid board - Must have exactly 1 king per color, Must have playable pieces (not theoretical draw / not mated already)
     bool validate();
 
     // If there's a king or castleable rook at board[rank][file], we disable its castleability
     void remove_castle_at(int rank, int file);
 
-    void process_inp(const Piece_ptr& piece_ptr);
+    void process_inp(const Piece_ptr<N>& piece_ptr);
 
-    bool castle(Color& player_color, Move& move);
+    bool castle(Color& player_color, Move<N>& move);
 
-    bool move_pawn(Color& player_color, Move& move);
+    // Whether exactly one of player_color's pawns can make this (non-castling) pawn move on the current board. Only validates :
+    // nothing on the board changes
+    bool valid_pawn_move(Color& player_color, Move<N>& move);
 
-    bool Board::move_piece(Color& player_color, Move& move);
+    bool move_piece(Color& player_color, Move<N>& move);
 
     // If the move is valid, and legal in current position, play it ; Return true. Else, return false
-    bool play_if_valid(Color& player_color, Move& move);
+    bool play_if_valid(Color& player_color, Move<N>& move);
 
     bool under_check(Color& player_color);
 };
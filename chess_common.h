@@ -6,6 +6,7 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <queue>
+#include <utility>
 #include <cctype>
 #include <cassert>
 #include <cstddef>
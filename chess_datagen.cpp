@@ -0,0 +1,227 @@
+#include "chess_datagen.h"
+#include "chess_search.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+Packed_position pack_position(const Position& pos, int score, int result) {
+    Packed_position p{};
+    p.occupied = pos.occupied();
+    Bitboard b = p.occupied;
+    for (int n = 0; b; n++) {
+        int sq = pop_lsb(b);
+        assert(n < 32);
+        p.pieces[n >> 1] |= (uint8_t) (((pos.color_on(sq) << 3) | pos.piece_on(sq)) << (4 * (n & 1)));
+    }
+    p.score = (int16_t) std::max(-32767, std::min(score, 32767));
+    p.result = (int8_t) result;
+    p.flags = (uint8_t) (pos.turn | (pos.castle_rights << 1));
+    p.ep_square = pos.ep_square;
+    p.halfmove_clock = pos.halfmove_clock;
+    p.fullmove = pos.fullmove;
+    return p;
+}
+
+bool unpack_position(const Packed_position& packed, Position& pos) {
+    pos.clear();
+    if (popcount(packed.occupied) > 32)
+        return false;
+    Bitboard b = packed.occupied;
+    for (int n = 0; b; n++) {
+        int sq = pop_lsb(b);
+        int code = (packed.pieces[n >> 1] >> (4 * (n & 1))) & 15;
+        if ((code & 7) >= PIECE_MAX)
+            return false;
+        pos.put_piece((Color) (code >> 3), (Piece_index) (code & 7), sq);
+    }
+    pos.turn = (Color) (packed.flags & 1);
+    pos.castle_rights = (uint8_t) ((packed.flags >> 1) & 15);
+    pos.ep_square = packed.ep_square;
+    pos.halfmove_clock = packed.halfmove_clock;
+    pos.fullmove = packed.fullmove;
+    // Rest of the key, as set_fen() does it
+    pos.key ^= chess_ns::ZOBRIST.castle[pos.castle_rights];
+    if (pos.ep_square >= 0) pos.key ^= chess_ns::ZOBRIST.ep_file[file_of(pos.ep_square)];
+    if (pos.turn == BLACK) pos.key ^= chess_ns::ZOBRIST.turn;
+    return true;
+}
+
+// ------------------------------------------------------------------------------ Shards ------------------------------------------------------------------------------
+
+Shard_writer::Shard_writer() : file(nullptr), capacity(0) {}
+
+Shard_writer::~Shard_writer() {
+    close();
+}
+
+bool Shard_writer::open(const std::string& path, size_t capacity) {
+    close();
+    file = std::fopen(path.c_str(), "ab");
+    this->capacity = std::max<size_t>(1, capacity);
+    buffer.reserve(this->capacity);
+    return file != nullptr;
+}
+
+bool Shard_writer::flush() {
+    if (!file)
+        return false;
+    bool ok = std::fwrite(buffer.data(), sizeof(Packed_position), buffer.size(), file) == buffer.size();
+    buffer.clear();
+    return ok && std::fflush(file) == 0;
+}
+
+bool Shard_writer::close() {
+    if (!file)
+        return false;
+    bool ok = flush();
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
+
+uint64_t read_shard(const std::string& path, std::vector<Packed_position>& out) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return 0;
+    size_t before = out.size(), got;
+    const size_t CHUNK = 4096;
+    do {
+        out.resize(out.size() + CHUNK);
+        got = std::fread(out.data() + out.size() - CHUNK, sizeof(Packed_position), CHUNK, file);
+        out.resize(out.size() - CHUNK + got);
+    } while (got == CHUNK);
+    std::fclose(file);
+    return out.size() - before;
+}
+
+// ------------------------------------------------------------------------------ Self-play ---------------------------------------------------------------------------
+
+Datagen_options::Datagen_options() : threads(std::max(1u, std::thread::hardware_concurrency())), games(1000), nodes(5000),
+    random_plies(8), opening_limit(400), resign_score(2000), resign_plies(6), max_plies(400), seed(1), hash_mb(8), dir("."),
+    prefix("data"), progress_interval(1.0) {}
+
+namespace chess_ns {
+    // Shared by the workers : lock-free counters only, each worker has its own search & shard
+    struct Datagen_run {
+        const Datagen_options& options;
+        std::atomic<uint64_t> next_game{0};
+        std::atomic<uint64_t> games{0}, positions{0}, wins{0}, draws{0}, losses{0};
+        std::atomic<int> running{0};
+        std::atomic<bool> failed{false};
+
+        Datagen_run(const Datagen_options& options) : options(options) {}
+
+        // One game into writer. White's result (1, 0, -1), or 2 if the opening was thrown away
+        int play(Search& search, uint64_t& rng, Shard_writer& writer, std::vector<Packed_position>& samples) {
+            Position pos;
+            pos.set_start();
+            Key_history keys;
+            keys.reset(pos.key);
+            Move16 list[MAX_MOVES];
+            for (int ply = 0; ply < options.random_plies; ply++) {
+                int n = pos.generate_moves(list);
+                if (n == 0)
+                    return 2;
+                pos.play(list[splitmix64(rng) % n]);
+                keys.push(pos.key);
+            }
+
+            search.clear();
+            Search_limits limits;
+            limits.nodes = options.nodes;
+            samples.clear();
+            int result = 0, resign_count = 0, resign_side = 0;
+            for (int ply = options.random_plies; ; ply++) {
+                if (!pos.has_legal_moves()) {
+                    result = pos.in_check() ? ((pos.turn == WHITE) ? -1 : 1) : 0;
+                    break;
+                }
+                if (pos.halfmove_clock >= 100 || keys.repetitions(pos.halfmove_clock, 2) >= 2 || pos.insufficient_material()
+                    || ply >= options.max_plies)
+                    break;
+
+                Search_result r = search.search(pos, limits, &keys);
+                if (ply == options.random_plies && std::abs(r.score) > options.opening_limit)
+                    return 2;
+                // Both sides' searches must agree on the winner, resign_plies in a row
+                int white_score = (pos.turn == WHITE) ? r.score : -r.score, side = (white_score > 0) ? 1 : -1;
+                resign_count = (std::abs(r.score) < options.resign_score) ? 0 : (side == resign_side) ? resign_count + 1 : 1;
+                resign_side = side;
+                if (resign_count >= options.resign_plies) {
+                    result = side;
+                    break;
+                }
+
+                // Quiet positions only : the best move isn't tactical & the score isn't a mate
+                Move16 m = r.best_move;
+                bool tactical = pos.piece_on(m.dst()) != PIECE_MAX || m.flag() == Move16::EN_PASSANT || m.flag() == Move16::PROMOTION;
+                if (!pos.in_check() && !tactical && std::abs(r.score) < MATE_BOUND)
+                    samples.push_back(pack_position(pos, r.score, 0));
+                pos.play(m);
+                keys.push(pos.key);
+            }
+
+            for (Packed_position& p : samples) {
+                p.result = (int8_t) ((p.flags & 1) ? -result : result);
+                if (!writer.write(p))
+                    failed = true;
+            }
+            positions.fetch_add(samples.size(), std::memory_order_relaxed);
+            return result;
+        }
+
+        void worker(int index) {
+            Shard_writer writer;
+            if (!writer.open(options.dir + "/" + options.prefix + "-" + std::to_string(index) + ".pack"))
+                failed = true;
+            Search search(options.hash_mb);
+            uint64_t rng = options.seed ^ (0x9E3779B97F4A7C15ULL * (index + 1));
+            std::vector<Packed_position> samples;
+            while (!failed && next_game.fetch_add(1) < options.games) {
+                int result;
+                do
+                    result = play(search, rng, writer, samples);
+                while (result == 2);                // Opening thrown away, another one for the same game
+                (result > 0 ? wins : result < 0 ? losses : draws).fetch_add(1, std::memory_order_relaxed);
+                games.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (!writer.close())
+                failed = true;
+            running--;
+        }
+
+        Datagen_stats stats(double seconds) const {
+            return Datagen_stats{games.load(), positions.load(), wins.load(), draws.load(), losses.load(), seconds};
+        }
+    };
+}
+
+bool generate_data(const Datagen_options& options, Datagen_stats* stats) {
+    chess_ns::Datagen_run run(options);
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    int threads = std::max(1, options.threads);
+    run.running = threads;
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++)
+        pool.emplace_back(&chess_ns::Datagen_run::worker, &run, t);
+
+    double next_report = options.progress_interval;
+    while (run.running.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (options.on_progress && elapsed() >= next_report) {
+            options.on_progress(run.stats(elapsed()));
+            next_report += options.progress_interval;
+        }
+    }
+    for (auto& thread : pool)
+        thread.join();
+    if (stats)
+        *stats = run.stats(elapsed());
+    return !run.failed;
+}
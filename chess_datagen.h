@@ -0,0 +1,96 @@
+#ifndef CHESS_DATAGEN_H
+#define CHESS_DATAGEN_H
+
+#include "chess_common.h"
+#include "chess_position.h"
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Self-play training data : fixed-node games from randomized openings, every quiet position written with the search score and the
+// game result, for eval tuning (Tuning_set::load_packed) or network training.
+//
+// Output is one shard per worker thread (<dir>/<prefix>-<thread>.pack), a plain array of Packed_position records. Each worker
+// buffers its own records and appends whole blocks to its own file, so writers never share a lock or a stream. Shards are only
+// ever appended to : a second run adds to the same files, and a killed run leaves every complete record readable (a torn last one
+// is dropped by the reader, the file size tells).
+
+// One position, 32 bytes, native endianness
+struct Packed_position {
+    uint64_t occupied;                  // Bit per occupied square
+    uint8_t pieces[16];                 // Nibble per occupied square in square order (low nibble first) : color << 3 | Piece_index
+    int16_t score;                      // Search score, side to move's point of view
+    int8_t result;                      // Game result, side to move's point of view : 1 win, 0 draw, -1 loss
+    uint8_t flags;                      // Bit 0 : black to move, bits 1-4 : Position::castle_rights
+    int8_t ep_square;
+    uint8_t halfmove_clock;
+    uint16_t fullmove;
+};
+
+static_assert(sizeof(Packed_position) == 32, "Packed_position is a fixed 32-byte record");
+
+Packed_position pack_position(const Position& pos, int score, int result);
+
+// False if the record isn't a position (more than 32 pieces, bad piece code)
+bool unpack_position(const Packed_position& packed, Position& pos);
+
+// Append-only buffered writer of one shard, owned by one thread
+class Shard_writer {
+    std::FILE* file;
+    std::vector<Packed_position> buffer;
+    size_t capacity;
+
+public:
+    Shard_writer();
+
+    ~Shard_writer();                    // close()
+
+    Shard_writer(const Shard_writer&) = delete;
+    Shard_writer& operator=(const Shard_writer&) = delete;
+
+    // capacity : records buffered before a write
+    bool open(const std::string& path, size_t capacity = 4096);
+
+    bool write(const Packed_position& record) {
+        buffer.push_back(record);
+        return buffer.size() < capacity || flush();
+    }
+
+    bool flush();
+
+    bool close();
+};
+
+// Every complete record of a shard appended to out, returns how many
+uint64_t read_shard(const std::string& path, std::vector<Packed_position>& out);
+
+struct Datagen_stats {
+    uint64_t games;
+    uint64_t positions;                 // Written
+    uint64_t wins, draws, losses;       // Games, white's point of view
+    double seconds;
+};
+
+struct Datagen_options {
+    int threads;
+    uint64_t games;                     // Total, over all threads
+    uint64_t nodes;                     // Per move
+    int random_plies;                   // Uniformly random moves opening each game
+    int opening_limit;                  // Game thrown away if the first search after the random moves scores beyond this (centipawns)
+    int resign_score;                   // Adjudicated a win once every search for resign_plies plies in a row agrees beyond this
+    int resign_plies;
+    int max_plies;                      // Adjudicated a draw past this
+    uint64_t seed;
+    size_t hash_mb;                     // Per thread
+    std::string dir, prefix;
+    std::function<void(const Datagen_stats&)> on_progress;     // Every progress_interval seconds, from the calling thread
+    double progress_interval;
+
+    Datagen_options();
+};
+
+// Plays options.games games on options.threads threads into the shards. False if a shard couldn't be opened or written
+bool generate_data(const Datagen_options& options, Datagen_stats* stats = nullptr);
+
+#endif
@@ -0,0 +1,438 @@
+#include "chess_eval.h"
+#include "chess_piece.h"
+#include <algorithm>
+#include <cstdio>
+
+const int PIECE_VALUE[PIECE_MAX] = {
+    Pawn().points * 100,
+    Knight().points * 100,
+    Bishop().points * 100,
+    Rook().points * 100,
+    Queen().points * 100,
+    King().points * 100
+};
+
+// Piece-square bonuses, written the way a board is drawn : first row is rank 8, from white's side. Black uses them mirrored.
+static const int PST[PIECE_MAX][SQUARE_MAX] = {
+    {   // Pawn
+         0,  0,  0,  0,  0,  0,  0,  0,
+        50, 50, 50, 50, 50, 50, 50, 50,
+        10, 10, 20, 30, 30, 20, 10, 10,
+         5,  5, 10, 25, 25, 10,  5,  5,
+         0,  0,  0, 20, 20,  0,  0,  0,
+         5, -5,-10,  0,  0,-10, -5,  5,
+         5, 10, 10,-20,-20, 10, 10,  5,
+         0,  0,  0,  0,  0,  0,  0,  0
+    },
+    {   // Knight
+        -50,-40,-30,-30,-30,-30,-40,-50,
+        -40,-20,  0,  0,  0,  0,-20,-40,
+        -30,  0, 10, 15, 15, 10,  0,-30,
+        -30,  5, 15, 20, 20, 15,  5,-30,
+        -30,  0, 15, 20, 20, 15,  0,-30,
+        -30,  5, 10, 15, 15, 10,  5,-30,
+        -40,-20,  0,  5,  5,  0,-20,-40,
+        -50,-40,-30,-30,-30,-30,-40,-50
+    },
+    {   // Bishop
+        -20,-10,-10,-10,-10,-10,-10,-20,
+        -10,  0,  0,  0,  0,  0,  0,-10,
+        -10,  0,  5, 10, 10,  5,  0,-10,
+        -10,  5,  5, 10, 10,  5,  5,-10,
+        -10,  0, 10, 10, 10, 10,  0,-10,
+        -10, 10, 10, 10, 10, 10, 10,-10,
+        -10,  5,  0,  0,  0,  0,  5,-10,
+        -20,-10,-10,-10,-10,-10,-10,-20
+    },
+    {   // Rook
+          0,  0,  0,  0,  0,  0,  0,  0,
+          5, 10, 10, 10, 10, 10, 10,  5,
+         -5,  0,  0,  0,  0,  0,  0, -5,
+         -5,  0,  0,  0,  0,  0,  0, -5,
+         -5,  0,  0,  0,  0,  0,  0, -5,
+         -5,  0,  0,  0,  0,  0,  0, -5,
+         -5,  0,  0,  0,  0,  0,  0, -5,
+          0,  0,  0,  5,  5,  0,  0,  0
+    },
+    {   // Queen
+        -20,-10,-10, -5, -5,-10,-10,-20,
+        -10,  0,  0,  0,  0,  0,  0,-10,
+        -10,  0,  5,  5,  5,  5,  0,-10,
+         -5,  0,  5,  5,  5,  5,  0, -5,
+          0,  0,  5,  5,  5,  5,  0, -5,
+        -10,  5,  5,  5,  5,  5,  0,-10,
+        -10,  0,  5,  0,  0,  0,  0,-10,
+        -20,-10,-10, -5, -5,-10,-10,-20
+    },
+    {   // King (middlegame, stay sheltered)
+        -30,-40,-40,-50,-50,-40,-40,-30,
+        -30,-40,-40,-50,-50,-40,-40,-30,
+        -30,-40,-40,-50,-50,-40,-40,-30,
+        -30,-40,-40,-50,-50,-40,-40,-30,
+        -20,-30,-30,-40,-40,-30,-30,-20,
+        -10,-20,-20,-20,-20,-20,-20,-10,
+         20, 20,  0,  0,  0,  0, 20, 20,
+         20, 30, 10,  0,  0, 10, 30, 20
+    }
+};
+
+// ------------------------------------------------------------------------------ Pawn structure ------------------------------------------------------------------------
+
+static const int DOUBLED_PENALTY = 12;                  // Per pawn behind another one of the same color on its file
+static const int ISOLATED_PENALTY = 15;                 // No own pawn on either adjacent file
+static const int PASSED_BONUS[8] = {0, 5, 10, 20, 35, 60, 100, 0};      // By rank, from the pawn's own side
+static const int SHELTER_PAWN[3] = {0, 12, 6};          // Own pawn in front of the king : missing, 1 or 2 ranks up (from the back rank)
+static const int SHELTER_MISSING = -15;                 // None at all on that file
+
+namespace chess_ns {
+    struct Pawn_masks {
+        Bitboard adjacent_files[8];
+        Bitboard front_span[Color::MAX][SQUARE_MAX];    // Squares ahead of sq on its file & both adjacent ones : a passer has no enemy pawn there
+    };
+
+    inline constexpr Pawn_masks PAWN_MASKS = [] {
+        Pawn_masks m{};
+        for (int f = 0; f < 8; f++)
+            m.adjacent_files[f] = ((f > 0) ? FILE_A << (f - 1) : 0) | ((f < 7) ? FILE_A << (f + 1) : 0);
+        for (int sq = 0; sq < SQUARE_MAX; sq++) {
+            Bitboard files = m.adjacent_files[file_of(sq)] | (FILE_A << file_of(sq));
+            for (int r = rank_of(sq) + 1; r < 8; r++)
+                m.front_span[WHITE][sq] |= files & (RANK_1 << (8 * r));
+            for (int r = rank_of(sq) - 1; r >= 0; r--)
+                m.front_span[BLACK][sq] |= files & (RANK_1 << (8 * r));
+        }
+        return m;
+    }();
+}
+
+void evaluate_pawns(const Position& pos, Pawn_entry& e) {
+    using chess_ns::PAWN_MASKS;
+    int score[Color::MAX] = {0, 0};
+    e.key = pos.pawn_key;
+    for (int c = WHITE; c < Color::MAX; c++) {
+        Bitboard ours = pos.pieces((Color) c, PAWN), theirs = pos.pieces((Color) (1 - c), PAWN);
+        e.passed[c] = 0;
+        for (int f = 0; f < 8; f++) {
+            int count = popcount(ours & (FILE_A << f));
+            if (count > 1)
+                score[c] -= DOUBLED_PENALTY * (count - 1);
+            if (count && !(ours & PAWN_MASKS.adjacent_files[f]))
+                score[c] -= ISOLATED_PENALTY * count;
+        }
+        Bitboard b = ours;
+        while (b) {
+            int sq = pop_lsb(b);
+            // Frontmost pawn of its file only, one behind it isn't passed
+            if (!(theirs & PAWN_MASKS.front_span[c][sq]) && !(ours & PAWN_MASKS.front_span[c][sq] & (FILE_A << file_of(sq)))) {
+                e.passed[c] |= bit(sq);
+                score[c] += PASSED_BONUS[(c == WHITE) ? rank_of(sq) : 7 - rank_of(sq)];
+            }
+        }
+        // Shelter for a king on each file : the three files around it (kept on the board at the edges)
+        int back = (c == WHITE) ? 0 : 7, up = (c == WHITE) ? 1 : -1;
+        for (int king_file = 0; king_file < 8; king_file++) {
+            int center = std::min(std::max(king_file, 1), 6), bonus = 0;
+            for (int f = center - 1; f <= center + 1; f++) {
+                int found = SHELTER_MISSING;
+                for (int step = 1; step <= 2; step++)
+                    if (ours & bit(square(back + step * up, f))) {
+                        found = SHELTER_PAWN[step];
+                        break;
+                    }
+                bonus += found;
+            }
+            e.shelter[c][king_file] = (int8_t) bonus;
+        }
+    }
+    e.score = (int16_t) (score[WHITE] - score[BLACK]);
+}
+
+static const uint32_t PAWN_FILE_KIND = 0x4E574150;      // "PAWN"
+
+uint64_t eval_signature() {
+    uint64_t h = chess_ns::checksum64(PIECE_VALUE, sizeof(PIECE_VALUE));
+    h = chess_ns::checksum64(PST, sizeof(PST), h);
+    const int pawn_terms[] = {DOUBLED_PENALTY, ISOLATED_PENALTY, SHELTER_PAWN[1], SHELTER_PAWN[2], SHELTER_MISSING};
+    h = chess_ns::checksum64(pawn_terms, sizeof(pawn_terms), h);
+    return chess_ns::checksum64(PASSED_BONUS, sizeof(PASSED_BONUS), h);
+}
+
+Pawn_table::Pawn_table(int entries_log2) : mask(((uint64_t) 1 << entries_log2) - 1), probes(0), hits(0),
+    memory((size_t) 1 << entries_log2) {
+    table = memory.data();
+    clear();
+}
+
+Pawn_table::~Pawn_table() {
+    close_file();
+}
+
+void Pawn_table::clear() {
+    std::fill(table, table + mask + 1, Pawn_entry{});
+    // Key 0 is a real pawn key (no pawns at all), so empty slots get one that doesn't index them
+    for (size_t i = 0; i <= mask; i++)
+        table[i].key = ~(uint64_t) i;
+    probes = hits = 0;
+}
+
+Mapped_status Pawn_table::map_file(const std::string& path) {
+    bool was_mapped = file.is_open();
+    close_file();
+    Position start;
+    start.set_start();
+    uint64_t salt = chess_ns::checksum64(&start.pawn_key, sizeof(start.pawn_key), sizeof(Pawn_entry)) ^ eval_signature();
+    Mapped_status status = file.open(path, PAWN_FILE_KIND, salt, (mask + 1) * sizeof(Pawn_entry));
+    if (!file.is_open()) {
+        if (was_mapped)
+            use_heap();
+        return status;
+    }
+    std::vector<Pawn_entry>().swap(memory);
+    table = static_cast<Pawn_entry*>(file.payload());
+    if (status == MAPPED_WARM)
+        probes = hits = 0;
+    else
+        clear();
+    return status;
+}
+
+// Saves & unmaps the file, leaving table dangling : the caller points it at new storage, or is the destructor
+void Pawn_table::close_file() {
+    if (file.is_open())
+        file.close();
+}
+
+void Pawn_table::use_heap() {
+    memory.assign(mask + 1, Pawn_entry{});
+    table = memory.data();
+    clear();
+}
+
+void Pawn_table::unmap_file() {
+    if (!file.is_open())
+        return;
+    close_file();
+    use_heap();
+}
+
+const Pawn_entry& Pawn_table::probe(const Position& pos) {
+    Pawn_entry& e = table[pos.pawn_key & mask];
+    probes++;
+    if (e.key == pos.pawn_key)
+        hits++;
+    else
+        evaluate_pawns(pos, e);
+    return e;
+}
+
+// ------------------------------------------------------------------------------ Evaluation ----------------------------------------------------------------------------
+
+int evaluate(const Position& pos, Pawn_table* pawns) {
+    int score[Color::MAX] = {0, 0};
+    for (int c = WHITE; c < Color::MAX; c++) {
+        for (int p = PAWN; p < PIECE_MAX; p++) {
+            Bitboard b = pos.pieces((Color) c, (Piece_index) p);
+            while (b) {
+                int sq = pop_lsb(b);
+                // Table row 0 is rank 8 for white, so flip rank for white and use as-is for black (mirror)
+                int idx = (c == WHITE) ? square(7 - rank_of(sq), file_of(sq)) : sq;
+                score[c] += PIECE_VALUE[p] + PST[p][idx];
+            }
+        }
+    }
+
+    Pawn_entry local;
+    const Pawn_entry* e = &local;
+    if (pawns)
+        e = &pawns->probe(pos);
+    else
+        evaluate_pawns(pos, local);
+    score[WHITE] += e->score;
+    for (int c = WHITE; c < Color::MAX; c++) {
+        int king = pos.king_square((Color) c);
+        int king_rank = (c == WHITE) ? rank_of(king) : 7 - rank_of(king);
+        if (king_rank <= 1)
+            score[c] += e->shelter[c][file_of(king)];
+    }
+    return score[pos.turn] - score[1 - pos.turn];
+}
+
+// ------------------------------------------------------------------------------ Tuning --------------------------------------------------------------------------------
+
+namespace chess_ns {
+    const int PARAM_PIECE = 0;                          // Pawn .. queen (king has no value)
+    const int PARAM_PST = PARAM_PIECE + KING;
+    const int PARAM_DOUBLED = PARAM_PST + PIECE_MAX * SQUARE_MAX;
+    const int PARAM_ISOLATED = PARAM_DOUBLED + 1;
+    const int PARAM_PASSED = PARAM_ISOLATED + 1;        // Ranks 2-7 from the pawn's side (PASSED_BONUS[1..6])
+    const int PARAM_SHELTER = PARAM_PASSED + 6;         // SHELTER_PAWN[1], SHELTER_PAWN[2], SHELTER_MISSING
+}
+
+const int EVAL_PARAM_COUNT = chess_ns::PARAM_SHELTER + 3;
+
+void eval_params(int* values) {
+    using namespace chess_ns;
+    for (int p = PAWN; p < KING; p++)
+        values[PARAM_PIECE + p] = PIECE_VALUE[p];
+    std::copy(&PST[0][0], &PST[0][0] + PIECE_MAX * SQUARE_MAX, values + PARAM_PST);
+    values[PARAM_DOUBLED] = DOUBLED_PENALTY;
+    values[PARAM_ISOLATED] = ISOLATED_PENALTY;
+    std::copy(PASSED_BONUS + 1, PASSED_BONUS + 7, values + PARAM_PASSED);
+    values[PARAM_SHELTER] = SHELTER_PAWN[1];
+    values[PARAM_SHELTER + 1] = SHELTER_PAWN[2];
+    values[PARAM_SHELTER + 2] = SHELTER_MISSING;
+}
+
+int eval_features(const Position& pos, Eval_feature* out) {
+    using namespace chess_ns;
+    // Sparse accumulation : slot[param] is its index in out + 1, 0 if not there yet
+    uint16_t slot[EVAL_PARAM_COUNT] = {};
+    int n = 0;
+    auto add = [&](int param, int coef) {
+        if (!slot[param]) {
+            out[n] = Eval_feature{(uint16_t) param, 0};
+            slot[param] = (uint16_t) ++n;
+        }
+        out[slot[param] - 1].coef = (int8_t) (out[slot[param] - 1].coef + coef);
+    };
+
+    for (int c = WHITE; c < Color::MAX; c++) {
+        int sign = (c == WHITE) ? 1 : -1;
+        for (int p = PAWN; p < PIECE_MAX; p++) {
+            Bitboard b = pos.pieces((Color) c, (Piece_index) p);
+            while (b) {
+                int sq = pop_lsb(b);
+                int idx = (c == WHITE) ? square(7 - rank_of(sq), file_of(sq)) : sq;
+                if (p != KING)
+                    add(PARAM_PIECE + p, sign);
+                add(PARAM_PST + p * SQUARE_MAX + idx, sign);
+            }
+        }
+
+        // Pawn structure & shelter, as evaluate_pawns() scores them
+        Bitboard ours = pos.pieces((Color) c, PAWN), theirs = pos.pieces((Color) (1 - c), PAWN);
+        for (int f = 0; f < 8; f++) {
+            int count = popcount(ours & (FILE_A << f));
+            if (count > 1)
+                add(PARAM_DOUBLED, -sign * (count - 1));
+            if (count && !(ours & PAWN_MASKS.adjacent_files[f]))
+                add(PARAM_ISOLATED, -sign * count);
+        }
+        Bitboard b = ours;
+        while (b) {
+            int sq = pop_lsb(b);
+            if (!(theirs & PAWN_MASKS.front_span[c][sq]) && !(ours & PAWN_MASKS.front_span[c][sq] & (FILE_A << file_of(sq))))
+                add(PARAM_PASSED + ((c == WHITE) ? rank_of(sq) : 7 - rank_of(sq)) - 1, sign);
+        }
+        int king = pos.king_square((Color) c);
+        int back = (c == WHITE) ? 0 : 7, up = (c == WHITE) ? 1 : -1;
+        if (((c == WHITE) ? rank_of(king) : 7 - rank_of(king)) <= 1) {
+            int center = std::min(std::max(file_of(king), 1), 6);
+            for (int f = center - 1; f <= center + 1; f++) {
+                int found = PARAM_SHELTER + 2;
+                for (int step = 1; step <= 2; step++)
+                    if (ours & bit(square(back + step * up, f))) {
+                        found = PARAM_SHELTER + step - 1;
+                        break;
+                    }
+                add(found, sign);
+            }
+        }
+    }
+
+    // Terms that cancelled out (same entry for both sides) are dropped
+    int kept = 0;
+    for (int i = 0; i < n; i++)
+        if (out[i].coef)
+            out[kept++] = out[i];
+    return kept;
+}
+
+std::string eval_params_source(const int* values) {
+    using namespace chess_ns;
+    static const char* NAMES[PIECE_MAX] = {"Pawn", "Knight", "Bishop", "Rook", "Queen", "King"};
+    char line[128];
+    std::string out = "// Piece values (Piece_type::points x 100) :";
+    for (int p = PAWN; p < KING; p++) {
+        std::snprintf(line, sizeof(line), " %s %d", NAMES[p], values[PARAM_PIECE + p]);
+        out += line;
+    }
+    out += "\nstatic const int PST[PIECE_MAX][SQUARE_MAX] = {\n";
+    for (int p = PAWN; p < PIECE_MAX; p++) {
+        out += std::string("    {   // ") + NAMES[p] + "\n";
+        for (int r = 0; r < 8; r++) {
+            out += "        ";
+            for (int f = 0; f < 8; f++) {
+                std::snprintf(line, sizeof(line), "%3d%s", values[PARAM_PST + p * SQUARE_MAX + r * 8 + f], (r == 7 && f == 7) ? "" : ",");
+                out += line;
+            }
+            out += "\n";
+        }
+        out += (p == KING) ? "    }\n" : "    },\n";
+    }
+    out += "};\n";
+    std::snprintf(line, sizeof(line), "static const int DOUBLED_PENALTY = %d;\nstatic const int ISOLATED_PENALTY = %d;\n",
+                  values[PARAM_DOUBLED], values[PARAM_ISOLATED]);
+    out += line;
+    out += "static const int PASSED_BONUS[8] = {0";
+    for (int r = 0; r < 6; r++)
+        out += ", " + std::to_string(values[PARAM_PASSED + r]);
+    std::snprintf(line, sizeof(line), ", 0};\nstatic const int SHELTER_PAWN[3] = {0, %d, %d};\nstatic const int SHELTER_MISSING = %d;\n",
+                  values[PARAM_SHELTER], values[PARAM_SHELTER + 1], values[PARAM_SHELTER + 2]);
+    return out + line;
+}
+
+int see(const Position& pos, Move16 move) {
+    if (move.flag() == Move16::CASTLING)
+        return 0;
+    int src = move.src(), dst = move.dst();
+    int gain[32], d = 0;
+    Bitboard occ = pos.occupied() ^ bit(src);
+    Piece_index on_dst = pos.piece_on(src);             // Piece that will be standing on dst, i.e. next one to get captured
+
+    gain[0] = (pos.piece_on(dst) == PIECE_MAX) ? 0 : PIECE_VALUE[pos.piece_on(dst)];
+    if (move.flag() == Move16::EN_PASSANT) {
+        gain[0] = PIECE_VALUE[PAWN];
+        occ ^= bit(dst + ((pos.turn == WHITE) ? -8 : 8));
+    }
+    else if (move.flag() == Move16::PROMOTION) {
+        gain[0] += PIECE_VALUE[move.promo()] - PIECE_VALUE[PAWN];
+        on_dst = move.promo();
+    }
+
+    Bitboard diagonal = pos.by_type[BISHOP] | pos.by_type[QUEEN];
+    Bitboard straight = pos.by_type[ROOK] | pos.by_type[QUEEN];
+    Bitboard attackers = pos.attackers_to(dst, occ) & occ;
+    Color side = (Color) (1 - pos.turn);
+
+    while (d < 31) {
+        Bitboard mine = attackers & pos.by_color[side];
+        if (!mine)
+            break;
+        Piece_index p = PAWN;
+        while (!(mine & pos.by_type[p]))
+            p = (Piece_index) (p + 1);
+        // King can only recapture if nothing defends the square any more
+        if (p == KING && (attackers & pos.by_color[1 - side]))
+            break;
+
+        d++;
+        gain[d] = PIECE_VALUE[on_dst] - gain[d - 1];
+        if (std::max(-gain[d - 1], gain[d]) < 0)
+            break;                                      // Neither side can come out ahead by continuing
+
+        occ ^= bit(lsb(mine & pos.by_type[p]));
+        if (p == PAWN || p == BISHOP || p == QUEEN)
+            attackers |= bishop_attacks(dst, occ) & diagonal;
+        if (p == ROOK || p == QUEEN)
+            attackers |= rook_attacks(dst, occ) & straight;
+        attackers &= occ;
+        on_dst = p;
+        side = (Color) (1 - side);
+    }
+    while (d) {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        d--;
+    }
+    return gain[0];
+}
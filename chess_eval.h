@@ -0,0 +1,98 @@
+#ifndef CHESS_EVAL_H
+#define CHESS_EVAL_H
+
+#include "chess_common.h"
+#include "chess_mapped.h"
+#include "chess_position.h"
+#include <vector>
+
+// Centipawn value of each piece. Taken from Piece_type::points (x100) so that the Piece_type classes stay the one place where
+// material values are defined. King is 0 there, same here (it is never captured).
+extern const int PIECE_VALUE[PIECE_MAX];
+
+// Pawn structure of a position : everything about it that depends on pawns alone, so it can be cached under Position::pawn_key
+struct Pawn_entry {
+    uint64_t key;
+    Bitboard passed[Color::MAX];        // Passed pawns of each color
+    int16_t score;                      // Doubled, isolated & passed pawn terms, white's point of view
+    int8_t shelter[Color::MAX][8];      // King shelter bonus of each color, for its king on each file (own back two ranks only)
+};
+
+// Per-thread cache of pawn structure evaluations (one per Search), direct-mapped & always-replace. Pawn structure changes on few
+// moves, so nearly every eval is a hit and the pawn terms cost one lookup. Can be backed by a file, like Transposition_table.
+class Pawn_table {
+    Pawn_entry* table;                  // memory's or file's
+    uint64_t mask;
+    uint64_t probes, hits;
+    std::vector<Pawn_entry> memory;     // Storage when not mapped
+    Mapped_file file;
+
+    void close_file();
+
+    // Fresh, cleared heap storage
+    void use_heap();
+
+public:
+    Pawn_table(int entries_log2 = 14);
+
+    ~Pawn_table();
+
+    void clear();
+
+    // Backs the table with path (see chess_mapped.h), same size. Entries from the last run are kept if the file is warm (it is
+    // stale if the pawn terms changed since), else the table starts cleared ; on MAPPED_BUSY / MAPPED_FAILED it stays on the heap
+    Mapped_status map_file(const std::string& path);
+
+    // Saves the file & goes back to an empty heap table
+    void unmap_file();
+
+    // Entry for pos's pawns, evaluated & stored first if not cached
+    const Pawn_entry& probe(const Position& pos);
+
+    uint64_t probe_count() const {
+        return probes;
+    }
+
+    uint64_t hit_count() const {
+        return hits;
+    }
+};
+
+// Fills e with the pawn structure of pos (what Pawn_table caches)
+void evaluate_pawns(const Position& pos, Pawn_entry& e);
+
+// Checksum of every evaluation term, so caches of scores saved to disk can tell they were computed by another evaluation
+uint64_t eval_signature();
+
+// Static evaluation in centipawns, from the point of view of the side to move : material + piece-square tables + pawn structure.
+// Pawn structure comes from pawns if given, else is evaluated on the spot
+int evaluate(const Position& pos, Pawn_table* pawns = nullptr);
+
+// ---- Tuning ----
+
+// evaluate() is linear in its terms : from white's point of view it is the sum of coef * term over the features eval_features()
+// lists (material & piece-square entries, pawn structure counts, white's minus black's). Terms are numbered 0..EVAL_PARAM_COUNT - 1 :
+// piece values (pawn to queen), piece-square tables (PST[piece][table index]), doubled, isolated, passed by rank (2nd to 7th),
+// shelter (pawn 1 up, 2 up, missing)
+struct Eval_feature {
+    uint16_t param;
+    int8_t coef;
+};
+
+extern const int EVAL_PARAM_COUNT;
+
+// Current value of every term
+void eval_params(int* values);
+
+// Nonzero features of pos into out (room for EVAL_PARAM_COUNT), returns how many
+int eval_features(const Position& pos, Eval_feature* out);
+
+// values as the tables & constants of chess_eval.cpp, to paste over them (piece values as a comment : they come from Piece_type)
+std::string eval_params_source(const int* values);
+
+// Static exchange evaluation : material balance (centipawns, for the side to move) of move followed by the best sequence of
+// recaptures on its dst square, each side always recapturing with its least valuable piece and free to stop. Sliders hidden behind
+// a capturer (x-rays) join in as the square opens up. Pins are ignored.
+int see(const Position& pos, Move16 move);
+
+#endif
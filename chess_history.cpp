@@ -0,0 +1,121 @@
+#include "chess_history.h"
+
+// Every reversible move (non-pawn piece moving between two squares it attacks on an empty board, either color) keyed by the Zobrist
+// difference it makes : the piece leaving s1, arriving on s2, and the turn flipping. Moving back gives the same key, so each square
+// pair is stored once, s1 < s2. 3668 moves, in a two-way cuckoo table of 8192 slots.
+namespace chess_ns {
+    struct Cuckoo_table {
+        static const int SIZE = 8192;
+
+        uint64_t keys[SIZE];
+        Move16 moves[SIZE];
+
+        static int h1(uint64_t key) {
+            return (int) (key & (SIZE - 1));
+        }
+
+        static int h2(uint64_t key) {
+            return (int) ((key >> 16) & (SIZE - 1));
+        }
+
+        Cuckoo_table() : keys{}, moves{} {
+            for (int c = WHITE; c < Color::MAX; c++)
+                for (int p = KNIGHT; p <= KING; p++)
+                    for (int s1 = 0; s1 < SQUARE_MAX; s1++)
+                        for (int s2 = s1 + 1; s2 < SQUARE_MAX; s2++) {
+                            if (!(piece_attacks((Piece_index) p, s1, 0) & bit(s2)))
+                                continue;
+                            uint64_t key = ZOBRIST.piece[c][p][s1] ^ ZOBRIST.piece[c][p][s2] ^ ZOBRIST.turn;
+                            Move16 move(s1, s2);
+                            // Insert, kicking out whoever sits there to its other slot, until an empty slot takes the last one
+                            int i = h1(key);
+                            while (true) {
+                                std::swap(keys[i], key);
+                                std::swap(moves[i], move);
+                                if (move.is_null())
+                                    break;
+                                i = (i == h1(key)) ? h2(key) : h1(key);
+                            }
+                        }
+        }
+
+        // The reversible move making this key difference, null move if none
+        Move16 find(uint64_t key) const {
+            int i = h1(key);
+            if (keys[i] == key)
+                return moves[i];
+            i = h2(key);
+            return (keys[i] == key) ? moves[i] : Move16();
+        }
+    };
+
+    static const Cuckoo_table CUCKOO;
+}
+
+bool Key_history::upcoming_repetition(const Position& pos, int search_plies) const {
+    int window = std::min((int) pos.halfmove_clock, std::min((int) count - 1, CAPACITY - 1));
+    if (window < 3)
+        return false;
+    Bitboard occ = pos.occupied();
+    for (int i = 3; i <= window; i += 2) {
+        Move16 move = chess_ns::CUCKOO.find(pos.key ^ at(i));
+        if (move.is_null())
+            continue;
+        int s1 = move.src(), s2 = move.dst();
+        // Path must be clear, and the piece (on either end, depending on which way it goes) has to be ours
+        if (between(s1, s2) & occ)
+            continue;
+        int from = (pos.piece_on(s1) != PIECE_MAX) ? s1 : s2;
+        if (pos.color_on(from) != pos.turn)
+            continue;
+        if (i < search_plies)
+            return true;
+        // Cycle back into the game : draws only if that position already occurred once more before
+        uint64_t key = at(i);
+        for (int j = i + 4; j <= window; j += 2)
+            if (at(j) == key)
+                return true;
+    }
+    return false;
+}
+
+void Game_history::reset(uint64_t key) {
+    if (!entries || entries.use_count() > 1) {
+        entries = std::make_shared<std::vector<Entry>>();
+        entries->reserve(256);                  // A whole game's worth in one go (later games reuse it), not growth step by step
+    }
+    entries->assign(1, Entry{key, Move16()});
+    length = 1;
+}
+
+void Game_history::push(Move16 move, uint64_t key) {
+    if (entries.use_count() > 1) {
+        // Shared with a snapshot / fork : this line gets its own copy, the others keep the old storage untouched
+        auto own = std::make_shared<std::vector<Entry>>();
+        own->reserve(length + 64);
+        own->assign(entries->begin(), entries->begin() + length);
+        entries = own;
+    }
+    else
+        entries->resize(length);        // Sole owner again, drop whatever a restored-from line had appended past us
+    entries->push_back(Entry{key, move});
+    length++;
+}
+
+int Game_history::repetitions(int halfmove_clock, int limit) const {
+    const Entry* e = entries->data();
+    int last = (int) length - 1, window = std::min(halfmove_clock, last), found = 0;
+    for (int i = 4; i <= window; i += 2)
+        if (e[last - i].key == e[last].key && ++found == limit)
+            break;
+    return found;
+}
+
+Key_history Game_history::keys() const {
+    Key_history out;
+    int first = std::max(0, (int) length - Key_history::CAPACITY);
+    out.reset((*entries)[first].key);
+    for (int i = first + 1; i < (int) length; i++)
+        out.push((*entries)[i].key);
+    return out;
+}
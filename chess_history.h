@@ -0,0 +1,102 @@
+#ifndef CHESS_HISTORY_H
+#define CHESS_HISTORY_H
+
+#include "chess_common.h"
+#include "chess_position.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// Zobrist keys of the positions a game (plus the search line on top of it) went through, for repetition detection. Fixed ring,
+// pushing a key is a single store. Only the reversible window matters : a position before the last capture / pawn move can never
+// come back, and Position::halfmove_clock says how far back that is. Within it, only every other key can match (same side to move).
+class Key_history {
+public:
+    static constexpr int CAPACITY = 256;            // Power of 2, above any halfmove clock Position keeps (255)
+
+    // Start over from a position (new game / FEN)
+    void reset(uint64_t key) {
+        keys[0] = key;
+        count = 1;
+    }
+
+    void push(uint64_t key) {
+        keys[count++ & (CAPACITY - 1)] = key;
+    }
+
+    void pop() {
+        count--;
+    }
+
+    // Keys pushed since reset(), including the ones the ring has overwritten since
+    int size() const {
+        return (int) count;
+    }
+
+    uint64_t back() const {
+        return keys[(count - 1) & (CAPACITY - 1)];
+    }
+
+    // Earlier occurrences of the latest position, with the given halfmove clock (the one of the latest position). Counting stops
+    // at limit : 2 is all threefold repetition needs to know
+    int repetitions(int halfmove_clock, int limit = 2) const {
+        int window = std::min(halfmove_clock, std::min((int) count - 1, CAPACITY - 1)), found = 0;
+        uint64_t key = back();
+        for (int i = 4; i <= window; i += 2)
+            if (at(i) == key && ++found == limit)
+                break;
+        return found;
+    }
+
+    // Whether the side to move in pos (the latest position) has a move reaching a position of the reversible window again, i.e. can
+    // force a draw by repetition, or at least get one repetition closer. Only cycles the search made itself (within the last
+    // search_plies keys) count right away, ones reaching back into the game need that earlier position repeated already.
+    // Cuckoo table of reversible moves, after Marcel van Kervinck's scheme : one lookup per candidate instead of generating moves.
+    bool upcoming_repetition(const Position& pos, int search_plies) const;
+
+private:
+    uint64_t keys[CAPACITY];
+    uint32_t count = 0;
+
+    // Key from i plies ago
+    uint64_t at(int i) const {
+        return keys[(count - 1 - i) & (CAPACITY - 1)];
+    }
+};
+
+// Every move of a game with the key it led to, from the start position on. Copies share the storage (copy-on-write) : copying one is
+// a pointer and a length, and it's only duplicated when a copy that isn't the sole owner plays a move. So snapshots & forks of a game
+// (see Chess::snapshot()) cost nothing until their lines actually diverge.
+class Game_history {
+public:
+    struct Entry {
+        uint64_t key;
+        Move16 move;                    // Move that led to key, null for the start position
+    };
+
+    // Start over from a position (new game / FEN)
+    void reset(uint64_t key);
+
+    void push(Move16 move, uint64_t key);
+
+    // Positions, including the start one
+    int size() const {
+        return (int) length;
+    }
+
+    const Entry& operator[](int i) const {
+        return (*entries)[i];
+    }
+
+    // Earlier occurrences of the latest position, same as Key_history::repetitions()
+    int repetitions(int halfmove_clock, int limit = 2) const;
+
+    // Latest keys as a search wants them (Search::search())
+    Key_history keys() const;
+
+private:
+    std::shared_ptr<std::vector<Entry>> entries;
+    uint32_t length = 0;
+};
+
+#endif
@@ -0,0 +1,267 @@
+#include "chess_index.h"
+#include "chess_record.h"
+#include "chess_trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace chess_ns {
+    const char INDEX_FILE_MAGIC[8] = {'C','H','E','S','S','I','D','X'};
+    const uint32_t INDEX_FILE_VERSION = 1;
+    const size_t INDEX_HEADER_SIZE = 64;
+    const size_t MERGE_BUFFER_ENTRIES = 1 << 14;
+
+    struct Index_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t fence_interval;
+        uint64_t entry_count;
+        uint64_t fence_count;
+        uint8_t padding[INDEX_HEADER_SIZE - 32];
+    };
+    static_assert(sizeof(Index_header) == INDEX_HEADER_SIZE);
+    static_assert(sizeof(Index_entry) == 16);
+
+    // Sequential reader over one sorted run file, refilling a fixed buffer
+    class Run_cursor {
+        std::ifstream in;
+        std::vector<Index_entry> buffer;
+        size_t pos, count;
+    public:
+        Run_cursor(const std::string& path) : in(path, std::ios::binary), buffer(MERGE_BUFFER_ENTRIES), pos(0), count(0) {}
+
+        // False once run is exhausted
+        bool peek(Index_entry& entry) {
+            if (pos == count) {
+                in.read((char*) buffer.data(), buffer.size() * sizeof(Index_entry));
+                count = in.gcount() / sizeof(Index_entry);
+                pos = 0;
+                if (count == 0) return false;
+            }
+            entry = buffer[pos];
+            return true;
+        }
+
+        void advance() {
+            pos++;
+        }
+    };
+}
+
+using namespace chess_ns;
+
+
+// ------------------------------------------------------------------------------ Index build ---------------------------------------------------------------------------
+
+uint64_t build_position_index(const std::string& record_path, const std::string& index_path, const Index_build_options& options) {
+    Record_reader probe;
+    if (!probe.open(record_path))
+        return 0;
+    uint64_t games = probe.game_count();
+    int threads = (int) std::max<uint64_t>(1, std::min<uint64_t>(std::max(1, options.threads), games));
+    size_t capacity = std::max<size_t>(1024, options.memory_budget / threads / sizeof(Index_entry));
+    std::string prefix = options.temp_prefix.empty() ? index_path : options.temp_prefix;
+
+    std::vector<std::string> runs;
+    std::mutex runs_mutex;
+    std::atomic<bool> failed(false);
+
+    // Phase 1 : each thread replays a contiguous range of games, spilling sorted runs whenever its buffer fills up
+    auto worker = [&]([[maybe_unused]] int t, uint64_t first, uint64_t last) {
+        CHESS_TRACE_THREAD("index worker " + std::to_string(t));
+        CHESS_TRACE_SPAN_ARG("index_worker", "games", (int64_t) (last - first));
+        std::vector<Index_entry> buffer;
+        buffer.reserve(capacity);
+        auto spill = [&]() {
+            if (buffer.empty()) return;
+            CHESS_TRACE_SPAN_ARG("spill", "entries", (int64_t) buffer.size());
+            std::sort(buffer.begin(), buffer.end());
+            std::string path;
+            {
+                std::unique_lock<std::mutex> lock(runs_mutex, std::defer_lock);
+                {
+                    CHESS_TRACE_SPAN("wait runs lock");
+                    lock.lock();
+                }
+                path = prefix + ".run" + std::to_string(runs.size());
+                runs.push_back(path);
+            }
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write((const char*) buffer.data(), buffer.size() * sizeof(Index_entry));
+            if (!out) failed = true;
+            buffer.clear();
+        };
+
+        Record_reader reader;
+        Game_record game;
+        Position pos;
+        if (first < last && (!reader.open(record_path) || !reader.seek(first))) {
+            failed = true;
+            return;
+        }
+        for (uint64_t id = first; id < last && !failed; id++) {
+            if (!reader.next_game(game) || !game.start_position(pos)) {
+                failed = true;
+                break;
+            }
+            if (buffer.size() + game.moves.size() + 1 > capacity)
+                spill();
+            buffer.push_back({pos.key, (uint32_t) id, 0});
+            for (size_t ply = 0; ply < game.moves.size(); ply++) {
+                pos.play(game.moves[ply]);
+                buffer.push_back({pos.key, (uint32_t) id, (uint32_t) ply + 1});
+            }
+        }
+        spill();
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++)
+        pool.emplace_back(worker, t, games * t / threads, games * (t + 1) / threads);
+    for (auto& th : pool)
+        th.join();
+
+    auto cleanup = [&]() {
+        for (auto& path : runs)
+            std::remove(path.c_str());
+    };
+    if (failed) {
+        cleanup();
+        return 0;
+    }
+
+    // Phase 2 : k-way merge of all runs into the index, sampling a fence key every fence_interval entries
+    CHESS_TRACE_SPAN_ARG("merge", "runs", (int64_t) runs.size());
+    std::ofstream out(index_path, std::ios::binary | std::ios::trunc);
+    Index_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, INDEX_FILE_MAGIC, 8);
+    header.version = INDEX_FILE_VERSION;
+    header.fence_interval = std::max<uint32_t>(1, options.fence_interval);
+    out.write((const char*) &header, sizeof(header));
+
+    std::vector<Run_cursor*> cursors;
+    typedef std::pair<Index_entry, size_t> Head;
+    auto greater = [](const Head& a, const Head& b) { return b.first < a.first; };
+    std::priority_queue<Head, std::vector<Head>, decltype(greater)> heap(greater);
+    for (size_t r = 0; r < runs.size(); r++) {
+        cursors.push_back(new Run_cursor(runs[r]));
+        Index_entry entry;
+        if (cursors[r]->peek(entry))
+            heap.push({entry, r});
+    }
+
+    std::vector<Index_entry> out_buffer;
+    std::vector<uint64_t> fences;
+    out_buffer.reserve(MERGE_BUFFER_ENTRIES);
+    uint64_t written = 0;
+    while (!heap.empty()) {
+        auto [entry, r] = heap.top();
+        heap.pop();
+        if (written % header.fence_interval == 0)
+            fences.push_back(entry.key);
+        out_buffer.push_back(entry);
+        written++;
+        if (out_buffer.size() == MERGE_BUFFER_ENTRIES) {
+            out.write((const char*) out_buffer.data(), out_buffer.size() * sizeof(Index_entry));
+            out_buffer.clear();
+        }
+        cursors[r]->advance();
+        if (cursors[r]->peek(entry))
+            heap.push({entry, r});
+    }
+    out.write((const char*) out_buffer.data(), out_buffer.size() * sizeof(Index_entry));
+    out.write((const char*) fences.data(), fences.size() * sizeof(uint64_t));
+
+    header.entry_count = written;
+    header.fence_count = fences.size();
+    out.seekp(0);
+    out.write((const char*) &header, sizeof(header));
+    bool ok = (bool) out;
+    out.close();
+
+    for (auto cursor : cursors)
+        delete cursor;
+    cleanup();
+    return ok ? written : 0;
+}
+
+
+// ------------------------------------------------------------------------------ Index queries -------------------------------------------------------------------------
+
+Position_index::Position_index() : map(nullptr), map_size(0), entries(nullptr), entry_count(0), fence_interval(1) {}
+
+Position_index::~Position_index() {
+    close();
+}
+
+void Position_index::close() {
+    if (map)
+        munmap((void*) map, map_size);
+    map = nullptr;
+    map_size = 0;
+    entries = nullptr;
+    entry_count = 0;
+    fences.clear();
+}
+
+bool Position_index::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < INDEX_HEADER_SIZE) {
+        ::close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);                                        // Mapping stays valid after close
+    if (addr == MAP_FAILED)
+        return false;
+    map = (const uint8_t*) addr;
+    map_size = st.st_size;
+
+    Index_header header;
+    std::memcpy(&header, map, sizeof(header));
+    if (std::memcmp(header.magic, INDEX_FILE_MAGIC, 8) != 0 || header.version != INDEX_FILE_VERSION || header.fence_interval == 0
+        || INDEX_HEADER_SIZE + header.entry_count * sizeof(Index_entry) + header.fence_count * sizeof(uint64_t) != map_size) {
+        close();
+        return false;
+    }
+    entries = (const Index_entry*) (map + INDEX_HEADER_SIZE);
+    entry_count = header.entry_count;
+    fence_interval = header.fence_interval;
+    const uint8_t* fence_ptr = map + INDEX_HEADER_SIZE + entry_count * sizeof(Index_entry);
+    fences.resize(header.fence_count);
+    std::memcpy(fences.data(), fence_ptr, fences.size() * sizeof(uint64_t));
+    madvise((void*) map, map_size, MADV_RANDOM);       // Lookups jump around, readahead would be wasted
+    return true;
+}
+
+uint64_t Position_index::find(uint64_t key, std::vector<Index_entry>& out, uint64_t limit) {
+    if (!entries || entry_count == 0)
+        return 0;
+    // Fence b holds key of entry b * interval. First occurrence of key is after fence block (idx - 1) starts, and not after entry idx * interval
+    uint64_t idx = std::lower_bound(fences.begin(), fences.end(), key) - fences.begin();
+    uint64_t lo = (idx == 0) ? 0 : (idx - 1) * fence_interval;
+    uint64_t hi = std::min<uint64_t>(entry_count, idx * fence_interval);
+    const Index_entry* it = std::lower_bound(entries + lo, entries + hi, key,
+                                             [](const Index_entry& entry, uint64_t k) { return entry.key < k; });
+
+    uint64_t found = 0;
+    for (const Index_entry* end = entries + entry_count; it != end && it->key == key; it++) {
+        if (limit && found == limit) break;
+        out.push_back(*it);
+        found++;
+    }
+    return found;
+}
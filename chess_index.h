@@ -0,0 +1,75 @@
+#ifndef CHESS_INDEX_H
+#define CHESS_INDEX_H
+
+#include "chess_common.h"
+#include "chess_position.h"
+#include <cstdint>
+
+// Position search index : answers "which games reached this position" over a whole game-record archive (.cgr, see chess_record.h).
+//
+// Built offline : every game is replayed, and a (Zobrist key, game id, ply) entry is emitted for each position reached (including the
+// start position & the final one). Entries are sorted by key with an external merge sort, so the archive can be far bigger than RAM :
+// worker threads fill fixed-size buffers, sort them and spill them as runs, then all runs are k-way merged into the index file.
+//
+// Index file layout (native little endian, entries are read in place through mmap) :
+//   Header  : "CHESSIDX" | u32 version | u32 fence interval | u64 entry count | u64 fence count | padding up to 64 bytes
+//   Entries : Index_entry * entry count, sorted by (key, game, ply)
+//   Fences  : u64 * fence count, key of every fence-interval'th entry
+// Queries binary-search the fences (few KB per million entries, kept in RAM) to pick a single fence block, and then binary-search
+// inside that block of the mmap, so a lookup touches ~2 pages of the file.
+
+struct Index_entry {
+    uint64_t key;
+    uint32_t game;              // Game id = position of the game in the .cgr file
+    uint32_t ply;               // Number of moves played to reach the position
+
+    bool operator<(const Index_entry& other) const {
+        if (key != other.key) return key < other.key;
+        if (game != other.game) return game < other.game;
+        return ply < other.ply;
+    }
+};
+
+struct Index_build_options {
+    int threads;
+    uint64_t memory_budget;     // Bytes of entry buffers across all threads, each thread spills a run when its share is full
+    uint32_t fence_interval;
+    std::string temp_prefix;    // Run files are temp_prefix.run<N>, defaults to output path
+
+    Index_build_options() : threads(4), memory_budget(1ULL << 30), fence_interval(4096) {}
+};
+
+// Build the index of record_path into index_path. Returns number of entries written, 0 on failure
+uint64_t build_position_index(const std::string& record_path, const std::string& index_path, const Index_build_options& options = Index_build_options());
+
+// Read-only, memory mapped view of an index file
+class Position_index {
+    const uint8_t* map;
+    size_t map_size;
+    const Index_entry* entries;
+    uint64_t entry_count;
+    uint32_t fence_interval;
+    std::vector<uint64_t> fences;
+
+public:
+    Position_index();
+
+    ~Position_index();
+
+    bool open(const std::string& path);
+
+    void close();
+
+    uint64_t size() {
+        return entry_count;
+    }
+
+    // Appends all (game, ply) occurrences of the position with this key to out, returns count found. Limit 0 means no limit
+    uint64_t find(uint64_t key, std::vector<Index_entry>& out, uint64_t limit = 0);
+
+    uint64_t find(const Position& pos, std::vector<Index_entry>& out, uint64_t limit = 0) {
+        return find(pos.key, out, limit);
+    }
+};
+
+#endif
@@ -0,0 +1,207 @@
+#include "chess_mapped.h"
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const uint32_t Mapped_file::FORMAT_VERSION = 1;
+const size_t Mapped_file::HEADER_SIZE = 4096;
+
+namespace chess_ns {
+    const char MAPPED_MAGIC[8] = {'C','H','E','S','S','M','A','P'};
+
+    typedef enum mapped_state {
+        STATE_CLEAN = 0x434C454E,       // "CLEN"
+        STATE_OPEN = 0x4F50454E         // "OPEN", what a crashed process leaves behind
+    } Mapped_state;
+
+    struct Mapped_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t kind;
+        uint64_t salt;
+        uint64_t payload_size;
+        uint64_t checksum;
+        uint64_t user;
+        uint32_t state;
+    };
+
+    static_assert(sizeof(Mapped_header) <= 4096);
+
+    static uint64_t mix64(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t checksum64(const void* data, size_t bytes, uint64_t seed) {
+        const uint64_t PRIME = 0x9E3779B97F4A7C15ULL;
+        uint64_t lane[4] = {seed ^ 0x243F6A8885A308D3ULL, seed ^ 0x13198A2E03707344ULL, seed ^ 0xA4093822299F31D0ULL,
+                            seed ^ 0x082EFA98EC4E6C89ULL};
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        size_t i = 0;
+        for (; i + 32 <= bytes; i += 32) {
+            for (int l = 0; l < 4; l++) {
+                uint64_t w;
+                std::memcpy(&w, p + i + 8 * l, 8);
+                lane[l] = std::rotl(lane[l] ^ (w * PRIME), 29) * PRIME;
+            }
+        }
+        uint64_t h = bytes * PRIME;
+        for (int l = 0; l < 4; l++)
+            h = mix64(h ^ lane[l]);
+        for (; i < bytes; i++)
+            h = mix64(h ^ p[i]);
+        return h;
+    }
+}
+
+using namespace chess_ns;
+
+const char* mapped_status_name(Mapped_status status) {
+    switch (status) {
+        case MAPPED_WARM: return "warm";
+        case MAPPED_NEW: return "new";
+        case MAPPED_STALE: return "stale";
+        case MAPPED_CORRUPT: return "corrupt";
+        case MAPPED_BUSY: return "busy";
+        default: return "failed";
+    }
+}
+
+Mapped_file::Mapped_file() : fd(-1), map(nullptr), map_size(0), writable(false) {}
+
+Mapped_file::~Mapped_file() {
+    close();
+}
+
+Mapped_status Mapped_file::open(const std::string& path, uint32_t kind, uint64_t salt, size_t payload_size) {
+    close();
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return MAPPED_FAILED;
+    // Two processes sharing one file would each think they own it, the second one goes without
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        release();
+        return MAPPED_BUSY;
+    }
+    auto fail = [&](Mapped_status status) {
+        release();
+        return status;
+    };
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+        return fail(MAPPED_FAILED);
+    size_t size = HEADER_SIZE + payload_size;
+    Mapped_header header;
+    Mapped_status status = MAPPED_WARM;
+    if (st.st_size == 0)
+        status = MAPPED_NEW;
+    else if ((size_t) st.st_size < HEADER_SIZE || pread(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header)
+             || std::memcmp(header.magic, MAPPED_MAGIC, 8) != 0)
+        status = MAPPED_CORRUPT;
+    else if (header.version != FORMAT_VERSION || header.kind != kind || header.salt != salt || header.payload_size != payload_size
+             || (size_t) st.st_size != size)
+        status = MAPPED_STALE;
+    else if (header.state != STATE_CLEAN)
+        status = MAPPED_CORRUPT;
+
+    // Started over : truncating first drops the old contents, so the payload reads as zeros (and stays sparse until written)
+    if (status != MAPPED_WARM && (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0))
+        return fail(MAPPED_FAILED);
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+        return fail(MAPPED_FAILED);
+    map = static_cast<uint8_t*>(addr);
+    map_size = size;
+    if (status == MAPPED_WARM && checksum64(payload(), payload_size) != header.checksum) {
+        status = MAPPED_CORRUPT;
+        std::memset(payload(), 0, payload_size);
+    }
+
+    // Marked open on disk before the owner writes anything, so a crash from here on leaves a file that won't be trusted
+    Mapped_header* h = reinterpret_cast<Mapped_header*>(map);
+    if (status != MAPPED_WARM) {
+        std::memset(h, 0, sizeof(Mapped_header));
+        std::memcpy(h->magic, MAPPED_MAGIC, 8);
+        h->version = FORMAT_VERSION;
+        h->kind = kind;
+        h->salt = salt;
+        h->payload_size = payload_size;
+    }
+    h->state = STATE_OPEN;
+    if (msync(map, HEADER_SIZE, MS_SYNC) != 0)
+        return fail(MAPPED_FAILED);
+    writable = true;
+    return status;
+}
+
+Mapped_status Mapped_file::open_readonly(const std::string& path, uint32_t kind, uint64_t salt, bool verify) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return MAPPED_FAILED;
+    auto fail = [&](Mapped_status status) {
+        release();
+        return status;
+    };
+
+    struct stat st;
+    Mapped_header header;
+    if (fstat(fd, &st) != 0)
+        return fail(MAPPED_FAILED);
+    if ((size_t) st.st_size < HEADER_SIZE || pread(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header)
+        || std::memcmp(header.magic, MAPPED_MAGIC, 8) != 0 || header.state != STATE_CLEAN)
+        return fail(MAPPED_CORRUPT);
+    if (header.version != FORMAT_VERSION || header.kind != kind || header.salt != salt
+        || (size_t) st.st_size != HEADER_SIZE + header.payload_size)
+        return fail(MAPPED_STALE);
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+        return fail(MAPPED_FAILED);
+    map = static_cast<uint8_t*>(addr);
+    map_size = st.st_size;
+    if (verify && checksum64(payload(), header.payload_size) != header.checksum)
+        return fail(MAPPED_CORRUPT);
+    writable = false;
+    return MAPPED_WARM;
+}
+
+bool Mapped_file::close(uint64_t user) {
+    if (!map)
+        return false;
+    if (!writable) {
+        release();
+        return true;
+    }
+    Mapped_header* h = reinterpret_cast<Mapped_header*>(map);
+    h->checksum = checksum64(payload(), payload_size());
+    h->user = user;
+    // Payload on disk first, the clean mark only once it's all there
+    bool ok = msync(map + HEADER_SIZE, payload_size(), MS_SYNC) == 0;
+    if (ok) {
+        h->state = STATE_CLEAN;
+        ok = msync(map, HEADER_SIZE, MS_SYNC) == 0;
+    }
+    release();
+    return ok;
+}
+
+void Mapped_file::release() {
+    if (map)
+        munmap(map, map_size);
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+    map = nullptr;
+    map_size = 0;
+    writable = false;
+}
+
+uint64_t Mapped_file::user() const {
+    return map ? reinterpret_cast<const Mapped_header*>(map)->user : 0;
+}
@@ -0,0 +1,82 @@
+#ifndef CHESS_MAPPED_H
+#define CHESS_MAPPED_H
+
+#include "chess_common.h"
+#include <cstdint>
+#include <string>
+
+// Table backed by a memory-mapped file, so its contents outlive the process : hash tables come back warm after a restart.
+//
+// File layout (native endianness) : one header page, then the payload, which the owner uses in place through the mapping.
+//   Header : "CHESSMAP" | u32 format version | u32 kind | u64 salt | u64 payload size | u64 checksum | u64 user | u32 state
+// kind tells tables apart ('T','T','A','B' ...), salt is whatever the contents depend on beyond their layout (Zobrist keys, eval
+// terms) : a file written by a build where either differs is stale, not reused. The checksum covers the payload and is only written
+// on a clean close() ; while a file is open its state says so, so one left behind by a crash is never trusted.
+// Anything that isn't a clean, matching file (missing, stale, corrupt, locked by another process, can't be mapped) is started over
+// empty : the owner is told why, and falls back to plain memory if there's no mapping at all.
+
+typedef enum mapped_status {
+    MAPPED_WARM,                        // Previous contents are valid
+    MAPPED_NEW,                         // No file yet (or empty), created
+    MAPPED_STALE,                       // Different version, kind, salt or size : started over
+    MAPPED_CORRUPT,                     // Bad header or checksum, or not closed cleanly : started over
+    MAPPED_BUSY,                        // Another process has it open, not mapped
+    MAPPED_FAILED                       // Couldn't create / size / map the file, not mapped
+} Mapped_status;
+
+const char* mapped_status_name(Mapped_status status);
+
+namespace chess_ns {
+    // Order-dependent 64-bit checksum (4 independent lanes, so it runs at memory speed)
+    uint64_t checksum64(const void* data, size_t bytes, uint64_t seed = 0);
+}
+
+class Mapped_file {
+    int fd;
+    uint8_t* map;
+    size_t map_size;
+    bool writable;
+
+    // Unmaps & closes, nothing written
+    void release();
+
+public:
+    static const uint32_t FORMAT_VERSION;
+    static const size_t HEADER_SIZE;            // Payload starts one page in, so it's page (and cache line) aligned
+
+    Mapped_file();
+
+    ~Mapped_file();                             // close() if still open
+
+    Mapped_file(const Mapped_file&) = delete;
+    Mapped_file& operator=(const Mapped_file&) = delete;
+
+    // Maps path read-write with a payload of payload_size bytes, taking an exclusive lock on the file. Unless the result is
+    // MAPPED_WARM the payload is zero-filled, for the caller to initialize. MAPPED_BUSY / MAPPED_FAILED leave nothing open
+    Mapped_status open(const std::string& path, uint32_t kind, uint64_t salt, size_t payload_size);
+
+    // Maps a finished file read-only (many processes can share it), for tables written once & read from then on. Anything but
+    // MAPPED_WARM leaves nothing open. verify = false skips the checksum pass over the payload, for files far bigger than RAM
+    Mapped_status open_readonly(const std::string& path, uint32_t kind, uint64_t salt, bool verify = true);
+
+    // Checksums the payload, marks the file clean with user (owner's own small state, e.g. a generation counter) and unmaps it.
+    // Read-only mappings are just unmapped
+    bool close(uint64_t user = 0);
+
+    bool is_open() const {
+        return map != nullptr;
+    }
+
+    void* payload() const {
+        return map ? map + HEADER_SIZE : nullptr;
+    }
+
+    size_t payload_size() const {
+        return map ? map_size - HEADER_SIZE : 0;
+    }
+
+    // What the last clean close() stored, 0 for a file that wasn't warm
+    uint64_t user() const;
+};
+
+#endif
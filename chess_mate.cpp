@@ -0,0 +1,249 @@
+#include "chess_mate.h"
+#include <algorithm>
+#include <cstring>
+
+static const uint32_t INF = 1u << 30;
+
+// Saturating : anything reaching INF is a real proof / disproof, a plain large sum stays just under it
+static uint32_t add(uint32_t a, uint32_t b) {
+    if (a >= INF || b >= INF)
+        return INF;
+    return std::min(a + b, INF - 1);
+}
+
+// Table keys tell apart the same position with a different number of attacker moves left, or the other side attacking
+static constexpr int MAX_MATE_MOVES = 127;
+static constexpr auto NODE_SALT = [] {
+    std::array<uint64_t, 2 * (MAX_MATE_MOVES + 1)> t{};
+    uint64_t state = 0x6A09E667F3BCC908ULL;
+    for (auto& salt : t)
+        salt = chess_ns::splitmix64(state);
+    return t;
+}();
+
+static uint64_t node_key(const Position& pos, bool attacker, int moves_left) {
+    uint64_t key = pos.key ^ NODE_SALT[2 * moves_left + attacker];
+    return key ? key : 1;                       // 0 marks empty slots
+}
+
+Mate_solver::Mate_solver(size_t table_mb) : nodes(0), node_limit(0), aborted(false) {
+    size_t buckets = 1;
+    while (2 * buckets * BUCKET * sizeof(Entry) <= std::max<size_t>(table_mb, 1) << 20)
+        buckets *= 2;
+    table.resize(buckets * BUCKET);
+    bucket_mask = buckets - 1;
+    clear();
+}
+
+void Mate_solver::clear() {
+    std::fill(table.begin(), table.end(), Entry{0, 0, 0, 0, 0, 0});
+}
+
+Mate_solver::Entry* Mate_solver::probe(uint64_t key) {
+    Entry* bucket = &table[(key & bucket_mask) * BUCKET];
+    for (int i = 0; i < BUCKET; i++)
+        if (bucket[i].key == key)
+            return &bucket[i];
+    return nullptr;
+}
+
+void Mate_solver::store(uint64_t key, uint32_t pn, uint32_t dn, uint16_t distance, uint32_t work) {
+    Entry* bucket = &table[(key & bucket_mask) * BUCKET];
+    Entry* slot = &bucket[0];
+    for (int i = 0; i < BUCKET; i++) {
+        if (bucket[i].key == key || bucket[i].key == 0) {
+            slot = &bucket[i];
+            break;
+        }
+        if (bucket[i].work < slot->work)
+            slot = &bucket[i];
+    }
+    *slot = Entry{key, pn, dn, work, distance, 0};
+}
+
+// Attacker : legal checking moves only (the solver proves mates by checks). Defender : every legal move
+int Mate_solver::children(const Position& pos, bool attacker, Move16* list) const {
+    int n = pos.generate_moves(list);
+    if (!attacker)
+        return n;
+    int checks = 0;
+    for (int i = 0; i < n; i++) {
+        Position next = pos;
+        next.play(list[i]);
+        if (next.in_check())
+            list[checks++] = list[i];
+    }
+    return checks;
+}
+
+void Mate_solver::mid(const Position& pos, bool attacker, int moves_left, uint32_t pn_threshold, uint32_t dn_threshold) {
+    nodes++;
+    uint64_t key = node_key(pos, attacker, moves_left);
+    Move16 list[MAX_MOVES];
+    int n = (attacker && moves_left == 0) ? 0 : children(pos, attacker, list);
+    if (n == 0) {
+        // Out of checks (or moves left) : no mate this way. Defender without moves : mated, or stalemate
+        if (!attacker && pos.in_check())
+            store(key, 0, INF, 0, 1);
+        else
+            store(key, INF, 0, 0, 1);
+        return;
+    }
+
+    int child_moves_left = attacker ? moves_left - 1 : moves_left;
+    uint64_t child_keys[MAX_MOVES], position_keys[MAX_MOVES];
+    for (int i = 0; i < n; i++) {
+        Position next = pos;
+        next.play(list[i]);
+        position_keys[i] = next.key;
+        child_keys[i] = node_key(next, !attacker, child_moves_left);
+    }
+
+    uint64_t start_nodes = nodes;
+    uint32_t pn = 1, dn = 1;
+    uint16_t distance = 0;
+    path.push_back(pos.key);
+    while (true) {
+        // Current numbers from the children. Unseen ones count 1 / 1, ones repeating a position on the current line are no win
+        int best = -1;
+        uint32_t best_value = INF + 1, second_value = INF + 1, best_pn = 0, best_dn = 0;
+        uint16_t mate_min = UINT16_MAX, mate_max = 0;
+        pn = attacker ? INF : 0;
+        dn = attacker ? 0 : INF;
+        for (int i = 0; i < n; i++) {
+            uint32_t cpn = 1, cdn = 1;
+            if (std::find(path.begin(), path.end(), position_keys[i]) != path.end()) {
+                cpn = INF;
+                cdn = 0;
+            }
+            else if (const Entry* e = probe(child_keys[i])) {
+                cpn = e->pn;
+                cdn = e->dn;
+                if (cpn == 0) {
+                    mate_min = std::min(mate_min, e->distance);
+                    mate_max = std::max(mate_max, e->distance);
+                }
+            }
+            uint32_t value = attacker ? cpn : cdn;
+            if (attacker) {
+                pn = std::min(pn, cpn);
+                dn = add(dn, cdn);
+            }
+            else {
+                pn = add(pn, cpn);
+                dn = std::min(dn, cdn);
+            }
+            if (value < best_value) {
+                second_value = best_value;
+                best_value = value;
+                best = i;
+                best_pn = cpn;
+                best_dn = cdn;
+            }
+            else if (value < second_value)
+                second_value = value;
+        }
+        if (pn == 0)
+            distance = (uint16_t) (1 + (attacker ? mate_min : mate_max));
+        if (pn >= pn_threshold || dn >= dn_threshold || aborted)
+            break;
+
+        // Dive into the most proving child, until it stops being the most proving one (the second best plus one)
+        uint32_t child_pn, child_dn;
+        if (attacker) {
+            child_pn = std::min(pn_threshold, add(second_value, 1));
+            child_dn = add(dn_threshold - dn, best_dn);
+        }
+        else {
+            child_pn = add(pn_threshold - pn, best_pn);
+            child_dn = std::min(dn_threshold, add(second_value, 1));
+        }
+        Position next = pos;
+        next.play(list[best]);
+        mid(next, !attacker, child_moves_left, child_pn, child_dn);
+        if (node_limit && nodes >= node_limit)
+            aborted = true;
+    }
+    path.pop_back();
+    uint64_t work = nodes - start_nodes + 1;
+    store(key, pn, dn, distance, (uint32_t) std::min<uint64_t>(work, UINT32_MAX));
+}
+
+Mate_outcome Mate_solver::prove(const Position& root, int max_moves) {
+    path.clear();
+    aborted = false;
+    mid(root, true, max_moves, INF, INF);
+    const Entry* e = probe(node_key(root, true, max_moves));
+    if (aborted || !e)
+        return MATE_UNKNOWN;
+    return (e->pn == 0) ? MATE_PROVEN : (e->dn == 0) ? MATE_DISPROVEN : MATE_UNKNOWN;
+}
+
+bool Mate_solver::proven(const Position& pos, bool attacker, int moves_left) {
+    uint64_t key = node_key(pos, attacker, moves_left);
+    const Entry* e = probe(key);
+    if (!e || (e->pn != 0 && e->dn != 0)) {
+        // Never searched, replaced since, or only partly searched : settle it
+        path.clear();
+        aborted = false;
+        mid(pos, attacker, moves_left, INF, INF);
+        e = probe(key);
+    }
+    return e && e->pn == 0;
+}
+
+// Proof distances are only upper bounds (a node is proven by the first mate found under it, not the quickest), so the line is built
+// on exact mate lengths instead : the attacker plays a check that still mates in the moves left, the defender the reply that holds
+// out longest
+void Mate_solver::extract_line(Position pos, int moves, std::vector<Move16>& line) {
+    Move16 list[MAX_MOVES], replies[MAX_MOVES];
+    while (moves > 0) {
+        int n = children(pos, true, list), pick = -1;
+        for (int i = 0; i < n && pick < 0; i++) {
+            Position next = pos;
+            next.play(list[i]);
+            if (proven(next, false, moves - 1))
+                pick = i;
+        }
+        if (pick < 0)
+            return;                                 // Can't happen for a proven node
+        line.push_back(list[pick]);
+        pos.play(list[pick]);
+
+        int r = children(pos, false, replies), longest = -1, longest_moves = 0;
+        for (int i = 0; i < r; i++) {
+            Position next = pos;
+            next.play(replies[i]);
+            int m = 1;
+            while (m < moves && !proven(next, true, m))
+                m++;
+            if (m > longest_moves) {
+                longest = i;
+                longest_moves = m;
+            }
+        }
+        if (longest < 0)
+            return;                                 // Mated
+        line.push_back(replies[longest]);
+        pos.play(replies[longest]);
+        moves = longest_moves;
+    }
+}
+
+Mate_result Mate_solver::solve(const Position& root, const Mate_limits& limits) {
+    Mate_result result;
+    nodes = 0;
+    node_limit = limits.nodes;
+    int max_moves = std::max(1, std::min(limits.max_moves, MAX_MATE_MOVES));
+    result.outcome = prove(root, max_moves);
+    if (result.outcome == MATE_PROVEN) {
+        result.mate_in = (probe(node_key(root, true, max_moves))->distance + 1) / 2;
+        // A proof within N moves may still take more than the shortest mate
+        while (limits.shortest && result.mate_in > 1 && prove(root, result.mate_in - 1) == MATE_PROVEN)
+            result.mate_in = (probe(node_key(root, true, result.mate_in - 1))->distance + 1) / 2;
+        node_limit = 0;                             // Line of a proven mate, whatever it takes
+        extract_line(root, result.mate_in, result.line);
+    }
+    result.nodes = nodes;
+    return result;
+}
@@ -0,0 +1,82 @@
+#ifndef CHESS_MATE_H
+#define CHESS_MATE_H
+
+#include "chess_common.h"
+#include "chess_position.h"
+
+// Forced mate solver : depth-first proof-number search (df-pn, Nagai 2002). Proves or refutes "side to move mates within max_moves",
+// rather than scoring positions like Search does. The attacker only ever considers checking moves, the defender all of its moves.
+// Proof / disproof numbers live in the solver's own fixed-size table (separate from Search's hash table), so memory stays bounded
+// whatever the puzzle ; when it fills up the entries that took the least work to compute get replaced.
+//
+// Proofs are depth-bounded : a table entry belongs to a (position, moves left) pair, so a mate within N moves is never mixed up with
+// a longer one. By default the solver then keeps asking for one move less, so the line it returns is a shortest mate.
+
+struct Mate_limits {
+    int max_moves;                      // Attacker moves, mate in N
+    uint64_t nodes;                     // 0 = no limit
+    bool shortest;                      // Look for shorter mates once one is proven
+
+    Mate_limits(int max_moves = 5) : max_moves(max_moves), nodes(0), shortest(true) {}
+};
+
+typedef enum mate_outcome {
+    MATE_PROVEN,
+    MATE_DISPROVEN,                     // No mate within max_moves (checks only for the attacker, so quiet-move mates aren't found)
+    MATE_UNKNOWN                        // Node limit hit first
+} Mate_outcome;
+
+struct Mate_result {
+    Mate_outcome outcome;
+    int mate_in;                        // Attacker moves, if proven
+    std::vector<Move16> line;           // Full line, both sides, ending in mate
+    uint64_t nodes;
+
+    Mate_result() : outcome(MATE_UNKNOWN), mate_in(0), nodes(0) {}
+};
+
+class Mate_solver {
+public:
+    // One table slot : 24 bytes
+    struct Entry {
+        uint64_t key;                   // Position key mixed with moves left, 0 = empty
+        uint32_t pn, dn;                // Proof & disproof numbers
+        uint32_t work;                  // Nodes spent under this entry (saturating), replacement priority
+        uint16_t distance;              // Plies to mate, once proven
+        uint16_t unused;
+    };
+
+    Mate_solver(size_t table_mb = 16);
+
+    Mate_result solve(const Position& root, const Mate_limits& limits = Mate_limits());
+
+    void clear();
+
+private:
+    static const int BUCKET = 4;        // Entries probed per key
+
+    std::vector<Entry> table;
+    size_t bucket_mask;
+    uint64_t nodes, node_limit;
+    bool aborted;
+    std::vector<uint64_t> path;         // Position keys on the current line, repetitions aren't wins
+
+    Entry* probe(uint64_t key);
+
+    void store(uint64_t key, uint32_t pn, uint32_t dn, uint16_t distance, uint32_t work);
+
+    // Expand pos (an OR node if the attacker is to move, else an AND node) until its proof or disproof number reaches its threshold
+    void mid(const Position& pos, bool attacker, int moves_left, uint32_t pn_threshold, uint32_t dn_threshold);
+
+    // Whether the node is proven, searching it to the end if the table doesn't say
+    bool proven(const Position& pos, bool attacker, int moves_left);
+
+    // Mating line from pos (attacker to move, shortest mate takes moves)
+    void extract_line(Position pos, int moves, std::vector<Move16>& line);
+
+    int children(const Position& pos, bool attacker, Move16* list) const;
+
+    Mate_outcome prove(const Position& root, int max_moves);
+};
+
+#endif
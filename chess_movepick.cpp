@@ -0,0 +1,166 @@
+#include "chess_movepick.h"
+#include "chess_eval.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// ------------------------------------------------------------------------------ Move order tables ---------------------------------------------------------------------
+
+const int Move_order::HISTORY_MAX = 1 << 14;
+
+void Move_order::clear() {
+    std::memset(killers, 0, sizeof(killers));
+    std::memset(history, 0, sizeof(history));
+    std::memset(counter_moves, 0, sizeof(counter_moves));
+}
+
+Move16 Move_order::counter_move(const Position& pos, Move16 prev) const {
+    if (prev.is_null())
+        return Move16();
+    int dst = prev.dst();
+    return counter_moves[pos.color_on(dst)][pos.piece_on(dst)][dst];
+}
+
+void Move_order::update_quiet(const Position& pos, Move16 best_move, const Move16* tried, int tried_count, int depth, int ply, Move16 prev) {
+    int bonus = std::min(depth * depth, 400);
+    Color us = pos.turn;
+    // Gravity : the closer an entry is to HISTORY_MAX, the less it moves, so scores stay bounded and old knowledge fades
+    auto update = [&](Move16 move, int delta) {
+        int& h = history[us][move.src()][move.dst()];
+        h += delta - h * std::abs(delta) / HISTORY_MAX;
+    };
+    update(best_move, bonus);
+    for (int i = 0; i < tried_count; i++)
+        if (tried[i] != best_move)
+            update(tried[i], -bonus);
+
+    if (killers[ply][0] != best_move) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = best_move;
+    }
+    if (!prev.is_null()) {
+        int dst = prev.dst();
+        counter_moves[pos.color_on(dst)][pos.piece_on(dst)][dst] = best_move;
+    }
+}
+
+
+// ------------------------------------------------------------------------------ Move picker ---------------------------------------------------------------------------
+
+Move_picker::Move_picker(const Position& pos, Move16 tt_move, const Move_order& order, int ply, Move16 counter) :
+    pos(pos), order(order), tt_move(tt_move), counter(counter), stage(TT_MOVE), quiescence(false), prune_losing(false), cur(0), end(0), end_captures(0), end_bad(0) {
+    killers[0] = order.killers[ply][0];
+    killers[1] = order.killers[ply][1];
+    if (!pos.is_pseudo_legal(tt_move))
+        this->tt_move = Move16();
+}
+
+Move_picker::Move_picker(const Position& pos, const Move_order& order, bool prune_losing) :
+    pos(pos), order(order), stage(GEN_CAPTURES), quiescence(true), prune_losing(prune_losing), cur(0), end(0), end_captures(0), end_bad(0) {}
+
+bool Move_picker::is_quiet(Move16 move) const {
+    return pos.piece_on(move.dst()) == PIECE_MAX && move.flag() != Move16::PROMOTION && move.flag() != Move16::EN_PASSANT;
+}
+
+Move16 Move_picker::pick_best() {
+    int best = cur;
+    for (int i = cur + 1; i < end; i++)
+        if (scores[i] > scores[best])
+            best = i;
+    std::swap(moves[cur], moves[best]);
+    std::swap(scores[cur], scores[best]);
+    return moves[cur++];
+}
+
+Move16 Move_picker::next() {
+    // Each case falls through into the next stage once it has nothing (more) to return
+    switch (stage) {
+        case TT_MOVE:
+            stage = GEN_CAPTURES;
+            if (!tt_move.is_null())
+                return tt_move;
+            [[fallthrough]];
+
+        case GEN_CAPTURES:
+            cur = 0;
+            end = pos.generate_pseudo(moves, CAPTURES);
+            for (int i = 0; i < end; i++) {
+                // MVV-LVA : most valuable victim first, least valuable attacker as tie-break. Promotions count the gained material
+                Move16 m = moves[i];
+                int victim = (m.flag() == Move16::EN_PASSANT) ? PIECE_VALUE[PAWN]
+                           : (pos.piece_on(m.dst()) == PIECE_MAX) ? 0 : PIECE_VALUE[pos.piece_on(m.dst())];
+                if (m.flag() == Move16::PROMOTION)
+                    victim += PIECE_VALUE[m.promo()] - PIECE_VALUE[PAWN];
+                scores[i] = 10 * victim - PIECE_VALUE[pos.piece_on(m.src())];
+            }
+            end_captures = end;
+            stage = GOOD_CAPTURES;
+            [[fallthrough]];
+
+        case GOOD_CAPTURES:
+            while (cur < end) {
+                Move16 m = pick_best();
+                if (m == tt_move)
+                    continue;
+                if (see(pos, m) >= 0)
+                    return m;
+                moves[end_bad++] = m;                   // Losing capture, keep it for after the quiets (cur > end_bad always)
+            }
+            if (quiescence) {
+                cur = 0;
+                stage = prune_losing ? DONE : BAD_CAPTURES;
+                return next();
+            }
+            stage = KILLER_1;
+            [[fallthrough]];
+
+        case KILLER_1:
+            stage = KILLER_2;
+            if (killers[0] != tt_move && is_quiet(killers[0]) && pos.is_pseudo_legal(killers[0]))
+                return killers[0];
+            killers[0] = Move16();
+            [[fallthrough]];
+
+        case KILLER_2:
+            stage = COUNTER_MOVE;
+            if (killers[1] != tt_move && killers[1] != killers[0] && is_quiet(killers[1]) && pos.is_pseudo_legal(killers[1]))
+                return killers[1];
+            killers[1] = Move16();
+            [[fallthrough]];
+
+        case COUNTER_MOVE:
+            stage = GEN_QUIETS;
+            if (counter != tt_move && counter != killers[0] && counter != killers[1] && is_quiet(counter) && pos.is_pseudo_legal(counter))
+                return counter;
+            counter = Move16();
+            [[fallthrough]];
+
+        case GEN_QUIETS:
+            cur = end_captures;
+            end = end_captures + pos.generate_pseudo(moves + end_captures, QUIETS);
+            for (int i = cur; i < end; i++)
+                scores[i] = order.history[pos.turn][moves[i].src()][moves[i].dst()];
+            stage = QUIET_MOVES;
+            [[fallthrough]];
+
+        case QUIET_MOVES:
+            while (cur < end) {
+                Move16 m = pick_best();
+                if (!is_special(m))
+                    return m;
+            }
+            cur = 0;
+            stage = BAD_CAPTURES;
+            [[fallthrough]];
+
+        case BAD_CAPTURES:
+            if (cur < end_bad)
+                return moves[cur++];                    // Already in MVV-LVA order
+            stage = DONE;
+            [[fallthrough]];
+
+        case DONE:
+            return Move16();
+    }
+    return Move16();
+}
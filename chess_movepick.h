@@ -0,0 +1,108 @@
+#ifndef CHESS_MOVEPICK_H
+#define CHESS_MOVEPICK_H
+
+#include "chess_common.h"
+#include "chess_position.h"
+
+constexpr int MAX_PLY = 128;
+
+// Ordering heuristics learned during a search, shared by all nodes of one Search :
+// killers (quiet moves that caused a cutoff at the same ply), history (cutoff counts per color/src/dst, with gravity so that it
+// adapts), counter moves (quiet reply that refuted the opponent's previous move, indexed by that move's piece & dst)
+struct Move_order {
+    Move16 killers[MAX_PLY][2];
+    int history[Color::MAX][SQUARE_MAX][SQUARE_MAX];
+    Move16 counter_moves[Color::MAX][PIECE_MAX][SQUARE_MAX];
+
+    const static int HISTORY_MAX;
+
+    void clear();
+
+    // Counter move stored for the opponent's last move prev (played into pos), null if none
+    Move16 counter_move(const Position& pos, Move16 prev) const;
+
+    // Quiet best_move caused a beta cutoff : reward it, and penalize the quiets tried before it
+    void update_quiet(const Position& pos, Move16 best_move, const Move16* tried, int tried_count, int depth, int ply, Move16 prev);
+};
+
+// Ordering quality, to be tuned against effective branching factor. Cutoff index is the position of the cutoff move among the legal
+// moves searched at that node (0 = first move). A well ordered search has ~90% first-move cutoffs.
+struct Ordering_stats {
+    uint64_t cutoffs;
+    uint64_t first_move_cutoffs;
+    uint64_t cutoff_index_sum;
+
+    Ordering_stats() {
+        clear();
+    }
+
+    void clear() {
+        cutoffs = first_move_cutoffs = cutoff_index_sum = 0;
+    }
+
+    void record_cutoff(int index) {
+        cutoffs++;
+        first_move_cutoffs += (index == 0);
+        cutoff_index_sum += index;
+    }
+
+    double first_move_rate() const {
+        return cutoffs ? (double) first_move_cutoffs / cutoffs : 0.0;
+    }
+
+    double average_cutoff_index() const {
+        return cutoffs ? (double) cutoff_index_sum / cutoffs : 0.0;
+    }
+};
+
+// Staged, lazy move picker. Yields pseudo-legal moves (caller checks legality) in the order :
+//   hash table move -> winning / equal captures & promotions by MVV-LVA -> killers -> counter move -> quiets by history
+//   -> losing captures (SEE < 0)
+// Each stage is only generated when reached, so on a cutoff by the hash move / a capture the quiets are never generated at all.
+// SEE is only computed for a capture when it is about to be returned, not for the whole list.
+// In quiescence mode, only captures & promotions are returned, and losing ones are pruned if asked to.
+class Move_picker {
+    typedef enum stage {
+        TT_MOVE,
+        GEN_CAPTURES,
+        GOOD_CAPTURES,
+        KILLER_1,
+        KILLER_2,
+        COUNTER_MOVE,
+        GEN_QUIETS,
+        QUIET_MOVES,
+        BAD_CAPTURES,
+        DONE
+    } Stage;
+
+    const Position& pos;
+    const Move_order& order;
+    Move16 tt_move, killers[2], counter;
+    Stage stage;
+    bool quiescence, prune_losing;
+    Move16 moves[MAX_MOVES];
+    int scores[MAX_MOVES];
+    int cur, end;
+    int end_captures, end_bad;          // Captures are in [0, end_captures), losing ones get moved down to [0, end_bad)
+
+    // Swap the best scored move in [cur, end) to cur and return it
+    Move16 pick_best();
+
+    // Already returned by one of the single-move stages
+    bool is_special(Move16 move) const {
+        return move == tt_move || move == killers[0] || move == killers[1] || move == counter;
+    }
+
+    bool is_quiet(Move16 move) const;
+
+public:
+    Move_picker(const Position& pos, Move16 tt_move, const Move_order& order, int ply, Move16 counter);
+
+    // Quiescence search picker : captures & promotions only, no hash move. Losing captures (SEE < 0) are dropped if prune_losing
+    Move_picker(const Position& pos, const Move_order& order, bool prune_losing = true);
+
+    // Next move, or null move once all are exhausted
+    Move16 next();
+};
+
+#endif
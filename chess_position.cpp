@@ -0,0 +1,605 @@
+#include "chess_position.h"
+#include "chess_stats.h"
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+// Castle rights bits left after a move touches a square (king or rook leaving / rook getting captured)
+static constexpr auto CASTLE_MASK = [] {
+    std::array<uint8_t, SQUARE_MAX> t{};
+    for (int sq = 0; sq < SQUARE_MAX; sq++) t[sq] = 0xF;
+    for (int c = WHITE; c < Color::MAX; c++) {
+        int r = (c == WHITE) ? 0 : 7;
+        t[square(r, 4)] &= ~(3 << (2 * c));
+        t[square(r, 7)] &= ~(1 << (2 * c + SHORT));
+        t[square(r, 0)] &= ~(1 << (2 * c + LONG));
+    }
+    return t;
+}();
+
+static const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+void Position::clear() {
+    std::memset(this, 0, sizeof(Position));
+    std::memset(cells, PIECE_MAX, sizeof(cells));
+    turn = WHITE;
+    ep_square = -1;
+    fullmove = 1;
+}
+
+void Position::set_start() {
+    set_fen(START_FEN);
+}
+
+void Position::put_piece(Color c, Piece_index p, int sq) {
+    by_type[p] |= bit(sq);
+    by_color[c] |= bit(sq);
+    cells[sq] = (uint8_t) ((c << 3) | p);
+    key ^= chess_ns::ZOBRIST.piece[c][p][sq];
+    if (p == PAWN)
+        pawn_key ^= chess_ns::PAWN_ZOBRIST[c][sq];
+}
+
+void Position::remove_piece(int sq) {
+    key ^= chess_ns::ZOBRIST.piece[color_on(sq)][piece_on(sq)][sq];
+    if (piece_on(sq) == PAWN)
+        pawn_key ^= chess_ns::PAWN_ZOBRIST[color_on(sq)][sq];
+    by_type[piece_on(sq)] &= ~bit(sq);
+    by_color[color_on(sq)] &= ~bit(sq);
+    cells[sq] = PIECE_MAX;
+}
+
+bool Position::set_fen(const std::string& fen) {
+    clear();
+    size_t i = 0;
+    // Piece placement, rank 8 first
+    int rank = 7, file = 0;
+    for (; i < fen.size() && fen[i] != ' '; i++) {
+        char ch = fen[i];
+        if (ch == '/') {
+            if (file != 8 || rank == 0) { clear(); return false; }
+            rank--; file = 0;
+        }
+        else if (ch >= '1' && ch <= '8')
+            file += ch - '0';
+        else {
+            Piece_index p = (std::tolower(ch) == 'p') ? PAWN : piece_index((char) std::toupper(ch));
+            if (p == PIECE_MAX || file > 7) { clear(); return false; }
+            put_piece(std::isupper(ch) ? WHITE : BLACK, p, square(rank, file++));
+        }
+        if (file > 8) { clear(); return false; }
+    }
+    if (rank != 0 || file != 8 || popcount(pieces(WHITE, KING)) != 1 || popcount(pieces(BLACK, KING)) != 1) {
+        clear();
+        return false;
+    }
+
+    // Remaining fields are optional, defaulting to white to move, no castling, no ep
+    auto next_field = [&]() {
+        while (i < fen.size() && fen[i] == ' ') i++;
+        size_t start = i;
+        while (i < fen.size() && fen[i] != ' ') i++;
+        return fen.substr(start, i - start);
+    };
+    std::string field = next_field();
+    if (field == "b") turn = BLACK;
+    else if (!field.empty() && field != "w") { clear(); return false; }
+
+    field = next_field();
+    for (char ch : field) {
+        switch (ch) {
+            case 'K': castle_rights |= 1 << (2 * WHITE + SHORT); break;
+            case 'Q': castle_rights |= 1 << (2 * WHITE + LONG); break;
+            case 'k': castle_rights |= 1 << (2 * BLACK + SHORT); break;
+            case 'q': castle_rights |= 1 << (2 * BLACK + LONG); break;
+            case '-': break;
+            default: clear(); return false;
+        }
+    }
+    // Drop rights that don't match actual king / rook placement, so that move generation can trust them
+    for (int sq : {0, 4, 7, 56, 60, 63}) {
+        Piece_index expected = (file_of(sq) == 4) ? KING : ROOK;
+        Color c = (sq < 8) ? WHITE : BLACK;
+        if (piece_on(sq) != expected || color_on(sq) != c)
+            castle_rights &= CASTLE_MASK[sq];
+    }
+
+    field = next_field();
+    // Only kept if a double push could have made it : right rank for the side to move, the pushed pawn in front of it, the square
+    // itself & the one the pawn came from empty, and a pawn that can take
+    if (field.size() == 2 && field[0] >= 'a' && field[0] <= 'h' && field[1] == ((turn == WHITE) ? '6' : '3')) {
+        int sq = square(field[1] - '1', field[0] - 'a');
+        int pushed = (turn == WHITE) ? sq - 8 : sq + 8, from = (turn == WHITE) ? sq + 8 : sq - 8;
+        if ((pieces((Color) (1 - turn), PAWN) & bit(pushed)) && !(occupied() & (bit(sq) | bit(from)))
+            && (pawn_attacks((Color) (1 - turn), sq) & pieces(turn, PAWN)))
+            ep_square = (int8_t) sq;
+    }
+
+    key ^= chess_ns::ZOBRIST.castle[castle_rights];
+    if (ep_square >= 0) key ^= chess_ns::ZOBRIST.ep_file[file_of(ep_square)];
+    if (turn == BLACK) key ^= chess_ns::ZOBRIST.turn;
+
+    field = next_field();
+    if (!field.empty()) halfmove_clock = (uint8_t) std::min(255, std::max(0, std::atoi(field.c_str())));
+    field = next_field();
+    if (!field.empty()) fullmove = (uint16_t) std::max(1, std::atoi(field.c_str()));
+    return true;
+}
+
+std::string Position::fen() const {
+    std::string out;
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            int sq = square(rank, file);
+            if (piece_on(sq) == PIECE_MAX) {
+                empty++;
+                continue;
+            }
+            if (empty) out += (char) ('0' + empty);
+            empty = 0;
+            char ch = (piece_on(sq) == PAWN) ? 'P' : PIECE_SHORTHAND[piece_on(sq)];
+            out += (color_on(sq) == WHITE) ? ch : (char) std::tolower(ch);
+        }
+        if (empty) out += (char) ('0' + empty);
+        if (rank) out += '/';
+    }
+    out += (turn == WHITE) ? " w " : " b ";
+    const char rights[] = "KQkq";
+    int before = (int) out.size();
+    for (int b = 0; b < 4; b++)
+        if (castle_rights & (1 << b)) out += rights[b];
+    if ((int) out.size() == before) out += '-';
+    out += ' ';
+    if (ep_square >= 0) {
+        out += (char) ('a' + file_of(ep_square));
+        out += (char) ('1' + rank_of(ep_square));
+    }
+    else
+        out += '-';
+    out += " " + std::to_string(halfmove_clock) + " " + std::to_string(fullmove);
+    return out;
+}
+
+Bitboard Position::attackers_to(int sq, Bitboard occ) const {
+    return (pawn_attacks(BLACK, sq) & pieces(WHITE, PAWN))
+         | (pawn_attacks(WHITE, sq) & pieces(BLACK, PAWN))
+         | (knight_attacks(sq) & by_type[KNIGHT])
+         | (king_attacks(sq) & by_type[KING])
+         | (rook_attacks(sq, occ) & (by_type[ROOK] | by_type[QUEEN]))
+         | (bishop_attacks(sq, occ) & (by_type[BISHOP] | by_type[QUEEN]));
+}
+
+bool Position::attacked(int sq, Color by) const {
+    return attackers_to(sq, occupied()) & by_color[by];
+}
+
+Bitboard Position::pinned(Color c) const {
+    int ksq = king_square(c);
+    Color them = (Color) (1 - c);
+    Bitboard snipers = (rook_attacks(ksq, 0) & (pieces(them, ROOK) | pieces(them, QUEEN)))
+                     | (bishop_attacks(ksq, 0) & (pieces(them, BISHOP) | pieces(them, QUEEN)));
+    Bitboard occ = occupied(), result = 0;
+    while (snipers) {
+        Bitboard blockers = between(ksq, pop_lsb(snipers)) & occ;
+        if (popcount(blockers) == 1)
+            result |= blockers & by_color[c];
+    }
+    return result;
+}
+
+// All four promotions onto each of targets, from step squares back. Queen first, as that's by far the most likely one
+static inline void add_promotions(Move16*& list, Bitboard targets, int step) {
+    while (targets) {
+        int dst = pop_lsb(targets);
+        for (int p = QUEEN; p >= KNIGHT; p--)
+            *list++ = Move16(dst - step, dst, Move16::PROMOTION, (Piece_index) p);
+    }
+}
+
+bool Position::castle_allowed(Castle_type type) const {
+    Color them = (Color) (1 - turn);
+    int ksq = square((turn == WHITE) ? 0 : 7, 4);
+    int step = (type == SHORT) ? 1 : -1;
+    Bitboard path = (type == SHORT) ? (bit(ksq + 1) | bit(ksq + 2)) : (bit(ksq - 1) | bit(ksq - 2) | bit(ksq - 3));
+    return (castle_rights & (1 << (2 * turn + type))) && !(occupied() & path)
+        && !attacked(ksq, them) && !attacked(ksq + step, them) && !attacked(ksq + 2 * step, them);
+}
+
+int Position::generate_pseudo(Move16* list, Gen_type type) const {
+    CHESS_STAT_TIMER(STAT_MOVEGEN);
+    Move16* start = list;
+    Color us = turn, them = (Color) (1 - turn);
+    Bitboard occ = occupied(), own = by_color[us], enemy = by_color[them];
+    Bitboard target_mask = (type == CAPTURES) ? enemy : (type == QUIETS) ? ~occ : ~own;
+    Bitboard promo_rank = (us == WHITE) ? RANK_8 : RANK_1;
+    int forward = (us == WHITE) ? 8 : -8;
+
+    // Pawns, all of a color at once : every move kind is one shift of the whole pawn set, masked. Pushes onto the last rank are
+    // promotions, which go with CAPTURES (tactical moves)
+    Bitboard pawns = pieces(us, PAWN);
+    Bitboard empty = ~occ;
+    auto up = [us](Bitboard b) { return (us == WHITE) ? b << 8 : b >> 8; };
+    Bitboard single = up(pawns) & empty;
+    Bitboard capture_west = up(pawns & ~FILE_A) >> 1 & enemy;       // Towards file a
+    Bitboard capture_east = up(pawns & ~FILE_H) << 1 & enemy;       // Towards file h
+    if (type != CAPTURES) {
+        Bitboard pushes = single & ~promo_rank;
+        Bitboard doubles = up(single & ((us == WHITE) ? RANK_1 << 16 : RANK_8 >> 16)) & empty;
+        while (pushes) {
+            int dst = pop_lsb(pushes);
+            *list++ = Move16(dst - forward, dst);
+        }
+        while (doubles) {
+            int dst = pop_lsb(doubles);
+            *list++ = Move16(dst - 2 * forward, dst);
+        }
+    }
+    if (type != QUIETS) {
+        add_promotions(list, single & promo_rank, forward);
+        add_promotions(list, capture_west & promo_rank, forward - 1);
+        add_promotions(list, capture_east & promo_rank, forward + 1);
+        for (Bitboard captures = capture_west & ~promo_rank; captures; ) {
+            int dst = pop_lsb(captures);
+            *list++ = Move16(dst - forward + 1, dst);
+        }
+        for (Bitboard captures = capture_east & ~promo_rank; captures; ) {
+            int dst = pop_lsb(captures);
+            *list++ = Move16(dst - forward - 1, dst);
+        }
+        if (ep_square >= 0) {
+            Bitboard takers = pawn_attacks(them, ep_square) & pawns;
+            while (takers)
+                *list++ = Move16(pop_lsb(takers), ep_square, Move16::EN_PASSANT);
+        }
+    }
+
+    // Pieces
+    for (int p = KNIGHT; p <= KING; p++) {
+        Bitboard from = pieces(us, (Piece_index) p);
+        while (from) {
+            int src = pop_lsb(from);
+            Bitboard targets = piece_attacks((Piece_index) p, src, occ) & target_mask;
+            while (targets)
+                *list++ = Move16(src, pop_lsb(targets));
+        }
+    }
+
+    // Castling, only from standard squares
+    if (type != CAPTURES) {
+        int ksq = square((us == WHITE) ? 0 : 7, 4);
+        if (castle_allowed(SHORT))
+            *list++ = Move16(ksq, ksq + 2, Move16::CASTLING);
+        if (castle_allowed(LONG))
+            *list++ = Move16(ksq, ksq - 2, Move16::CASTLING);
+    }
+
+    return (int) (list - start);
+}
+
+bool Position::is_pseudo_legal(Move16 move) const {
+    int src = move.src(), dst = move.dst();
+    Color us = turn, them = (Color) (1 - turn);
+    if (move.is_null() || piece_on(src) == PIECE_MAX || color_on(src) != us)
+        return false;
+    if (piece_on(dst) != PIECE_MAX && color_on(dst) == us)
+        return false;
+
+    Piece_index p = piece_on(src);
+    Bitboard occ = occupied();
+    if (move.flag() == Move16::CASTLING) {
+        if (p != KING || src != square((us == WHITE) ? 0 : 7, 4) || (dst != src + 2 && dst != src - 2))
+            return false;
+        return castle_allowed((dst > src) ? SHORT : LONG);
+    }
+    if (p != PAWN)
+        return move.flag() == Move16::NORMAL && (piece_attacks(p, src, occ) & bit(dst));
+
+    if (move.flag() == Move16::EN_PASSANT)
+        return dst == ep_square && (pawn_attacks(us, src) & bit(dst));
+    if ((move.flag() == Move16::PROMOTION) != (rank_of(dst) == 0 || rank_of(dst) == 7))
+        return false;
+    int forward = (us == WHITE) ? 8 : -8;
+    if (pawn_attacks(us, src) & by_color[them] & bit(dst))
+        return true;
+    if (dst == src + forward)
+        return !(occ & bit(dst));
+    return dst == src + 2 * forward && rank_of(src) == ((us == WHITE) ? 1 : 6) && !(occ & (bit(src + forward) | bit(dst)));
+}
+
+bool Position::is_legal(Move16 move, Bitboard pinned_pieces, bool check) const {
+    int src = move.src();
+    // Castling legality is fully checked by the generator. Common case : not a king move, not pinned, not in check, not en passant
+    if (move.flag() == Move16::CASTLING)
+        return true;
+    Piece_index p = piece_on(src);
+    if (p != KING && move.flag() != Move16::EN_PASSANT && !(pinned_pieces & bit(src)) && !check)
+        return true;
+    if (p == KING && move.flag() == Move16::NORMAL) {
+        // King can't step to an attacked square, and must not stay on the line of a checking slider (so remove it from occupancy)
+        Bitboard occ = occupied() ^ bit(src);
+        return !(attackers_to(move.dst(), occ) & by_color[1 - turn] & ~bit(move.dst()));
+    }
+    // Rare cases (pins, evasions, en passant) : just play it on a copy and look
+    Position next = *this;
+    next.play(move);
+    return !next.attacked(next.king_square(turn), next.turn);
+}
+
+int Position::generate_moves(Move16* list) const {
+    Move16 pseudo[MAX_MOVES];
+    int n = generate_pseudo(pseudo), count = 0;
+    Bitboard pinned_pieces = pinned(turn);
+    bool check = in_check();
+    for (int i = 0; i < n; i++)
+        if (is_legal(pseudo[i], pinned_pieces, check))
+            list[count++] = pseudo[i];
+    return count;
+}
+
+bool Position::has_legal_moves() const {
+    Move16 pseudo[MAX_MOVES];
+    int n = generate_pseudo(pseudo);
+    Bitboard pinned_pieces = pinned(turn);
+    bool check = in_check();
+    for (int i = 0; i < n; i++)
+        if (is_legal(pseudo[i], pinned_pieces, check))
+            return true;
+    return false;
+}
+
+void Position::play(Move16 move) {
+    int src = move.src(), dst = move.dst();
+    Piece_index p = piece_on(src);
+    Color us = turn, them = (Color) (1 - turn);
+
+    halfmove_clock = (uint8_t) std::min(255, halfmove_clock + 1);
+    key ^= chess_ns::ZOBRIST.castle[castle_rights] ^ chess_ns::ZOBRIST.turn;
+    if (ep_square >= 0) {
+        key ^= chess_ns::ZOBRIST.ep_file[file_of(ep_square)];
+        ep_square = -1;
+    }
+
+    if (piece_on(dst) != PIECE_MAX) {
+        remove_piece(dst);
+        halfmove_clock = 0;
+    }
+    remove_piece(src);
+    put_piece(us, (move.flag() == Move16::PROMOTION) ? move.promo() : p, dst);
+
+    if (p == PAWN) {
+        halfmove_clock = 0;
+        if (move.flag() == Move16::EN_PASSANT)
+            remove_piece(dst - ((us == WHITE) ? 8 : -8));
+        else if (dst - src == 16 || src - dst == 16) {
+            int ep = (src + dst) / 2;
+            if (pawn_attacks(us, ep) & pieces(them, PAWN)) {
+                ep_square = (int8_t) ep;
+                key ^= chess_ns::ZOBRIST.ep_file[file_of(ep)];
+            }
+        }
+    }
+    else if (move.flag() == Move16::CASTLING) {
+        bool is_short = dst > src;
+        int rook_src = is_short ? dst + 1 : dst - 2;
+        int rook_dst = is_short ? dst - 1 : dst + 1;
+        remove_piece(rook_src);
+        put_piece(us, ROOK, rook_dst);
+    }
+
+    castle_rights &= CASTLE_MASK[src] & CASTLE_MASK[dst];
+    key ^= chess_ns::ZOBRIST.castle[castle_rights];
+    turn = them;
+    if (turn == WHITE) fullmove++;
+}
+
+Move16 Position::find_move(Move<8>& move) const {
+    if (!move.is_valid())
+        return Move16();
+
+    Move16 list[MAX_MOVES];
+    int n = generate_moves(list);
+    Move16 found;
+    int matches = 0;
+
+    // Capture / check markers in the move string are not enforced here, same as disambiguation isn't in _Move::parse_move()
+    if (move.castle_type() < CASTLE_MAX) {
+        int dst_file = (move.castle_type() == SHORT) ? 6 : 2;
+        for (int i = 0; i < n; i++)
+            if (list[i].flag() == Move16::CASTLING && file_of(list[i].dst()) == dst_file)
+                return list[i];
+        return Move16();
+    }
+
+    Piece_index p = (move.piece_type() == nullptr) ? PAWN : piece_index(move.piece_type()->shorthand);
+    Piece_index promo = (move.promo_type() == nullptr) ? PIECE_MAX : piece_index(move.promo_type()->shorthand);
+    auto [dst_rank, dst_file] = move.dst();
+    auto [src_rank, src_file] = move.src();
+    int dst = square(dst_rank, dst_file);
+
+    for (int i = 0; i < n; i++) {
+        Move16 m = list[i];
+        if (m.dst() != dst || piece_on(m.src()) != p || m.flag() == Move16::CASTLING)
+            continue;
+        if (src_rank < 8 && rank_of(m.src()) != src_rank)
+            continue;
+        if (src_file < 8 && file_of(m.src()) != src_file)
+            continue;
+        if ((m.flag() == Move16::PROMOTION) != (promo != PIECE_MAX) || (promo != PIECE_MAX && m.promo() != promo))
+            continue;
+        found = m;
+        matches++;
+    }
+    return (matches == 1) ? found : Move16();
+}
+
+bool parse_san(std::string_view text, San_move& out) {
+    out = San_move{PAWN, PIECE_MAX, -1, -1, -1, CASTLE_MAX};
+    while (!text.empty() && (text.back() == '+' || text.back() == '#' || text.back() == '!' || text.back() == '?'))
+        text.remove_suffix(1);
+    if (text == "O-O" || text == "0-0") { out.castle = SHORT; return true; }
+    if (text == "O-O-O" || text == "0-0-0") { out.castle = LONG; return true; }
+    if (text.size() < 2)
+        return false;
+
+    size_t i = 0;
+    if (std::isupper((unsigned char) text[0])) {
+        out.piece = piece_index(text[0]);
+        if (out.piece == PIECE_MAX || out.piece == PAWN)
+            return false;
+        i++;
+    }
+    // Promotion at the end, "=Q" or just "Q"
+    size_t end = text.size();
+    if (out.piece == PAWN && end > 2 && std::isupper((unsigned char) text[end - 1])) {
+        out.promo = piece_index(text[end - 1]);
+        if (out.promo == PIECE_MAX || out.promo == PAWN || out.promo == KING)
+            return false;
+        end -= (text[end - 2] == '=') ? 2 : 1;
+    }
+    if (end < i + 2)
+        return false;
+    char file = text[end - 2], rank = text[end - 1];
+    if (file < 'a' || file > 'h' || rank < '1' || rank > '8')
+        return false;
+    out.dst = (int8_t) square(rank - '1', file - 'a');
+
+    // Whatever is in between : disambiguation and capture marker
+    for (end -= 2; i < end; i++) {
+        char ch = text[i];
+        if (ch >= 'a' && ch <= 'h' && out.src_file < 0 && out.src_rank < 0) out.src_file = (int8_t) (ch - 'a');
+        else if (ch >= '1' && ch <= '8' && out.src_rank < 0) out.src_rank = (int8_t) (ch - '1');
+        else if (ch == 'x' && i + 1 == end) continue;
+        else return false;
+    }
+    return true;
+}
+
+Move16 Position::find_move(const San_move& move) const {
+    Move16 pseudo[MAX_MOVES];
+    int n = generate_pseudo(pseudo);
+    Bitboard pinned_pieces = pinned(turn);
+    bool check = in_check();
+    Move16 found;
+    int matches = 0;
+    for (int i = 0; i < n; i++) {
+        Move16 m = pseudo[i];
+        if (move.castle != CASTLE_MAX) {
+            if (m.flag() != Move16::CASTLING || (m.dst() > m.src()) != (move.castle == SHORT))
+                continue;
+        }
+        else {
+            if (m.dst() != move.dst || piece_on(m.src()) != move.piece || m.flag() == Move16::CASTLING)
+                continue;
+            if ((move.src_file >= 0 && file_of(m.src()) != move.src_file) || (move.src_rank >= 0 && rank_of(m.src()) != move.src_rank))
+                continue;
+            if ((m.flag() == Move16::PROMOTION) != (move.promo != PIECE_MAX) || (move.promo != PIECE_MAX && m.promo() != move.promo))
+                continue;
+        }
+        if (!is_legal(m, pinned_pieces, check))
+            continue;
+        found = m;
+        matches++;
+    }
+    return (matches == 1) ? found : Move16();
+}
+
+bool Position::gives_check(Move16 move) const {
+    Color us = turn;
+    int src = move.src(), dst = move.dst(), ksq = king_square((Color) (1 - us));
+    Piece_index p = (move.flag() == Move16::PROMOTION) ? move.promo() : piece_on(src);
+    Bitboard occ = (occupied() ^ bit(src)) | bit(dst);
+    // Our sliders after the move, minus the moving piece (its own attacks are the direct check below)
+    Bitboard straight = (pieces(us, ROOK) | pieces(us, QUEEN)) & ~bit(src);
+    Bitboard diagonal = (pieces(us, BISHOP) | pieces(us, QUEEN)) & ~bit(src);
+
+    if (move.flag() == Move16::EN_PASSANT)
+        occ ^= bit(dst - ((us == WHITE) ? 8 : -8));
+    else if (move.flag() == Move16::CASTLING) {
+        // King never checks, the rook may
+        bool is_short = dst > src;
+        int rook_src = is_short ? dst + 1 : dst - 2, rook_dst = is_short ? dst - 1 : dst + 1;
+        occ = (occ ^ bit(rook_src)) | bit(rook_dst);
+        straight = (straight & ~bit(rook_src)) | bit(rook_dst);
+        p = KING;
+    }
+
+    Bitboard direct = (p == PAWN) ? pawn_attacks(us, dst) : piece_attacks(p, dst, occ);
+    if (direct & bit(ksq))
+        return true;
+    // Discovered : a slider of ours sees the king through the square just vacated
+    return (rook_attacks(ksq, occ) & straight) | (bishop_attacks(ksq, occ) & diagonal);
+}
+
+int Position::write_san(Move16 move, char* out) const {
+    char* p_out = out;
+    int src = move.src(), dst = move.dst();
+    Piece_index p = piece_on(src);
+    bool capture = piece_on(dst) != PIECE_MAX || move.flag() == Move16::EN_PASSANT;
+
+    auto put = [&](const char* text) {
+        while (*text) *p_out++ = *text++;
+    };
+    if (move.flag() == Move16::CASTLING)
+        put((dst > src) ? "O-O" : "O-O-O");
+    else {
+        if (p == PAWN) {
+            if (capture) *p_out++ = (char) ('a' + file_of(src));
+        }
+        else {
+            *p_out++ = PIECE_SHORTHAND[p];
+            // Disambiguate against other pieces of the same type reaching dst : they're the ones a piece of this type on dst attacks.
+            // Usually there are none ; any that are there still have to be legal movers (pinned / check evasion)
+            Bitboard others = (p == KING) ? 0 : piece_attacks(p, dst, occupied()) & pieces(turn, p) & ~bit(src);
+            if (others) {
+                Bitboard pinned_pieces = pinned(turn);
+                bool check = in_check();
+                bool same_file = false, same_rank = false, ambiguous = false;
+                while (others) {
+                    int other = pop_lsb(others);
+                    if (!is_legal(Move16(other, dst), pinned_pieces, check))
+                        continue;
+                    ambiguous = true;
+                    same_file |= file_of(other) == file_of(src);
+                    same_rank |= rank_of(other) == rank_of(src);
+                }
+                if (ambiguous && (!same_file || same_rank))
+                    *p_out++ = (char) ('a' + file_of(src));
+                if (ambiguous && same_file)
+                    *p_out++ = (char) ('1' + rank_of(src));
+            }
+        }
+        if (capture) *p_out++ = 'x';
+        *p_out++ = (char) ('a' + file_of(dst));
+        *p_out++ = (char) ('1' + rank_of(dst));
+        if (move.flag() == Move16::PROMOTION) {
+            *p_out++ = '=';
+            *p_out++ = PIECE_SHORTHAND[move.promo()];
+        }
+    }
+
+    // Mate only needs looking into when it's check at all
+    if (gives_check(move)) {
+        Position next = *this;
+        next.play(move);
+        *p_out++ = next.has_legal_moves() ? '+' : '#';
+    }
+    *p_out = '\0';
+    return (int) (p_out - out);
+}
+
+std::string Position::san(Move16 move) const {
+    char text[SAN_MAX];
+    return std::string(text, write_san(move, text));
+}
+
+std::string Position::uci(Move16 move) const {
+    std::string out;
+    out += (char) ('a' + file_of(move.src()));
+    out += (char) ('1' + rank_of(move.src()));
+    out += (char) ('a' + file_of(move.dst()));
+    out += (char) ('1' + rank_of(move.dst()));
+    if (move.flag() == Move16::PROMOTION)
+        out += (char) std::tolower(PIECE_SHORTHAND[move.promo()]);
+    return out;
+}
@@ -0,0 +1,221 @@
+#ifndef CHESS_POSITION_H
+#define CHESS_POSITION_H
+
+#include "chess_common.h"
+#include "chess_bitboard.h"
+#include "chess_board.h"
+#include <string_view>
+
+// ------------------------------------------------------------------------ Compact move ------------------------------------------------------------------------------
+
+// 16 bit move : bits 0-5 src square, bits 6-11 dst square, bits 12-13 promo piece (Knight..Queen), bits 14-15 special flag.
+// Castling is stored as the king's move (e1g1, e1c1, ...), rook placement is implied. Move16() (all zeroes) is the null move.
+struct Move16 {
+    typedef enum flag {
+        NORMAL,
+        PROMOTION,
+        EN_PASSANT,
+        CASTLING
+    } Flag;
+
+    uint16_t data;
+
+    constexpr Move16() : data(0) {}
+
+    constexpr Move16(int src, int dst, Flag flag = NORMAL, Piece_index promo = KNIGHT) :
+        data((uint16_t) (src | (dst << 6) | ((promo - KNIGHT) << 12) | (flag << 14))) {}
+
+    int src() const {
+        return data & 63;
+    }
+
+    int dst() const {
+        return (data >> 6) & 63;
+    }
+
+    Flag flag() const {
+        return (Flag) (data >> 14);
+    }
+
+    Piece_index promo() const {
+        return (Piece_index) (KNIGHT + ((data >> 12) & 3));
+    }
+
+    bool is_null() const {
+        return data == 0;
+    }
+
+    bool operator==(const Move16& other) const {
+        return data == other.data;
+    }
+
+    bool operator!=(const Move16& other) const {
+        return data != other.data;
+    }
+};
+
+// SAN move as parsed by parse_san(), not yet resolved against a position
+struct San_move {
+    Piece_index piece;                  // Moving piece, PAWN if no letter
+    Piece_index promo;                  // PIECE_MAX if none
+    int8_t dst;                         // Square, -1 for castling
+    int8_t src_file, src_rank;          // Disambiguation, -1 if not given
+    Castle_type castle;                 // CASTLE_MAX if not castling
+};
+
+// Strict-ish SAN reader : [piece][file][rank][x]<square>[=promo][+#!?...], or O-O / O-O-O (zeroes too). Capture and check markers
+// are accepted but not enforced (same as _Move::parse_move). Returns false on anything malformed
+bool parse_san(std::string_view text, San_move& out);
+
+// Upper bound on legal moves in any reachable chess position is 218, rounding up
+constexpr int MAX_MOVES = 256;
+
+// Longest SAN is 7 chars ("Qa1xb2+", "exd8=Q#"), plus the terminating NUL
+constexpr int SAN_MAX = 8;
+
+// Move generation subsets. CAPTURES also has all promotions & en passant (i.e. every move that changes material), QUIETS is the rest.
+typedef enum gen_type {
+    ALL_MOVES,
+    CAPTURES,
+    QUIETS
+} Gen_type;
+
+
+// ------------------------------------------------------------------------ Zobrist keys ------------------------------------------------------------------------------
+
+// Fixed seed, so keys are stable across builds & machines (position indexes on disk depend on this, don't change it!)
+namespace chess_ns {
+    struct Zobrist_keys {
+        uint64_t piece[Color::MAX][PIECE_MAX][SQUARE_MAX];
+        uint64_t castle[16];                // Indexed by the whole castle_rights nibble
+        uint64_t ep_file[8];
+        uint64_t turn;                      // XOR-ed in when black to move
+    };
+
+    inline constexpr Zobrist_keys ZOBRIST = [] {
+        Zobrist_keys z{};
+        uint64_t state = 0x2545F4914F6CDD1DULL;
+        for (int c = 0; c < Color::MAX; c++)
+            for (int p = 0; p < PIECE_MAX; p++)
+                for (int sq = 0; sq < SQUARE_MAX; sq++)
+                    z.piece[c][p][sq] = splitmix64(state);
+        for (int i = 1; i < 16; i++) z.castle[i] = splitmix64(state);
+        for (int f = 0; f < 8; f++) z.ep_file[f] = splitmix64(state);
+        z.turn = splitmix64(state);
+        return z;
+    }();
+}
+
+
+// ------------------------------------------------------------------------ Flat position -----------------------------------------------------------------------------
+
+// Flat, trivially-copyable snapshot of a standard chess position. Unlike Board (which hands out Piece_ptr into PieceID_map), this holds
+// everything by value, so copying a position is a plain memcpy, and move making is copy-make : copy the position, then play() on the copy.
+// Square layout is the one in chess_bitboard.h, white starts on ranks 0,1 exactly like _Chess::reset_game() places pieces.
+struct Position {
+    Bitboard by_type[PIECE_MAX];
+    Bitboard by_color[Color::MAX];
+    uint8_t cells[SQUARE_MAX];          // (color << 3) | piece, or PIECE_MAX if empty
+    Color turn;
+    uint8_t castle_rights;              // Bit (2 * color + Castle_type) set, if that castle is still allowed
+    int8_t ep_square;                   // Square a pawn can capture onto en passant, -1 if none. Only set if some pawn can actually take
+    uint8_t halfmove_clock;             // Plies since last capture / pawn move
+    uint16_t fullmove;
+    uint64_t key;                       // Zobrist hash, kept up to date incrementally by put_piece / remove_piece / play
+    uint64_t pawn_key;                  // Same, pawns only (chess_ns::PAWN_ZOBRIST) : pawn structure eval is cached under it
+
+    void clear();
+
+    // Standard starting position
+    void set_start();
+
+    // Returns false (and leaves position cleared) if the FEN is malformed
+    bool set_fen(const std::string& fen);
+
+    std::string fen() const;
+
+    void put_piece(Color c, Piece_index p, int sq);
+
+    void remove_piece(int sq);
+
+    Piece_index piece_on(int sq) const {
+        return (Piece_index) (cells[sq] & 7);
+    }
+
+    Color color_on(int sq) const {
+        return (Color) (cells[sq] >> 3);
+    }
+
+    Bitboard pieces(Color c, Piece_index p) const {
+        return by_type[p] & by_color[c];
+    }
+
+    Bitboard occupied() const {
+        return by_color[WHITE] | by_color[BLACK];
+    }
+
+    int king_square(Color c) const {
+        return lsb(pieces(c, KING));
+    }
+
+    // All pieces (both colors) attacking sq, given occupancy occ (occ can differ from the actual one, for x-rays)
+    Bitboard attackers_to(int sq, Bitboard occ) const;
+
+    bool attacked(int sq, Color by) const;
+
+    bool in_check() const {
+        return attacked(king_square(turn), (Color) (1 - turn));
+    }
+
+    // Pieces of color c that are the only blocker between their own king and an enemy slider
+    Bitboard pinned(Color c) const;
+
+    // Castling of given type is possible right now (rights, empty path, king not passing through check)
+    bool castle_allowed(Castle_type type) const;
+
+    // Pseudo-legal moves (may leave own king in check), returns count written to list
+    int generate_pseudo(Move16* list, Gen_type type = ALL_MOVES) const;
+
+    // Whether move could have come from generate_pseudo() in this position. For moves from elsewhere (hash table, killers), which
+    // may be garbage here
+    bool is_pseudo_legal(Move16 move) const;
+
+    // Legal moves only, deterministic order (but not a stable one across versions : game records sort moves their own way)
+    int generate_moves(Move16* list) const;
+
+    // Legality of a pseudo-legal move, given pinned(turn) and in_check()
+    bool is_legal(Move16 move, Bitboard pinned_pieces, bool check) const;
+
+    bool has_legal_moves() const;
+
+    // Make the move in place. Move must be legal, no validation is done here
+    void play(Move16 move);
+
+    // Resolve a parsed SAN move against the legal moves of this position. Null move if illegal or ambiguous
+    Move16 find_move(Move<8>& move) const;
+
+    // Same, from parse_san() output. Only moves that match get the legality test, no full legal move list
+    Move16 find_move(const San_move& move) const;
+
+    // Neither side can ever mate : bare kings, or a lone minor piece against a bare king
+    bool insufficient_material() const {
+        if (by_type[PAWN] | by_type[ROOK] | by_type[QUEEN])
+            return false;
+        return popcount(by_type[KNIGHT] | by_type[BISHOP]) <= 1;
+    }
+
+    // Whether a legal move checks the opponent (directly, or by uncovering a slider), without playing it
+    bool gives_check(Move16 move) const;
+
+    // Standard algebraic notation of a legal move, with disambiguation and +/# suffix, written into out (room for SAN_MAX chars),
+    // NUL-terminated. Returns its length. Doesn't allocate, and only generates moves to tell mate from check
+    int write_san(Move16 move, char* out) const;
+
+    // Same, as a string
+    std::string san(Move16 move) const;
+
+    // Coordinate notation e2e4, e7e8q
+    std::string uci(Move16 move) const;
+};
+
+#endif
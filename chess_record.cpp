@@ -0,0 +1,820 @@
+#include "chess_record.h"
+#include "chess_trace.h"
+#include "chess_utils.h"
+#include <cstring>
+#include <algorithm>
+
+// ------------------------------------------------------------------------------ Byte helpers --------------------------------------------------------------------------
+
+namespace chess_ns {
+    const char RECORD_MAGIC[8] = {'C','H','E','S','S','R','E','C'};
+    const char INDEX_MAGIC[8] = {'C','G','R','I','N','D','E','X'};
+    const uint32_t RECORD_VERSION = 1;
+    const size_t BLOCK_HEADER_SIZE = 13;
+    const size_t TRAILER_SIZE = 32;
+    // Limits that bound what a reader ever allocates : a block holds less than its target plus one game (the one that crossed it)
+    const uint32_t MAX_BLOCK_TARGET = 1 << 26;
+    const size_t MAX_GAME_SIZE = 1 << 20;           // Encoded game, without its size varint
+
+    typedef enum codec {
+        CODEC_RAW,
+        CODEC_LZ
+    } Codec;
+
+    // Sort key of the move order records index into : the order Position::generate_moves() had when the format was defined (pawns
+    // by source square with push, double push, captures, en passant ; then pieces by type, source & target ; castling last, short
+    // before long). The generator is free to change its own order, files never depend on it.
+    uint32_t record_order(const Position& pos, Move16 move) {
+        int src = move.src(), dst = move.dst(), kind = 0, promo = 0;
+        int group = (move.flag() == Move16::CASTLING) ? KING + 1 : (int) pos.piece_on(src);
+        if (move.flag() == Move16::CASTLING)
+            kind = dst < src;
+        else if (group == PAWN) {
+            if (move.flag() == Move16::EN_PASSANT) kind = 3;
+            else if (file_of(src) != file_of(dst)) kind = 2;
+            else if (dst - src == 16 || src - dst == 16) kind = 1;
+            if (move.flag() == Move16::PROMOTION)
+                promo = QUEEN - move.promo();
+        }
+        return (uint32_t) ((group << 20) | (src << 14) | (kind << 12) | (dst << 2) | promo);
+    }
+
+    // Legal moves of pos, in record order
+    int record_moves(const Position& pos, Move16* list) {
+        int n = pos.generate_moves(list);
+        uint32_t keys[MAX_MOVES];
+        for (int i = 0; i < n; i++)
+            keys[i] = record_order(pos, list[i]);
+        // Insertion sort : lists are short, and mostly in order already
+        for (int i = 1; i < n; i++) {
+            uint32_t key = keys[i];
+            Move16 move = list[i];
+            int j = i - 1;
+            for (; j >= 0 && keys[j] > key; j--) {
+                keys[j + 1] = keys[j];
+                list[j + 1] = list[j];
+            }
+            keys[j + 1] = key;
+            list[j + 1] = move;
+        }
+        return n;
+    }
+
+    // Legal move number index of pos in record order (what record_moves(pos)[index] is), null move if there are fewer. Walks the
+    // pieces in that order instead of generating & sorting every move : the moves of a piece that isn't pinned are exactly its
+    // targets inside the check evasion mask, so a whole piece whose moves all come before index is skipped with one popcount. Only
+    // pinned pieces, en passant & castling get the per-move legality test, king moves are checked against one enemy attack map
+    Move16 record_move(const Position& pos, uint64_t index) {
+        Color us = pos.turn, them = (Color) (1 - us);
+        Bitboard occ = pos.occupied(), own = pos.by_color[us], enemy = pos.by_color[them];
+        int ksq = pos.king_square(us);
+        Bitboard checkers = pos.attackers_to(ksq, occ) & enemy;
+        Bitboard pinned_pieces = pos.pinned(us);
+        // Squares a move of an unpinned piece may land on : anywhere, onto the checker or its line, or nowhere in double check
+        Bitboard evasions = !checkers ? ~0ULL : (checkers & (checkers - 1)) ? 0 : checkers | between(ksq, lsb(checkers));
+        Move16 found;
+        // Counts index down over legal moves, true once found is set
+        auto take = [&](Move16 move) {
+            if (!pos.is_legal(move, pinned_pieces, checkers != 0))
+                return false;
+            if (index == 0) {
+                found = move;
+                return true;
+            }
+            index--;
+            return false;
+        };
+
+        int forward = (us == WHITE) ? 8 : -8;
+        Bitboard pawns = pos.pieces(us, PAWN);
+        if (!(pawns & pinned_pieces) && pos.ep_square < 0) {
+            // Most often the move is a piece's : all pawn moves counted at once, with whole-set shifts as in generate_pseudo()
+            auto up = [us](Bitboard b) { return (us == WHITE) ? b << 8 : b >> 8; };
+            Bitboard promo_rank = (us == WHITE) ? RANK_8 : RANK_1;
+            Bitboard single = up(pawns) & ~occ;
+            Bitboard doubles = up(single & ((us == WHITE) ? RANK_1 << 16 : RANK_8 >> 16)) & ~occ;
+            Bitboard west = up(pawns & ~FILE_A) >> 1 & enemy, east = up(pawns & ~FILE_H) << 1 & enemy;
+            uint64_t count = popcount(single & evasions) + popcount(doubles & evasions) + popcount(west & evasions)
+                           + popcount(east & evasions) + 3 * (popcount(single & evasions & promo_rank)
+                           + popcount(west & evasions & promo_rank) + popcount(east & evasions & promo_rank));
+            if (index >= count) {
+                index -= count;
+                pawns = 0;
+            }
+        }
+        while (pawns) {
+            int src = pop_lsb(pawns);
+            if (rank_of(src) == ((us == WHITE) ? 7 : 0))
+                continue;                           // Only from a FEN, and no moves
+            // Targets in record order : push, double push, captures
+            Bitboard push = bit(src + forward) & ~occ;
+            Bitboard double_push = (push && rank_of(src) == ((us == WHITE) ? 1 : 6)) ? bit(src + 2 * forward) & ~occ : 0;
+            Bitboard targets[3] = {push, double_push, pawn_attacks(us, src) & enemy};
+            bool promotion = rank_of(src + forward) == 0 || rank_of(src + forward) == 7;
+            int per_target = promotion ? 4 : 1;
+            if (pinned_pieces & bit(src)) {
+                for (Bitboard t : targets)
+                    for (; t; ) {
+                        int dst = pop_lsb(t);
+                        for (int p = QUEEN; p >= KNIGHT + 3 * !promotion; p--)
+                            if (take(promotion ? Move16(src, dst, Move16::PROMOTION, (Piece_index) p) : Move16(src, dst)))
+                                return found;
+                    }
+            }
+            else {
+                uint64_t count = per_target * popcount((push | double_push | targets[2]) & evasions);
+                if (index < count) {
+                    for (Bitboard t : targets)
+                        for (t &= evasions; t; ) {
+                            int dst = pop_lsb(t);
+                            if (index < (uint64_t) per_target)
+                                return promotion ? Move16(src, dst, Move16::PROMOTION, (Piece_index) (QUEEN - index)) : Move16(src, dst);
+                            index -= per_target;
+                        }
+                }
+                index -= count;
+            }
+            if (pos.ep_square >= 0 && (pawn_attacks(us, src) & bit(pos.ep_square)) && take(Move16(src, pos.ep_square, Move16::EN_PASSANT)))
+                return found;
+        }
+
+        for (int p = KNIGHT; p < KING; p++) {
+            for (Bitboard from = pos.pieces(us, (Piece_index) p); from; ) {
+                int src = pop_lsb(from);
+                Bitboard targets = piece_attacks((Piece_index) p, src, occ) & ~own;
+                if (pinned_pieces & bit(src)) {
+                    while (targets)
+                        if (take(Move16(src, pop_lsb(targets))))
+                            return found;
+                    continue;
+                }
+                targets &= evasions;
+                uint64_t count = popcount(targets);
+                if (index < count) {
+                    while (index--)
+                        targets &= targets - 1;
+                    return Move16(src, lsb(targets));
+                }
+                index -= count;
+            }
+        }
+
+        // King : squares the enemy doesn't attack, worked out with the king off the board (it can't block a slider's ray)
+        Bitboard attacked = 0, through = occ ^ bit(ksq), their_pawns = pos.pieces(them, PAWN);
+        attacked |= (them == WHITE) ? ((their_pawns & ~FILE_A) << 7) | ((their_pawns & ~FILE_H) << 9)
+                                    : ((their_pawns & ~FILE_A) >> 9) | ((their_pawns & ~FILE_H) >> 7);
+        for (int p = KNIGHT; p <= KING; p++)
+            for (Bitboard from = pos.pieces(them, (Piece_index) p); from; )
+                attacked |= piece_attacks((Piece_index) p, pop_lsb(from), through);
+        Bitboard targets = king_attacks(ksq) & ~own & ~attacked;
+        uint64_t count = popcount(targets);
+        if (index < count) {
+            while (index--)
+                targets &= targets - 1;
+            return Move16(ksq, lsb(targets));
+        }
+        index -= count;
+        if (pos.castle_allowed(SHORT) && take(Move16(ksq, ksq + 2, Move16::CASTLING)))
+            return found;
+        if (pos.castle_allowed(LONG) && take(Move16(ksq, ksq - 2, Move16::CASTLING)))
+            return found;
+        return Move16();
+    }
+
+    void put_u32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int i = 0; i < 4; i++) out.push_back((uint8_t) (v >> (8 * i)));
+    }
+
+    void put_u64(std::vector<uint8_t>& out, uint64_t v) {
+        for (int i = 0; i < 8; i++) out.push_back((uint8_t) (v >> (8 * i)));
+    }
+
+    uint32_t get_u32(const uint8_t* p) {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++) v |= (uint32_t) p[i] << (8 * i);
+        return v;
+    }
+
+    uint64_t get_u64(const uint8_t* p) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) v |= (uint64_t) p[i] << (8 * i);
+        return v;
+    }
+
+    void put_varint(std::vector<uint8_t>& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back((uint8_t) (v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t) v);
+    }
+
+    // Returns false if the varint runs past end (corrupt input)
+    bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+        v = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            uint8_t byte = *p++;
+            v |= (uint64_t) (byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    void put_string(std::vector<uint8_t>& out, const std::string& s) {
+        put_varint(out, s.size());
+        out.insert(out.end(), s.begin(), s.end());
+    }
+
+    bool get_string(const uint8_t*& p, const uint8_t* end, std::string& s) {
+        uint64_t len;
+        if (!get_varint(p, end, len) || len > (uint64_t) (end - p))
+            return false;
+        s.assign((const char*) p, len);
+        p += len;
+        return true;
+    }
+
+    // ------------------------------------------------------------------------ Block compression ---------------------------------------------------------------------
+
+    // Small LZ77 codec, byte oriented like LZ4. Sequence = token (literal count << 4 | match length - 4), literal count extension bytes,
+    // literals, u16 match offset, match length extension bytes. Extensions are 255-runs, used when the nibble is 15. The last sequence
+    // has literals only (decoder knows the raw size, so it stops right after them). Good enough for blocks of move indices, where
+    // the gain comes mostly from shared openings, and decoding is just memcpy's.
+    const int LZ_MIN_MATCH = 4;
+    const int LZ_HASH_BITS = 12;
+    const size_t LZ_MAX_OFFSET = 65535;
+
+    void lz_put_length(std::vector<uint8_t>& out, size_t len) {
+        for (; len >= 255; len -= 255) out.push_back(255);
+        out.push_back((uint8_t) len);
+    }
+
+    void lz_put_sequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t lit_len, size_t offset, size_t match_len) {
+        size_t match_code = match_len ? match_len - LZ_MIN_MATCH : 0;
+        out.push_back((uint8_t) ((std::min<size_t>(lit_len, 15) << 4) | std::min<size_t>(match_code, 15)));
+        if (lit_len >= 15) lz_put_length(out, lit_len - 15);
+        out.insert(out.end(), literals, literals + lit_len);
+        if (!match_len) return;
+        out.push_back((uint8_t) offset);
+        out.push_back((uint8_t) (offset >> 8));
+        if (match_code >= 15) lz_put_length(out, match_code - 15);
+    }
+
+    void lz_compress(const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+        out.clear();
+        std::vector<int64_t> table(1 << LZ_HASH_BITS, -1);
+        size_t n = in.size(), anchor = 0, i = 0;
+        auto read32 = [&](size_t at) {
+            uint32_t v;
+            std::memcpy(&v, in.data() + at, 4);
+            return v;
+        };
+        while (i + LZ_MIN_MATCH <= n) {
+            uint32_t seq = read32(i);
+            uint32_t h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+            int64_t cand = table[h];
+            table[h] = (int64_t) i;
+            if (cand >= 0 && i - cand <= LZ_MAX_OFFSET && read32(cand) == seq) {
+                size_t len = LZ_MIN_MATCH;
+                while (i + len < n && in[cand + len] == in[i + len]) len++;
+                lz_put_sequence(out, in.data() + anchor, i - anchor, i - cand, len);
+                i += len;
+                anchor = i;
+            }
+            else
+                i++;
+        }
+        if (anchor < n)
+            lz_put_sequence(out, in.data() + anchor, n - anchor, 0, 0);
+    }
+
+    bool lz_decompress(const uint8_t* in, size_t n, uint8_t* out, size_t raw_size) {
+        const uint8_t *ip = in, *in_end = in + n;
+        uint8_t *op = out, *out_end = out + raw_size;
+        auto get_length = [&](size_t& len) {
+            uint8_t byte;
+            do {
+                if (ip >= in_end) return false;
+                byte = *ip++;
+                len += byte;
+            } while (byte == 255);
+            return true;
+        };
+        while (op < out_end) {
+            if (ip >= in_end) return false;
+            uint8_t token = *ip++;
+            size_t lit_len = token >> 4, match_len = token & 15;
+            if (lit_len == 15 && !get_length(lit_len)) return false;
+            if (lit_len > (size_t) (in_end - ip) || lit_len > (size_t) (out_end - op)) return false;
+            std::memcpy(op, ip, lit_len);
+            op += lit_len; ip += lit_len;
+            if (op == out_end) break;
+
+            if (in_end - ip < 2) return false;
+            size_t offset = ip[0] | (ip[1] << 8);
+            ip += 2;
+            if (match_len == 15 && !get_length(match_len)) return false;
+            match_len += LZ_MIN_MATCH;
+            if (offset == 0 || offset > (size_t) (op - out) || match_len > (size_t) (out_end - op)) return false;
+            const uint8_t* match = op - offset;
+            for (size_t k = 0; k < match_len; k++) op[k] = match[k];      // Byte by byte, as ranges may overlap
+            op += match_len;
+        }
+        return ip == in_end;
+    }
+}
+
+using namespace chess_ns;
+
+bool Game_record::start_position(Position& pos) const {
+    if (start_fen.empty()) {
+        pos.set_start();
+        return true;
+    }
+    return pos.set_fen(start_fen);
+}
+
+
+// ------------------------------------------------------------------------------ Record writer -------------------------------------------------------------------------
+
+const uint32_t Record_writer::DEFAULT_BLOCK_SIZE = 1 << 16;
+
+Record_writer::Record_writer() : games(0), block_first_game(0), block_games(0), block_target(DEFAULT_BLOCK_SIZE) {}
+
+Record_writer::~Record_writer() {
+    if (out.is_open())
+        close();
+}
+
+bool Record_writer::open(const std::string& path, uint32_t block_target) {
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    this->block_target = std::min(std::max<uint32_t>(block_target, 256), MAX_BLOCK_TARGET);
+    games = block_first_game = 0;
+    block_games = 0;
+    block.clear();
+    index.clear();
+
+    std::vector<uint8_t> header(RECORD_MAGIC, RECORD_MAGIC + 8);
+    put_u32(header, RECORD_VERSION);
+    put_u32(header, this->block_target);
+    out.write((const char*) header.data(), header.size());
+    return (bool) out;
+}
+
+bool Record_writer::write_game(const Game_record& game) {
+    Position pos;
+    if (!game.start_position(pos))
+        return false;
+
+    // Encode into scratch first, so that a game with an illegal move leaves the block untouched
+    scratch.clear();
+    scratch.push_back((uint8_t) game.result);
+    put_varint(scratch, game.tags.size());
+    for (auto& [key, value] : game.tags) {
+        put_string(scratch, key);
+        put_string(scratch, value);
+    }
+    put_string(scratch, game.start_fen);
+    put_varint(scratch, game.moves.size());
+
+    Move16 list[MAX_MOVES];
+    for (const Move16& move : game.moves) {
+        int n = record_moves(pos, list);
+        int idx = (int) (std::find(list, list + n, move) - list);
+        if (idx == n)
+            return false;
+        put_varint(scratch, idx);
+        pos.play(move);
+    }
+    if (scratch.size() > MAX_GAME_SIZE)
+        return false;
+
+    put_varint(block, scratch.size());
+    block.insert(block.end(), scratch.begin(), scratch.end());
+    games++;
+    block_games++;
+    if (block.size() >= block_target)
+        return flush_block();
+    return true;
+}
+
+bool Record_writer::flush_block() {
+    if (block_games == 0)
+        return true;
+    CHESS_TRACE_SPAN_ARG("record_block", "games", block_games);
+    index.push_back({(uint64_t) out.tellp(), block_first_game});
+
+    std::vector<uint8_t> compressed;
+    lz_compress(block, compressed);
+    bool use_lz = compressed.size() < block.size();
+    const std::vector<uint8_t>& payload = use_lz ? compressed : block;
+
+    std::vector<uint8_t> header;
+    header.push_back((uint8_t) (use_lz ? CODEC_LZ : CODEC_RAW));
+    put_u32(header, (uint32_t) block.size());
+    put_u32(header, (uint32_t) payload.size());
+    put_u32(header, block_games);
+    out.write((const char*) header.data(), header.size());
+    out.write((const char*) payload.data(), payload.size());
+
+    block.clear();
+    block_first_game = games;
+    block_games = 0;
+    return (bool) out;
+}
+
+bool Record_writer::close() {
+    if (!out.is_open())
+        return false;
+    bool ok = flush_block();
+    uint64_t index_offset = (uint64_t) out.tellp();
+    std::vector<uint8_t> tail;
+    for (auto& [offset, first_game] : index) {
+        put_u64(tail, offset);
+        put_u64(tail, first_game);
+    }
+    put_u64(tail, index_offset);
+    put_u64(tail, index.size());
+    put_u64(tail, games);
+    tail.insert(tail.end(), INDEX_MAGIC, INDEX_MAGIC + 8);
+    out.write((const char*) tail.data(), tail.size());
+    ok = ok && (bool) out;
+    out.close();
+    return ok;
+}
+
+
+// ------------------------------------------------------------------------------ Record reader -------------------------------------------------------------------------
+
+Record_reader::Record_reader() : block_pos(0), next_block(0), games(0), block_target(0) {}
+
+bool Record_reader::open(const std::string& path) {
+    in.open(path, std::ios::binary);
+    if (!in) return false;
+    index.clear();
+    block.clear();
+    block_pos = 0;
+    next_block = 0;
+    games = 0;
+
+    uint8_t header[16], trailer[TRAILER_SIZE];
+    if (!in.read((char*) header, 16) || std::memcmp(header, RECORD_MAGIC, 8) != 0 || get_u32(header + 8) != RECORD_VERSION)
+        return false;
+    block_target = get_u32(header + 12);
+    if (block_target > MAX_BLOCK_TARGET)
+        return false;
+    in.seekg(0, std::ios::end);
+    uint64_t file_size = (uint64_t) in.tellg();
+    if (file_size < 16 + TRAILER_SIZE)
+        return false;
+    in.seekg(file_size - TRAILER_SIZE);
+    if (!in.read((char*) trailer, TRAILER_SIZE) || std::memcmp(trailer + 24, INDEX_MAGIC, 8) != 0)
+        return false;
+
+    // Sizes are checked before any arithmetic on them, so that garbage can't wrap around into a size that looks right
+    uint64_t index_offset = get_u64(trailer), block_count = get_u64(trailer + 8);
+    if (index_offset > file_size || block_count > file_size / 16 || index_offset + block_count * 16 + TRAILER_SIZE != file_size)
+        return false;
+    std::vector<uint8_t> raw_index(block_count * 16);
+    in.seekg(index_offset);
+    if (!in.read((char*) raw_index.data(), raw_index.size()))
+        return false;
+    games = get_u64(trailer + 16);
+    // Blocks in file order before the index, first game ids from 0 up, so that seek() always lands on a block
+    for (uint64_t b = 0; b < block_count; b++) {
+        index.push_back({get_u64(&raw_index[16 * b]), get_u64(&raw_index[16 * b + 8])});
+        bool ordered = (b == 0) ? index[b].second == 0 : index[b].first > index[b - 1].first && index[b].second >= index[b - 1].second;
+        if (!ordered || index[b].first >= index_offset || index[b].second > games)
+            return false;
+    }
+    return block_count > 0 || games == 0;
+}
+
+bool Record_reader::load_block(uint64_t block_id) {
+    uint8_t header[BLOCK_HEADER_SIZE];
+    in.clear();
+    in.seekg(index[block_id].first);
+    if (!in.read((char*) header, BLOCK_HEADER_SIZE))
+        return false;
+    uint32_t raw_size = get_u32(header + 1), stored_size = get_u32(header + 5);
+    // Nothing the writer makes is bigger (and compression is only kept when it shrinks the block)
+    if (raw_size > block_target + MAX_GAME_SIZE + 8 || stored_size > raw_size)
+        return false;
+    block.resize(raw_size);
+    block_pos = 0;
+
+    if (header[0] == CODEC_RAW) {
+        return raw_size == stored_size && in.read((char*) block.data(), raw_size);
+    }
+    stored.resize(stored_size);
+    if (header[0] != CODEC_LZ || !in.read((char*) stored.data(), stored_size))
+        return false;
+    return lz_decompress(stored.data(), stored_size, block.data(), raw_size);
+}
+
+bool Record_reader::seek(uint64_t game_id) {
+    if (game_id >= games)
+        return false;
+    // Last block whose first game is <= game_id
+    auto it = std::upper_bound(index.begin(), index.end(), game_id,
+                               [](uint64_t id, const std::pair<uint64_t, uint64_t>& entry) { return id < entry.second; });
+    uint64_t block_id = (it - index.begin()) - 1;
+    if (!load_block(block_id))
+        return false;
+    next_block = block_id + 1;
+
+    const uint8_t* p = block.data();
+    const uint8_t* end = p + block.size();
+    for (uint64_t skip = index[block_id].second; skip < game_id; skip++) {
+        uint64_t size;
+        if (!get_varint(p, end, size) || size > (uint64_t) (end - p))
+            return false;
+        p += size;
+    }
+    block_pos = p - block.data();
+    return true;
+}
+
+bool Record_reader::next_game(Game_record& game) {
+    if (block_pos >= block.size()) {
+        if (next_block >= index.size() || !load_block(next_block))
+            return false;
+        next_block++;
+    }
+    const uint8_t* p = block.data() + block_pos;
+    const uint8_t* block_end = block.data() + block.size();
+    uint64_t size;
+    if (!get_varint(p, block_end, size) || size > (uint64_t) (block_end - p) || size == 0)
+        return false;
+    const uint8_t* end = p + size;
+    block_pos = end - block.data();
+
+    game.clear();
+    uint8_t result = *p++;
+    uint64_t count;
+    // Every count is checked against the bytes left before anything is sized by it (a tag or move takes at least one byte)
+    if (result > DRAWN || !get_varint(p, end, count) || count > (uint64_t) (end - p))
+        return false;
+    game.result = (Game_result) result;
+    game.tags.resize(count);
+    for (auto& [key, value] : game.tags)
+        if (!get_string(p, end, key) || !get_string(p, end, value))
+            return false;
+    if (!get_string(p, end, game.start_fen) || !get_varint(p, end, count) || count > (uint64_t) (end - p))
+        return false;
+
+    Position pos;
+    if (!game.start_position(pos))
+        return false;
+    game.moves.resize(count);
+    for (uint64_t ply = 0; ply < count; ply++) {
+        uint64_t idx;
+        if (!get_varint(p, end, idx))
+            return false;
+        Move16 move = record_move(pos, idx);
+        if (move.is_null())
+            return false;
+        game.moves[ply] = move;
+        pos.play(move);
+    }
+    return p == end;
+}
+
+
+// ------------------------------------------------------------------------------ PGN reader ----------------------------------------------------------------------------
+
+class _Pgn_reader {
+    typedef std::basic_string<char, std::char_traits<char>, Arena_allocator<char>> Scratch_string;
+
+    std::istream& in;
+    PType_set piece_types;
+    Move<8> move_in;
+    Arena scratch;                      // Tag & token text of the game being read, released when the next one starts
+
+    // Skip a {comment}, or a (variation) with anything nested in it
+    void skip_until(char close) {
+        int depth = 1;
+        char ch;
+        while (depth && in.get(ch)) {
+            if (close == ')' && ch == '(') depth++;
+            else if (ch == close) depth--;
+            else if (close == ')' && ch == '{') skip_until('}');
+        }
+    }
+
+    static bool parse_result(std::string_view token, Game_result& result) {
+        if (token == "1-0") result = WHITE_WINS;
+        else if (token == "0-1") result = BLACK_WINS;
+        else if (token == "1/2-1/2") result = DRAWN;
+        else if (token == "*") result = RESULT_UNKNOWN;
+        else return false;
+        return true;
+    }
+
+    void parse_tag(std::string_view tag, Game_record& game) {
+        size_t key_end = tag.find_first_of(" \t");
+        size_t open = tag.find('"'), close = tag.rfind('"');
+        if (key_end == std::string::npos || open == std::string::npos || close <= open)
+            return;
+        std::string_view key = tag.substr(0, key_end);
+        Scratch_string value(&scratch);
+        for (size_t i = open + 1; i < close; i++) {
+            if (tag[i] == '\\' && i + 1 < close) i++;
+            value += tag[i];
+        }
+        if (key == "FEN") game.start_fen = value;
+        else if (key == "Result") parse_result(value, game.result);
+        else if (key != "SetUp") game.tags.emplace_back(std::string(key), std::string(value));
+    }
+
+public:
+    _Pgn_reader(std::istream& in) : in(in), move_in(&piece_types), scratch(16 << 10) {
+        piece_types.insert(new Knight());
+        piece_types.insert(new Bishop());
+        piece_types.insert(new Rook());
+        piece_types.insert(new Queen());
+        piece_types.insert(new King());
+    }
+
+    ~_Pgn_reader() {
+        for (auto& ptype_ptr : piece_types)
+            delete ptype_ptr;
+        piece_types.clear();
+    }
+
+    bool next_game(Game_record& game, std::string* error) {
+        game.clear();
+        if (error) error->clear();
+        scratch.reset();
+        Position pos;
+        bool seen_tags = false, seen_moves = false, failed = false;
+        char ch;
+
+        while (in.get(ch)) {
+            if (std::isspace((unsigned char) ch))
+                continue;
+            if (ch == '[') {
+                // A tag after movetext belongs to the next game (previous one had no result token)
+                if (seen_moves) {
+                    in.unget();
+                    return true;
+                }
+                Scratch_string tag(&scratch);
+                while (in.get(ch) && ch != ']') tag += ch;
+                parse_tag(tag, game);
+                seen_tags = true;
+                continue;
+            }
+            if (ch == '{') { skip_until('}'); continue; }
+            if (ch == '(') { skip_until(')'); continue; }
+            if (ch == ';' || ch == '%') {
+                while (in.get(ch) && ch != '\n');
+                continue;
+            }
+
+            Scratch_string token(1, ch, &scratch);
+            while (in.get(ch) && !std::isspace((unsigned char) ch) && !std::strchr("{}()[];", ch)) token += ch;
+            if (in) in.unget();
+
+            if (parse_result(token, game.result))
+                return true;
+            if (token[0] == '$')
+                continue;                                       // NAG
+            if (!seen_moves) {
+                seen_moves = true;
+                if (!game.start_position(pos)) {
+                    failed = true;
+                    if (error) *error = "bad FEN " + game.start_fen;
+                }
+            }
+            // Strip move number ("12." / "12..." / "12.e4") and annotation glyphs ("e4!?")
+            size_t start = token.find_first_not_of("0123456789.");
+            if (start == std::string::npos || failed)
+                continue;
+            token.erase(0, start);
+            while (!token.empty() && (token.back() == '!' || token.back() == '?')) token.pop_back();
+            if (token.rfind("0-0", 0) == 0)
+                std::replace(token.begin(), token.end(), '0', 'O');
+
+            move_in = std::string(token);
+            Move16 move = pos.find_move(move_in);
+            if (move.is_null()) {
+                failed = true;
+                if (error) *error = "illegal or ambiguous move " + std::string(token) + " in " + pos.fen();
+                continue;
+            }
+            game.moves.push_back(move);
+            pos.play(move);
+        }
+        return seen_tags || seen_moves;
+    }
+};
+
+Pgn_reader::Pgn_reader(std::istream& in) {
+    reader = new _Pgn_reader(in);
+}
+
+Pgn_reader::~Pgn_reader() {
+    delete reader;
+}
+
+bool Pgn_reader::next_game(Game_record& game, std::string* error) {
+    return reader->next_game(game, error);
+}
+
+
+// ------------------------------------------------------------------------------ PGN writer ----------------------------------------------------------------------------
+
+const char* result_string(Game_result result) {
+    switch (result) {
+        case WHITE_WINS: return "1-0";
+        case BLACK_WINS: return "0-1";
+        case DRAWN: return "1/2-1/2";
+        default: return "*";
+    }
+}
+
+static std::string escape_tag(const std::string& value) {
+    std::string out;
+    for (char ch : value) {
+        if (ch == '"' || ch == '\\') out += '\\';
+        out += ch;
+    }
+    return out;
+}
+
+void write_pgn(std::ostream& out, const Game_record& game) {
+    for (auto& [key, value] : game.tags)
+        out << "[" << key << " \"" << escape_tag(value) << "\"]\n";
+    if (!game.start_fen.empty())
+        out << "[SetUp \"1\"]\n[FEN \"" << game.start_fen << "\"]\n";
+    out << "[Result \"" << result_string(game.result) << "\"]\n\n";
+
+    Position pos;
+    game.start_position(pos);
+    std::string line;
+    char san[SAN_MAX];
+    auto emit = [&](std::string_view word) {
+        if (!line.empty() && line.size() + 1 + word.size() > 79) {
+            out << line << "\n";
+            line.clear();
+        }
+        if (!line.empty()) line += ' ';
+        line += word;
+    };
+    for (size_t ply = 0; ply < game.moves.size(); ply++) {
+        if (pos.turn == WHITE)
+            emit(std::to_string(pos.fullmove) + ".");
+        else if (ply == 0)
+            emit(std::to_string(pos.fullmove) + "...");
+        emit(std::string_view(san, pos.write_san(game.moves[ply], san)));
+        pos.play(game.moves[ply]);
+    }
+    emit(result_string(game.result));
+    out << line << "\n\n";
+}
+
+
+// ------------------------------------------------------------------------------ Converters ----------------------------------------------------------------------------
+
+uint64_t pgn_to_record(const std::string& pgn_path, const std::string& record_path, uint64_t* skipped) {
+    std::ifstream in(pgn_path);
+    Record_writer writer;
+    if (skipped) *skipped = 0;
+    if (!in || !writer.open(record_path))
+        return 0;
+
+    Pgn_reader reader(in);
+    Game_record game;
+    std::string error;
+    // Traced a chunk of games at a time, a span per game would be too fine and would soon overwrite the whole ring
+    const int TRACE_CHUNK = 256;
+    uint64_t parsed = 0;
+    for (bool more = true; more; ) {
+        CHESS_TRACE_SPAN_ARG("pgn_chunk", "first_game", (int64_t) parsed);
+        for (int i = 0; i < TRACE_CHUNK && (more = reader.next_game(game, &error)); i++, parsed++) {
+            if (!error.empty() || !writer.write_game(game)) {
+                if (skipped) (*skipped)++;
+            }
+        }
+    }
+    uint64_t count = writer.game_count();
+    return writer.close() ? count : 0;
+}
+
+uint64_t record_to_pgn(const std::string& record_path, const std::string& pgn_path) {
+    Record_reader reader;
+    std::ofstream out(pgn_path);
+    if (!out || !reader.open(record_path))
+        return 0;
+
+    Game_record game;
+    uint64_t count = 0;
+    while (reader.next_game(game)) {
+        write_pgn(out, game);
+        count++;
+    }
+    return count;
+}
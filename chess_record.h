@@ -0,0 +1,142 @@
+#ifndef CHESS_RECORD_H
+#define CHESS_RECORD_H
+
+#include "chess_common.h"
+#include "chess_position.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <fstream>
+
+// Compact binary game-record format (.cgr)
+//
+// Each move is stored as its index into the legal moves of the position it was played from, in a fixed order of their own (see
+// record_order() in chess_record.cpp, the generator's order may change), as a LEB128 varint
+// (always a single byte in standard chess, as there are never more than 218 legal moves). So decoding needs a move generator,
+// but the encoding is ~1 byte per ply instead of a SAN string.
+//
+// File layout (all fixed-width integers little endian) :
+//   File header   : "CHESSREC" | u32 version | u32 block target size
+//   Blocks        : u8 codec | u32 raw size | u32 stored size | u32 game count | payload (stored size bytes)
+//   Block index   : per block, u64 file offset | u64 id of first game in block
+//   Trailer       : u64 index offset | u64 block count | u64 game count | "CGRINDEX"
+// Uncompressed block payload is games back to back, each one being :
+//   varint game size (bytes after this varint) | u8 result | varint tag count | (varint len, key, varint len, value) * tags
+//   | varint FEN len, FEN (0 if standard start) | varint ply count | varint move index * plies
+// Blocks are compressed independently (small LZ77 codec, see chess_record.cpp), so seeking game N means one binary search over
+// the block index, decompressing one block and skipping games by their size prefix.
+
+typedef enum game_result {
+    RESULT_UNKNOWN,         // "*"
+    WHITE_WINS,             // "1-0"
+    BLACK_WINS,             // "0-1"
+    DRAWN                   // "1/2-1/2"
+} Game_result;
+
+struct Game_record {
+    std::vector<std::pair<std::string, std::string>> tags;     // PGN tags, except SetUp / FEN / Result (those have own fields)
+    std::string start_fen;                                      // Empty for standard starting position
+    Game_result result;
+    std::vector<Move16> moves;
+
+    Game_record() : result(RESULT_UNKNOWN) {}
+
+    void clear() {
+        tags.clear();
+        start_fen.clear();
+        result = RESULT_UNKNOWN;
+        moves.clear();
+    }
+
+    // Starting position of the game (standard one, or from start_fen). False if start_fen is bad
+    bool start_position(Position& pos) const;
+};
+
+// Streaming encoder. Games are appended to the current block, which is compressed & flushed once it reaches the target size.
+// close() MUST be called for the file to be readable, as the index & trailer are written only then.
+class Record_writer {
+    std::ofstream out;
+    std::vector<uint8_t> block;                 // Raw (uncompressed) payload of current block
+    std::vector<uint8_t> scratch;
+    std::vector<std::pair<uint64_t, uint64_t>> index;   // {file offset, first game id} per block
+    uint64_t games, block_first_game;
+    uint32_t block_games;
+    uint32_t block_target;
+
+    bool flush_block();
+
+public:
+    const static uint32_t DEFAULT_BLOCK_SIZE;
+
+    Record_writer();
+
+    ~Record_writer();
+
+    bool open(const std::string& path, uint32_t block_target = DEFAULT_BLOCK_SIZE);
+
+    // Moves must be legal from the game's start position, and the encoded game at most 1 MB (tags included) : returns false
+    // otherwise (nothing is written then)
+    bool write_game(const Game_record& game);
+
+    bool close();
+
+    uint64_t game_count() {
+        return games;
+    }
+};
+
+// Streaming decoder. next_game() reads games in file order, seek() jumps anywhere using the block index.
+class Record_reader {
+    std::ifstream in;
+    std::vector<std::pair<uint64_t, uint64_t>> index;
+    std::vector<uint8_t> block;
+    std::vector<uint8_t> stored;
+    size_t block_pos;                           // Read position inside block
+    uint64_t next_block;                        // Index of the block to load once current one is exhausted
+    uint64_t games;
+    uint32_t block_target;                      // From the file header, bounds block sizes
+
+    bool load_block(uint64_t block_id);
+
+public:
+    Record_reader();
+
+    bool open(const std::string& path);
+
+    uint64_t game_count() {
+        return games;
+    }
+
+    // Position the reader so the next call to next_game() returns game number game_id (0-based)
+    bool seek(uint64_t game_id);
+
+    // Decode the next game, replaying it to recover moves. False at end of file or on corrupt data
+    bool next_game(Game_record& game);
+};
+
+// ------------------------------------------------------------------------------ PGN conversion ------------------------------------------------------------------------
+
+class _Pgn_reader;          // Hidden implementation (needs PType_set for SAN parsing)
+
+// Reads games one at a time from a PGN stream. Comments, variations and NAGs are skipped, only the main line is kept.
+class Pgn_reader {
+    _Pgn_reader* reader;
+public:
+    Pgn_reader(std::istream& in);
+
+    ~Pgn_reader();
+
+    // False at end of input. A game with an illegal / unparseable move still returns true, with error set and moves up to that point
+    bool next_game(Game_record& game, std::string* error = nullptr);
+};
+
+void write_pgn(std::ostream& out, const Game_record& game);
+
+const char* result_string(Game_result result);
+
+// Whole-file converters, return number of games converted (games with bad moves are skipped and counted in *skipped)
+uint64_t pgn_to_record(const std::string& pgn_path, const std::string& record_path, uint64_t* skipped = nullptr);
+
+uint64_t record_to_pgn(const std::string& record_path, const std::string& pgn_path);
+
+#endif
@@ -0,0 +1,299 @@
+#include "chess_search.h"
+#include "chess_bitbase.h"
+#include "chess_eval.h"
+#include "chess_stats.h"
+#include "chess_trace.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// Mate & bitbase win scores are stored in the hash table relative to the node (mate in n from here), and relative to root everywhere else
+static int score_to_tt(int score, int ply) {
+    if (score >= WIN_BOUND) return score + ply;
+    if (score <= -WIN_BOUND) return score - ply;
+    return score;
+}
+
+static int score_from_tt(int score, int ply) {
+    if (score >= WIN_BOUND) return score - ply;
+    if (score <= -WIN_BOUND) return score + ply;
+    return score;
+}
+
+Search::Search(size_t tt_mb) : tt(tt_mb), nodes(0), stopped(false), bitbases(nullptr), bitbase_men(0), root_excluded_count(0) {
+    order.clear();
+    std::memset(pv_length, 0, sizeof(pv_length));
+}
+
+void Search::clear() {
+    tt.clear();
+    pawns.clear();
+    order.clear();
+    ordering.clear();
+}
+
+int Search::negamax(const Position& pos, int depth, int alpha, int beta, int ply, Move16 prev) {
+    pv_length[ply] = ply;
+    if (ply > 0) {
+        // Draws : one repetition is enough inside the search, if it's good for either side to repeat once it is to repeat again.
+        // Checkmate on the 100th ply is still a mate, leave that to the search
+        if (pos.halfmove_clock >= 4 && keys.repetitions(pos.halfmove_clock, 1)) {
+            nodes++;
+            return 0;
+        }
+        if (pos.halfmove_clock >= 100 && (!pos.in_check() || pos.has_legal_moves())) {
+            nodes++;
+            return 0;
+        }
+        // Side to move can at least force a repetition, so it's never worse than a draw
+        if (alpha < 0 && keys.upcoming_repetition(pos, ply)) {
+            alpha = 0;
+            if (alpha >= beta)
+                return alpha;
+        }
+        // Exact result from the tables : wins rank below mates, so a mate found by the search still beats "won"
+        Wdl wdl;
+        if (popcount(pos.occupied()) <= bitbase_men && bitbases->probe(pos, wdl)) {
+            nodes++;
+            return (wdl == WDL_WIN) ? BITBASE_WIN - ply : (wdl == WDL_LOSS) ? -BITBASE_WIN + ply : 0;
+        }
+    }
+    if (depth <= 0 || ply >= MAX_PLY - 1) {
+        if (options.quiescence)
+            return quiescence(pos, alpha, beta, ply);
+        nodes++;                                        // Leaf counts as a node, so node counts compare with quiescence ones
+        return evaluate(pos, &pawns);
+    }
+
+    nodes++;
+    CHESS_STAT_COUNT(STAT_SEARCH_NODES);
+    if (out_of_budget()) {
+        stopped = true;
+        return 0;
+    }
+
+    Move16 tt_move;
+    const TT_entry* entry = tt.probe(pos.key);
+    if (entry) {
+        tt_move = entry->move;
+        int tt_score = score_from_tt(entry->score, ply);
+        if (ply > 0 && entry->depth >= depth && (entry->bound == BOUND_EXACT
+            || (entry->bound == BOUND_LOWER && tt_score >= beta) || (entry->bound == BOUND_UPPER && tt_score <= alpha)))
+            return tt_score;
+    }
+
+    int alpha_orig = alpha, best = -SCORE_INFINITE, legal = 0;
+    Move16 best_move;
+    Move16 quiets[MAX_MOVES];
+    int quiet_count = 0;
+    Bitboard pinned_pieces = pos.pinned(pos.turn);
+    bool check = pos.in_check();
+
+    Move_picker picker(pos, tt_move, order, ply, order.counter_move(pos, prev));
+    for (Move16 move = picker.next(); !move.is_null(); move = picker.next()) {
+        if (!pos.is_legal(move, pinned_pieces, check))
+            continue;
+        if (ply == 0 && std::find(root_excluded, root_excluded + root_excluded_count, move) != root_excluded + root_excluded_count)
+            continue;
+        bool quiet = pos.piece_on(move.dst()) == PIECE_MAX && move.flag() != Move16::PROMOTION && move.flag() != Move16::EN_PASSANT;
+
+        Position next = pos;
+        next.play(move);
+        keys.push(next.key);
+        int score = -negamax(next, depth - 1, -beta, -alpha, ply + 1, move);
+        keys.pop();
+        if (stopped)
+            return 0;
+        legal++;
+
+        if (score > best) {
+            best = score;
+            best_move = move;
+            if (score > alpha) {
+                alpha = score;
+                pv[ply][ply] = move;
+                for (int i = ply + 1; i < pv_length[ply + 1]; i++)
+                    pv[ply][i] = pv[ply + 1][i];
+                pv_length[ply] = std::max(ply + 1, pv_length[ply + 1]);
+                if (alpha >= beta) {
+                    ordering.record_cutoff(legal - 1);
+                    if (quiet)
+                        order.update_quiet(pos, move, quiets, quiet_count, depth, ply, prev);
+                    break;
+                }
+            }
+        }
+        if (quiet)
+            quiets[quiet_count++] = move;
+    }
+
+    if (legal == 0)
+        return check ? -MATE_SCORE + ply : 0;
+
+    // A root searched with moves left out isn't the real root score
+    if (ply > 0 || root_excluded_count == 0) {
+        Bound bound = (best >= beta) ? BOUND_LOWER : (best > alpha_orig) ? BOUND_EXACT : BOUND_UPPER;
+        tt.store(pos.key, best_move, score_to_tt(best, ply), depth, bound);
+    }
+    return best;
+}
+
+int Search::quiescence(const Position& pos, int alpha, int beta, int ply) {
+    pv_length[ply] = ply;
+    nodes++;
+    CHESS_STAT_COUNT(STAT_QSEARCH_NODES);
+    if (out_of_budget()) {
+        stopped = true;
+        return 0;
+    }
+    bool check = pos.in_check();
+    if (ply >= MAX_PLY - 1)
+        return check ? 0 : evaluate(pos, &pawns);
+
+    // Stand pat : side to move can usually do at least as well as the static eval by playing some quiet move. Not when in check,
+    // then all evasions are searched instead
+    int stand_pat = check ? -SCORE_INFINITE : evaluate(pos, &pawns);
+    if (stand_pat >= beta)
+        return stand_pat;
+    alpha = std::max(alpha, stand_pat);
+    int best = stand_pat, legal = 0;
+
+    // Delta pruning margin : winning the victim must still leave a couple of pawns' worth of slack to beat alpha
+    const int delta_margin = 2 * PIECE_VALUE[PAWN];
+    Bitboard pinned_pieces = pos.pinned(pos.turn);
+
+    // Quiescence picker drops losing captures (SEE < 0) itself, unless SEE pruning is off
+    Move_picker picker = check ? Move_picker(pos, Move16(), order, ply, Move16()) : Move_picker(pos, order, options.see_pruning);
+    for (Move16 move = picker.next(); !move.is_null(); move = picker.next()) {
+        if (!pos.is_legal(move, pinned_pieces, check))
+            continue;
+        legal++;
+        if (!check && options.delta_pruning && move.flag() != Move16::PROMOTION) {
+            int victim = (move.flag() == Move16::EN_PASSANT) ? PIECE_VALUE[PAWN] : PIECE_VALUE[pos.piece_on(move.dst())];
+            if (stand_pat + victim + delta_margin <= alpha)
+                continue;
+        }
+
+        Position next = pos;
+        next.play(move);
+        int score = -quiescence(next, -beta, -alpha, ply + 1);
+        if (stopped)
+            return 0;
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                pv[ply][ply] = move;
+                for (int i = ply + 1; i < pv_length[ply + 1]; i++)
+                    pv[ply][i] = pv[ply + 1][i];
+                pv_length[ply] = std::max(ply + 1, pv_length[ply + 1]);
+                if (alpha >= beta)
+                    break;
+            }
+        }
+    }
+    if (check && legal == 0)
+        return -MATE_SCORE + ply;
+    return best;
+}
+
+Search_result Search::search(const Position& root, const Search_limits& limits, const Key_history* history) {
+    CHESS_TRACE_SPAN("search");
+    this->limits = limits;
+    if (history && history->size() && history->back() == root.key)
+        keys = *history;
+    else
+        keys.reset(root.key);
+    nodes = 0;
+    stopped = false;
+    bitbase_men = (bitbases && popcount(root.occupied()) > bitbases->max_men()) ? bitbases->max_men() : 0;
+    timer.start(limits.clock, root.turn);
+    tt.new_search();
+
+    // Root lines of the last completed iteration & of the one running, each slot with room for a full PV. Swapped after every
+    // iteration, the result's vectors are only filled in once at the end
+    struct Root_line {
+        Move16 move;
+        int score;
+        int length;
+        Move16* pv;
+        uint64_t nodes;
+    };
+    Arena_scope scope(arena);
+    Search_result result;
+    uint64_t last_iteration_nodes = 0;
+    Move16 root_moves[MAX_MOVES];
+    int multi_pv = std::max(1, std::min(limits.multi_pv, root.generate_moves(root_moves)));
+    uint64_t* slot_nodes = arena.make_array<uint64_t>(multi_pv);
+    Root_line* completed = arena.make_array<Root_line>(multi_pv);
+    Root_line* running = arena.make_array<Root_line>(multi_pv);
+    for (int slot = 0; slot < multi_pv; slot++) {
+        completed[slot].pv = arena.make_array<Move16>(MAX_PLY);
+        running[slot].pv = arena.make_array<Move16>(MAX_PLY);
+    }
+    int completed_count = 0;
+    for (int depth = 1; depth <= limits.depth && depth < MAX_PLY; depth++) {
+        CHESS_TRACE_SPAN_ARG("iteration", "depth", depth);
+        uint64_t before = nodes;
+        double iteration_start = timer.elapsed();
+        int count = 0;
+        root_excluded_count = 0;
+        for (int slot = 0; slot < multi_pv; slot++) {
+            uint64_t slot_start = nodes;
+            int score = negamax(root, depth, -SCORE_INFINITE, SCORE_INFINITE, 0, Move16());
+            slot_nodes[slot] += nodes - slot_start;
+            if (stopped || pv_length[0] == 0)
+                break;
+            Root_line& line = running[count++];
+            line.move = pv[0][0];
+            line.score = score;
+            line.length = pv_length[0];
+            std::copy(pv[0], pv[0] + pv_length[0], line.pv);
+            root_excluded[root_excluded_count++] = line.move;
+        }
+        root_excluded_count = 0;
+        if (stopped)
+            break;                                  // Unfinished iteration, keep the previous one's result
+
+        uint64_t iteration_nodes = nodes - before;
+        result.depth = depth;
+        std::swap(completed, running);
+        completed_count = count;
+        for (int i = 0; i < count; i++)
+            completed[i].nodes = slot_nodes[i];
+        if (count) {
+            result.score = completed[0].score;
+            result.best_move = completed[0].move;
+        }
+        int score = result.score;
+        if (last_iteration_nodes)
+            result.branching_factor = (double) iteration_nodes / last_iteration_nodes;
+        last_iteration_nodes = iteration_nodes;
+
+        // Mate found within the full-width horizon, deeper iterations can't find a shorter one
+        if (std::abs(score) >= MATE_BOUND && MATE_SCORE - std::abs(score) <= depth)
+            break;
+        if (timer.iteration_done(result.best_move, timer.elapsed() - iteration_start, result.branching_factor))
+            break;
+    }
+    result.lines.resize(completed_count);
+    for (int i = 0; i < completed_count; i++) {
+        Pv_line& line = result.lines[i];
+        line.move = completed[i].move;
+        line.score = completed[i].score;
+        line.pv.assign(completed[i].pv, completed[i].pv + completed[i].length);
+        line.nodes = completed[i].nodes;
+    }
+    if (completed_count)
+        result.pv = result.lines[0].pv;
+    result.nodes = nodes;
+
+    // Not even depth 1 completed (tiny node limit) : any legal move beats none
+    if (result.best_move.is_null()) {
+        Move16 list[MAX_MOVES];
+        if (root.generate_moves(list))
+            result.best_move = list[0];
+    }
+    timer.stop();
+    return result;
+}
@@ -0,0 +1,156 @@
+#ifndef CHESS_SEARCH_H
+#define CHESS_SEARCH_H
+
+#include "chess_common.h"
+#include "chess_position.h"
+#include "chess_history.h"
+#include "chess_movepick.h"
+#include "chess_tt.h"
+#include "chess_eval.h"
+#include "chess_arena.h"
+#include "chess_time.h"
+
+constexpr int SCORE_INFINITE = 32001;
+constexpr int MATE_SCORE = 32000;                       // Mate at root ; mate in n plies scores MATE_SCORE - n
+constexpr int MATE_BOUND = MATE_SCORE - MAX_PLY;        // Anything beyond this is a mate score
+constexpr int BITBASE_WIN = MATE_BOUND - MAX_PLY;       // Bitbase win at root, less ply : above any eval, below any mate
+constexpr int WIN_BOUND = BITBASE_WIN - MAX_PLY;        // Anything beyond this is a bitbase win or a mate, and depends on ply
+
+class Bitbases;
+
+struct Search_limits {
+    int depth;
+    uint64_t nodes;                     // 0 = no limit
+    Time_control clock;                 // Unset = no time limit
+    int multi_pv;                       // Best root moves to rank, each with its own score & line (capped to the legal moves)
+
+    Search_limits() : depth(MAX_PLY - 1), nodes(0), multi_pv(1) {}
+};
+
+// Search features that can be switched off, mostly to measure what each of them buys
+struct Search_options {
+    bool quiescence;                    // Off : plain fixed-depth alpha-beta, static eval at the horizon
+    bool see_pruning;                   // Skip losing captures (SEE < 0) in quiescence
+    bool delta_pruning;                 // Skip captures in quiescence that can't raise alpha even winning the victim + margin
+
+    Search_options() : quiescence(true), see_pruning(true), delta_pruning(true) {}
+};
+
+// One ranked root move in MultiPV mode
+struct Pv_line {
+    Move16 move;
+    int score;
+    std::vector<Move16> pv;
+    uint64_t nodes;                     // Spent on this slot over all iterations : the marginal cost of asking for it
+
+    Pv_line() : score(0), nodes(0) {}
+};
+
+struct Search_result {
+    Move16 best_move;
+    int score;
+    int depth;                          // Last fully completed iteration
+    uint64_t nodes;
+    std::vector<Move16> pv;
+    double branching_factor;            // Effective branching factor, nodes of last iteration / nodes of the one before
+    std::vector<Pv_line> lines;         // Best first, limits.multi_pv of them (lines[0] is best_move, score & pv above)
+
+    Search_result() : score(0), depth(0), nodes(0), branching_factor(0.0) {}
+};
+
+// Iterative deepening alpha-beta (negamax) over Position, with transposition table and staged move ordering (chess_movepick.h).
+// One Search object is meant to be reused across moves of a game, so hash table & ordering tables stay warm.
+class Search {
+    Transposition_table tt;
+    Pawn_table pawns;                   // This search's own, so threads never share one
+    Move_order order;
+    Ordering_stats ordering;
+    Search_limits limits;
+    Time_manager timer;
+    Key_history keys;                   // Game positions before the root, then the current search line
+    uint64_t nodes;
+    bool stopped;
+    const Bitbases* bitbases;           // Endgame tables, nullptr if none
+    int bitbase_men;                    // Probed at this many men or fewer in this search (0 : not at all)
+
+    Move16 pv[MAX_PLY][MAX_PLY];        // Triangular PV table, pv[ply] is the best line from ply onwards
+    int pv_length[MAX_PLY];
+
+    // Scratch of one search() call (root lines of the iterations), released as it returns. Warm after the first search, so searching
+    // allocates nothing beyond the Search_result it hands back
+    Arena arena;
+
+    // MultiPV : root moves already ranked in this iteration, the next slot searches the others only. The same tables (TT, ordering)
+    // serve every slot, so later ones mostly re-walk trees the first one left in the hash table
+    Move16 root_excluded[MAX_MOVES];
+    int root_excluded_count;
+
+    // Checked at every node : node limit, or hard time limit (clock only read every timer.check_interval nodes)
+    bool out_of_budget() {
+        return (limits.nodes && nodes >= limits.nodes) || timer.tick();
+    }
+
+    int negamax(const Position& pos, int depth, int alpha, int beta, int ply, Move16 prev);
+
+    // Resolve captures & promotions past the horizon, so that static eval is only taken in quiet positions
+    int quiescence(const Position& pos, int alpha, int beta, int ply);
+
+public:
+    Search_options options;
+
+    Search(size_t tt_mb = 16);
+
+    // history : positions of the game so far (ending with root), so repetitions against the game are seen. Without it the search
+    // only knows about repetitions within its own lines
+    Search_result search(const Position& root, const Search_limits& limits = Search_limits(), const Key_history* history = nullptr);
+
+    // Forget everything learned (new game)
+    void clear();
+
+    void resize_tt(size_t mb) {
+        tt.resize(mb);
+    }
+
+    // Persistent warm caches : hash table & pawn cache backed by path + ".tt" / ".pawns" (chess_mapped.h), so a restarted process
+    // picks up where the last one left off. Saved when the Search goes away (or on unmap_caches()), a crash only costs the warmth.
+    // Each table falls back to an empty one (status says why) if its file is missing, stale or corrupt
+    struct Cache_status {
+        Mapped_status tt, pawns;
+    };
+
+    Cache_status map_caches(const std::string& path, size_t tt_mb) {
+        return Cache_status{tt.map_file(path + ".tt", tt_mb), pawns.map_file(path + ".pawns")};
+    }
+
+    void unmap_caches() {
+        tt.unmap_file();
+        pawns.unmap_file();
+    }
+
+    // Win / draw / loss tables probed inside the search (not at the root, nor when the root is already covered by them, so the
+    // search still plays the ending out). The tables must outlive the Search, nullptr turns probing off
+    void use_bitbases(const Bitbases* tables) {
+        bitbases = tables;
+    }
+
+    // Timing of the last searches, and the knobs (check interval) : see chess_time.h
+    Time_manager& time_manager() {
+        return timer;
+    }
+
+    // Cutoff statistics accumulated since the last clear_stats()
+    const Ordering_stats& ordering_stats() {
+        return ordering;
+    }
+
+    void clear_stats() {
+        ordering.clear();
+    }
+
+    // Pawn structure cache, for its hit rate
+    const Pawn_table& pawn_table() const {
+        return pawns;
+    }
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef CHESS_SEQLOCK_H
+#define CHESS_SEQLOCK_H
+
+#include "chess_common.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+// Sequence lock : one writer publishes a small trivially copyable value, any number of readers take consistent copies of it.
+// The writer never waits on readers (a store is two counter bumps around a copy), readers never block the writer, they retry if
+// a store overlapped their copy (odd counter, or the counter moved). Payload is kept in relaxed atomic words, so racing reads are
+// well-defined, and copied out only once a read is known to be consistent.
+template<typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable_v<T>, "Seqlock copies its value word by word");
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    alignas(64) std::atomic<uint32_t> sequence;         // Odd while a store is in progress
+    std::atomic<uint64_t> words[WORDS];
+
+public:
+    Seqlock() : sequence(0) {
+        store(T{});
+    }
+
+    // Writer side, one writer thread at a time
+    void store(const T& value) {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++)
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // One attempt : false if a store got in the way (out is then garbage)
+    bool try_load(T& out) const {
+        uint32_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            return false;
+        uint64_t buffer[WORDS];
+        for (size_t i = 0; i < WORDS; i++)
+            buffer[i] = words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) != before)
+            return false;
+        std::memcpy(&out, buffer, sizeof(T));
+        return true;
+    }
+
+    // Retries until consistent. Yields now and then, in case the writer got preempted in the middle of a store
+    T load() const {
+        T out;
+        for (int attempt = 1; !try_load(out); attempt++)
+            if (attempt % 64 == 0)
+                std::this_thread::yield();
+        return out;
+    }
+
+    // Stores so far (changes whenever the value may have)
+    uint32_t version() const {
+        return sequence.load(std::memory_order_acquire) >> 1;
+    }
+};
+
+#endif
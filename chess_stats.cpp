@@ -0,0 +1,132 @@
+#include "chess_stats.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+const char* const Chess_stats::NAMES[STAT_MAX] = {
+    "parse_move",
+    "play_if_valid",
+    "castle",
+    "piece_push_back",
+    "piece_remove",
+    "movegen",
+    "search_nodes",
+    "qsearch_nodes"
+};
+
+Chess_stats::Chess_stats() : threads(0) {
+#ifdef CHESS_STATS
+    enabled = true;
+#else
+    enabled = false;
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+    tick_unit = "cycles";
+#else
+    tick_unit = "ns";
+#endif
+    std::fill_n(totals, STAT_MAX, Stat_totals{0, 0, 0});
+}
+
+std::string Chess_stats::to_text() const {
+    std::string out;
+    char line[128];
+    std::snprintf(line, sizeof(line), "Instrumentation %s, %d thread(s)\n", enabled ? "enabled" : "compiled out", threads);
+    out += line;
+    std::snprintf(line, sizeof(line), "%-16s %14s %14s %12s %16s\n", "counter", "calls", "timed", "per call", tick_unit);
+    out += line;
+    for (int i = 0; i < STAT_MAX; i++) {
+        const Stat_totals& t = totals[i];
+        std::snprintf(line, sizeof(line), "%-16s %14llu %14llu %12.1f %16.0f\n", NAMES[i], (unsigned long long) t.calls,
+                      (unsigned long long) t.timed, t.ticks_per_call(), t.total_ticks());
+        out += line;
+    }
+    return out;
+}
+
+std::string Chess_stats::to_json() const {
+    std::string out;
+    char item[160];
+    std::snprintf(item, sizeof(item), "{\"enabled\":%s,\"threads\":%d,\"tick_unit\":\"%s\",\"counters\":{", enabled ? "true" : "false",
+                  threads, tick_unit);
+    out += item;
+    for (int i = 0; i < STAT_MAX; i++) {
+        std::snprintf(item, sizeof(item), "%s\"%s\":{\"calls\":%llu,\"timed\":%llu,\"ticks\":%llu}", i ? "," : "", NAMES[i],
+                      (unsigned long long) totals[i].calls, (unsigned long long) totals[i].timed, (unsigned long long) totals[i].ticks);
+        out += item;
+    }
+    out += "}}";
+    return out;
+}
+
+namespace chess_ns {
+    // Live threads' blocks, plus what exited threads counted
+    struct Stats_registry {
+        std::mutex lock;
+        std::vector<Thread_stats*> live;
+        Stat_totals exited[STAT_MAX];
+        int exited_threads;
+
+        Stats_registry() : exited{}, exited_threads(0) {}
+    };
+
+    static Stats_registry& registry() {
+        static Stats_registry* instance = new Stats_registry();     // Never destroyed, threads may exit after static destructors ran
+        return *instance;
+    }
+
+    Thread_stats::Thread_stats() {
+        for (int i = 0; i < STAT_MAX; i++) {
+            calls[i].store(0, std::memory_order_relaxed);
+            timed[i].store(0, std::memory_order_relaxed);
+            ticks[i].store(0, std::memory_order_relaxed);
+        }
+        Stats_registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        r.live.push_back(this);
+    }
+
+    Thread_stats::~Thread_stats() {
+        Stats_registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        for (int i = 0; i < STAT_MAX; i++) {
+            r.exited[i].calls += calls[i].load(std::memory_order_relaxed);
+            r.exited[i].timed += timed[i].load(std::memory_order_relaxed);
+            r.exited[i].ticks += ticks[i].load(std::memory_order_relaxed);
+        }
+        r.exited_threads++;
+        r.live.erase(std::find(r.live.begin(), r.live.end(), this));
+    }
+
+    // Counts racing with the reset (other threads mid-operation) may survive it, fine for statistics
+    void reset_stats() {
+        Stats_registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        for (Thread_stats* t : r.live) {
+            for (int i = 0; i < STAT_MAX; i++) {
+                t->calls[i].store(0, std::memory_order_relaxed);
+                t->timed[i].store(0, std::memory_order_relaxed);
+                t->ticks[i].store(0, std::memory_order_relaxed);
+            }
+        }
+        std::fill_n(r.exited, STAT_MAX, Stat_totals{0, 0, 0});
+        r.exited_threads = 0;
+    }
+
+    Chess_stats collect_stats() {
+        Chess_stats stats;
+        Stats_registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        std::copy_n(r.exited, STAT_MAX, stats.totals);
+        for (Thread_stats* t : r.live) {
+            for (int i = 0; i < STAT_MAX; i++) {
+                stats.totals[i].calls += t->calls[i].load(std::memory_order_relaxed);
+                stats.totals[i].timed += t->timed[i].load(std::memory_order_relaxed);
+                stats.totals[i].ticks += t->ticks[i].load(std::memory_order_relaxed);
+            }
+        }
+        stats.threads = r.exited_threads + (int) r.live.size();
+        return stats;
+    }
+}
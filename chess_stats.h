@@ -0,0 +1,133 @@
+#ifndef CHESS_STATS_H
+#define CHESS_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Hot-path instrumentation : call counts and elapsed ticks for the library's core operations, compiled in only with -DCHESS_STATS.
+// Without it the CHESS_STAT_* macros expand to nothing, and Chess::stats() reports enabled = false with all zeros.
+//
+// Each thread counts into its own cache-line aligned block (no sharing, no locking on the hot path), blocks are summed on demand.
+// Every call is counted, but only one in CHESS_STATS_SAMPLE is timed : reading the clock costs about as much as a short call itself.
+// Ticks are TSC cycles on x86, nanoseconds elsewhere.
+
+#ifndef CHESS_STATS_SAMPLE
+#define CHESS_STATS_SAMPLE 16           // Power of 2
+#endif
+
+typedef enum stat_id {
+    STAT_PARSE_MOVE,            // _Move::parse_move
+    STAT_PLAY_IF_VALID,         // Board::play_if_valid
+    STAT_CASTLE,                // Board::castle
+    STAT_PIECE_PUSH_BACK,       // PieceID_map::push_back
+    STAT_PIECE_REMOVE,          // PieceID_map::remove
+    STAT_MOVEGEN,               // Position::generate_pseudo (legal generation goes through it too)
+    STAT_SEARCH_NODES,          // Search::negamax nodes (count only)
+    STAT_QSEARCH_NODES,         // Search::quiescence nodes (count only)
+    STAT_MAX
+} Stat_id;
+
+struct Stat_totals {
+    uint64_t calls;
+    uint64_t timed;                     // Calls that were timed (sampled)
+    uint64_t ticks;                     // Over the timed calls only
+
+    double ticks_per_call() const {
+        return timed ? (double) ticks / timed : 0.0;
+    }
+
+    // Estimated total over all calls
+    double total_ticks() const {
+        return ticks_per_call() * calls;
+    }
+};
+
+// Aggregated snapshot, as returned by Chess::stats()
+struct Chess_stats {
+    static const char* const NAMES[STAT_MAX];
+
+    bool enabled;                       // Compiled with CHESS_STATS
+    int threads;                        // Threads that have counted anything so far (live + exited)
+    const char* tick_unit;              // "cycles" or "ns"
+    Stat_totals totals[STAT_MAX];
+
+    Chess_stats();
+
+    std::string to_text() const;
+
+    std::string to_json() const;
+};
+
+namespace chess_ns {
+    // One thread's counters. Only that thread writes them (relaxed load + store, no atomic RMW), aggregation reads them concurrently.
+    struct alignas(64) Thread_stats {
+        std::atomic<uint64_t> calls[STAT_MAX];
+        std::atomic<uint64_t> timed[STAT_MAX];
+        std::atomic<uint64_t> ticks[STAT_MAX];
+
+        Thread_stats();
+
+        ~Thread_stats();                // Folds counts into the exited-threads totals
+
+        // Count a call, return true if this one should be timed
+        bool count(Stat_id id, uint64_t n = 1) {
+            uint64_t c = calls[id].load(std::memory_order_relaxed);
+            calls[id].store(c + n, std::memory_order_relaxed);
+            return (c & (CHESS_STATS_SAMPLE - 1)) == 0;
+        }
+
+        void add_time(Stat_id id, uint64_t elapsed) {
+            timed[id].store(timed[id].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            ticks[id].store(ticks[id].load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+        }
+    };
+
+    inline Thread_stats& thread_stats() {
+        thread_local Thread_stats stats;
+        return stats;
+    }
+
+    inline uint64_t stat_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    void reset_stats();
+
+    Chess_stats collect_stats();
+
+    // Counts its scope as one call of a counter, and times it if sampled
+    class Stat_timer {
+        Thread_stats& stats;
+        Stat_id id;
+        bool timing;
+        uint64_t start;
+    public:
+        Stat_timer(Stat_id id) : stats(thread_stats()), id(id), timing(stats.count(id)), start(timing ? stat_ticks() : 0) {}
+
+        ~Stat_timer() {
+            if (timing)
+                stats.add_time(id, stat_ticks() - start);
+        }
+    };
+}
+
+#ifdef CHESS_STATS
+    #define CHESS_STAT_CONCAT2(a, b) a##b
+    #define CHESS_STAT_CONCAT(a, b) CHESS_STAT_CONCAT2(a, b)
+    #define CHESS_STAT_TIMER(id) chess_ns::Stat_timer CHESS_STAT_CONCAT(stat_timer_, __LINE__)(id)
+    #define CHESS_STAT_COUNT(id) ((void) chess_ns::thread_stats().count(id))
+#else
+    #define CHESS_STAT_TIMER(id) ((void) 0)
+    #define CHESS_STAT_COUNT(id) ((void) 0)
+#endif
+
+#endif
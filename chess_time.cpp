@@ -0,0 +1,98 @@
+#include "chess_time.h"
+#include <algorithm>
+#include <cstdio>
+
+const double Overshoot_histogram::BOUNDS[Overshoot_histogram::BUCKETS - 1] = {0, 0.1, 0.25, 0.5, 1, 2, 5, 10, 50};
+
+void Overshoot_histogram::clear() {
+    std::fill_n(counts, BUCKETS, 0);
+    samples = 0;
+    max_overshoot = total_overshoot = 0;
+}
+
+void Overshoot_histogram::record(double overshoot_ms) {
+    int i = 0;
+    while (i < BUCKETS - 1 && overshoot_ms > BOUNDS[i])
+        i++;
+    counts[i]++;
+    samples++;
+    if (overshoot_ms > 0)
+        total_overshoot += overshoot_ms;
+    max_overshoot = std::max(max_overshoot, overshoot_ms);
+}
+
+std::string Overshoot_histogram::to_string() const {
+    std::string out;
+    char line[96];
+    for (int i = 0; i < BUCKETS; i++) {
+        if (i == 0)
+            std::snprintf(line, sizeof(line), "  on time    : %llu\n", (unsigned long long) counts[i]);
+        else if (i < BUCKETS - 1)
+            std::snprintf(line, sizeof(line), "  <= %5g ms : %llu\n", BOUNDS[i], (unsigned long long) counts[i]);
+        else
+            std::snprintf(line, sizeof(line), "  >  %5g ms : %llu\n", BOUNDS[i - 1], (unsigned long long) counts[i]);
+        out += line;
+    }
+    std::snprintf(line, sizeof(line), "  %llu samples, %llu late, max %.3f ms, mean late %.3f ms\n", (unsigned long long) samples,
+                  (unsigned long long) late(), max_overshoot, late() ? total_overshoot / late() : 0.0);
+    out += line;
+    return out;
+}
+
+// Moves we plan for when the clock is for the whole game (sudden death / increment)
+static const int DEFAULT_MOVES_TO_GO = 30;
+
+// Soft limit scale by number of iterations the best move stayed the same : spend more while the search changes its mind, cut it
+// short once it has settled
+static const double STABILITY_SCALE[] = {1.3, 1.0, 0.8, 0.65, 0.5};
+
+void Time_manager::start(const Time_control& tc, Color c) {
+    start_time = Clock::now();
+    active = tc.is_set();
+    countdown = check_interval;
+    last_best = Move16();
+    stable_iterations = 0;
+    if (!active)
+        return;
+
+    double cap = tc.deadline ? (double) (tc.deadline - tc.overhead) : 1e18;
+    if (tc.move_time) {
+        soft = hard = (double) (tc.move_time - tc.overhead);
+    }
+    else if (tc.time[c] > 0) {
+        double left = (double) (tc.time[c] - tc.overhead);
+        int moves_to_go = tc.moves_to_go ? std::min(tc.moves_to_go, DEFAULT_MOVES_TO_GO) : DEFAULT_MOVES_TO_GO;
+        soft = left / moves_to_go + 0.75 * tc.increment[c];
+        // Hard limit can eat into the reserve for later moves, but never more than a fraction of it (all of it on the last move
+        // before the time control)
+        hard = (moves_to_go == 1) ? left : std::min(4 * soft, 0.5 * left);
+    }
+    else {
+        soft = hard = cap;                          // Deadline only
+    }
+    hard = std::max(0.0, std::min(hard, cap));
+    soft = std::max(0.0, std::min(soft, hard));
+}
+
+bool Time_manager::iteration_done(Move16 best_move, double iteration_ms, double branching_factor) {
+    if (!active)
+        return false;
+    stable_iterations = (best_move == last_best) ? stable_iterations + 1 : 0;
+    last_best = best_move;
+
+    const int levels = sizeof(STABILITY_SCALE) / sizeof(STABILITY_SCALE[0]);
+    double now = elapsed();
+    if (now >= std::min(hard, soft * STABILITY_SCALE[std::min(stable_iterations, levels - 1)]))
+        return true;
+    // Next iteration most likely can't complete before the hard limit, and an unfinished iteration is thrown away
+    return now + iteration_ms * std::max(branching_factor, 2.0) > hard;
+}
+
+void Time_manager::stop() {
+    if (!active)
+        return;
+    double now = elapsed();
+    soft_overshoot.record(now - soft);
+    hard_overshoot.record(now - hard);
+    active = false;
+}
@@ -0,0 +1,106 @@
+#ifndef CHESS_TIME_H
+#define CHESS_TIME_H
+
+#include "chess_common.h"
+#include "chess_position.h"
+#include <chrono>
+#include <string>
+
+// Clock situation for one move, in milliseconds. Either a fixed time per move (move_time), or remaining clock + increment per side
+// (as given by UCI wtime / btime / winc / binc / movestogo). Nothing set = untimed search.
+struct Time_control {
+    int64_t time[Color::MAX];           // Remaining clock per side
+    int64_t increment[Color::MAX];
+    int moves_to_go;                    // Moves until next time control, 0 = rest of the game
+    int64_t move_time;                  // Fixed time for this move, overrides the clock
+    int64_t deadline;                   // Hard latency cap for this move whatever the clock says (e.g. API SLA), 0 = none
+    int64_t overhead;                   // Kept in reserve for stopping, unwinding & sending the move (I/O, GUI / network lag)
+
+    Time_control() : time{0, 0}, increment{0, 0}, moves_to_go(0), move_time(0), deadline(0), overhead(10) {}
+
+    bool is_set() const {
+        return move_time > 0 || deadline > 0 || time[WHITE] > 0 || time[BLACK] > 0;
+    }
+};
+
+// Log-scale histogram of how far past a limit searches returned (ms). Bucket i counts overshoots up to BOUNDS[i], first bucket
+// is "on time" (returned at or before the limit), last one is everything beyond the last bound.
+struct Overshoot_histogram {
+    static const int BUCKETS = 10;
+    static const double BOUNDS[BUCKETS - 1];
+
+    uint64_t counts[BUCKETS];
+    uint64_t samples;
+    double max_overshoot;
+    double total_overshoot;             // Sum over late samples only
+
+    Overshoot_histogram() {
+        clear();
+    }
+
+    void clear();
+
+    void record(double overshoot_ms);
+
+    uint64_t late() const {
+        return samples - counts[0];
+    }
+
+    std::string to_string() const;
+};
+
+// Allocates soft & hard limits for a move out of the clock, and tells the search when to stop.
+// Soft limit : don't start another iteration past it (scaled by how stable the best move is). Hard limit : abort mid-iteration,
+// search returns the last completed iteration's move. The hard limit never exceeds clock - overhead, nor the deadline.
+// Checking the clock is done every check_interval nodes only (see tick()), never per node.
+class Time_manager {
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point start_time;
+    double soft, hard;                  // ms since start_time
+    bool active;
+    int countdown;
+    Move16 last_best;
+    int stable_iterations;              // Consecutive completed iterations with the same best move
+
+public:
+    int check_interval;                 // Nodes between two clock reads
+    Overshoot_histogram soft_overshoot, hard_overshoot;
+
+    Time_manager() : soft(0), hard(0), active(false), countdown(0), stable_iterations(0), check_interval(1024) {}
+
+    // Start timing the move for side to move c. Clock starts now, so call it as soon as the "go" is received
+    void start(const Time_control& tc, Color c);
+
+    bool is_active() const {
+        return active;
+    }
+
+    double elapsed() const {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start_time).count();
+    }
+
+    double soft_limit() const {
+        return soft;
+    }
+
+    double hard_limit() const {
+        return hard;
+    }
+
+    // Called once per node. True once the hard limit is hit (only actually reads the clock every check_interval calls)
+    bool tick() {
+        if (!active || --countdown > 0)
+            return false;
+        countdown = check_interval;
+        return elapsed() >= hard;
+    }
+
+    // Called after each completed iteration with its best move and duration. True if no new iteration should be started
+    bool iteration_done(Move16 best_move, double iteration_ms, double branching_factor);
+
+    // Called when search returns, to record overshoot of both limits
+    void stop();
+};
+
+#endif
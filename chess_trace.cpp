@@ -0,0 +1,139 @@
+#include "chess_trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace chess_ns {
+    std::atomic<bool> trace_on(false);
+
+    // All rings ever registered, plus when the current trace started
+    struct Trace_registry {
+        std::mutex lock;
+        std::vector<Trace_ring*> rings;
+        std::atomic<uint64_t> origin;
+
+        Trace_registry() : origin(0) {}
+    };
+
+    static Trace_registry& registry() {
+        static Trace_registry* instance = new Trace_registry();     // Never destroyed, like the rings, threads may exit late
+        return *instance;
+    }
+
+    bool trace_compiled() {
+#ifdef CHESS_TRACE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    Trace_ring::Trace_ring(int tid) : head(0), tid(tid), thread_name{} {
+        std::snprintf(thread_name, sizeof(thread_name), "thread %d", tid);
+    }
+
+    Trace_ring& trace_ring() {
+        thread_local Trace_ring* ring = nullptr;
+        if (!ring) {
+            Trace_registry& r = registry();
+            std::lock_guard<std::mutex> guard(r.lock);
+            ring = new Trace_ring((int) r.rings.size() + 1);
+            r.rings.push_back(ring);
+        }
+        return *ring;
+    }
+
+    uint64_t trace_clock() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void trace_start() {
+        registry().origin.store(trace_clock(), std::memory_order_relaxed);
+        trace_on.store(true, std::memory_order_relaxed);
+    }
+
+    void trace_stop() {
+        trace_on.store(false, std::memory_order_relaxed);
+    }
+
+    void trace_thread_name(const std::string& name) {
+        Trace_ring& ring = trace_ring();
+        std::lock_guard<std::mutex> guard(registry().lock);
+        std::snprintf(ring.thread_name, sizeof(ring.thread_name), "%s", name.c_str());
+    }
+
+    static void append_string(std::string& out, const char* text) {
+        out += '"';
+        for (const char* p = text; *p; p++) {
+            if (*p == '"' || *p == '\\') out += '\\';
+            if ((unsigned char) *p >= 0x20) out += *p;
+        }
+        out += '"';
+    }
+
+    std::string trace_json() {
+        Trace_registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        uint64_t origin = r.origin.load(std::memory_order_relaxed);
+        std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        char item[160];
+        for (Trace_ring* ring : r.rings) {
+            out += first ? "\n" : ",\n";
+            first = false;
+            std::snprintf(item, sizeof(item), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", ring->tid);
+            out += item;
+            append_string(out, ring->thread_name);
+            out += "}}";
+
+            // Copy out the events still in the ring, then drop those the owner may have started overwriting while we were copying
+            const uint64_t BUSY = 1ULL << 63;
+            uint64_t end = ring->head.load(std::memory_order_acquire) & ~BUSY;
+            uint64_t begin = (end > CHESS_TRACE_EVENTS) ? end - CHESS_TRACE_EVENTS : 0;
+            struct Copy {
+                const char* name;
+                const char* arg_name;
+                int64_t arg;
+                uint64_t start, duration;
+            };
+            std::vector<Copy> copies;
+            copies.reserve(end - begin);
+            for (uint64_t i = begin; i < end; i++) {
+                const Trace_event& e = ring->events[i & (CHESS_TRACE_EVENTS - 1)];
+                copies.push_back({e.name.load(std::memory_order_relaxed), e.arg_name.load(std::memory_order_relaxed),
+                                  e.arg.load(std::memory_order_relaxed), e.start.load(std::memory_order_relaxed),
+                                  e.duration.load(std::memory_order_relaxed)});
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t now = ring->head.load(std::memory_order_relaxed);
+            uint64_t started = (now & ~BUSY) + ((now & BUSY) ? 1 : 0);          // Events the owner has begun writing
+            uint64_t safe = (started > CHESS_TRACE_EVENTS) ? started - CHESS_TRACE_EVENTS : 0;
+
+            for (uint64_t i = std::max(begin, safe); i < end; i++) {
+                const Copy& c = copies[i - begin];
+                if (c.start < origin)
+                    continue;                                                   // From an earlier trace
+                std::snprintf(item, sizeof(item), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", c.name,
+                              ring->tid, (c.start - origin) / 1000.0, c.duration / 1000.0);
+                out += item;
+                if (c.arg_name) {
+                    std::snprintf(item, sizeof(item), ",\"args\":{\"%s\":%lld}", c.arg_name, (long long) c.arg);
+                    out += item;
+                }
+                out += '}';
+            }
+        }
+        out += "\n]}\n";
+        return out;
+    }
+
+    bool trace_dump(const std::string& path) {
+        std::ofstream out(path, std::ios::trunc);
+        out << trace_json();
+        return (bool) out;
+    }
+}
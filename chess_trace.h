@@ -0,0 +1,116 @@
+#ifndef CHESS_TRACE_H
+#define CHESS_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Span tracing : where the time goes in a search or an ingestion run, per thread and on a timeline, rather than the totals that
+// chess_stats.h gives. Compiled in only with -DCHESS_TRACE (the CHESS_TRACE_* macros expand to nothing otherwise), and even then
+// nothing is recorded until trace_start() : a span is then one relaxed load of the on/off flag.
+//
+// Each thread records its finished spans into its own ring (single writer, no locking, oldest spans overwritten once it's full),
+// trace_dump() collects all rings into a Chrome trace JSON file, for chrome://tracing or ui.perfetto.dev.
+// Spans are meant for coarse units of work (an iteration, a game, a block, a lock wait), not per-node operations.
+// Span names & argument names must be string literals (only the pointer is recorded).
+
+#ifndef CHESS_TRACE_EVENTS
+#define CHESS_TRACE_EVENTS (1 << 14)    // Per thread ring size, power of 2
+#endif
+
+namespace chess_ns {
+    // One ring slot. Fields are relaxed atomics so a dump running concurrently with the owner thread reads well-defined values,
+    // slots the owner may have overwritten meanwhile are detected & dropped by the dump
+    struct Trace_event {
+        std::atomic<const char*> name;
+        std::atomic<const char*> arg_name;  // nullptr if no argument
+        std::atomic<int64_t> arg;
+        std::atomic<uint64_t> start;        // trace_clock()
+        std::atomic<uint64_t> duration;
+    };
+
+    struct Trace_ring {
+        alignas(64) std::atomic<uint64_t> head;     // Events recorded so far, slot = head % CHESS_TRACE_EVENTS
+        int tid;                                    // Registration order, 1 for the first thread that traced
+        char thread_name[32];
+        Trace_event events[CHESS_TRACE_EVENTS];
+
+        Trace_ring(int tid);
+
+        void record(const char* name, uint64_t start, uint64_t end, const char* arg_name, int64_t arg) {
+            uint64_t h = head.load(std::memory_order_relaxed);
+            Trace_event& e = events[h & (CHESS_TRACE_EVENTS - 1)];
+            // Mark the slot as being rewritten first, so a dump that read the old head doesn't take a half-written event for it
+            head.store(h | (1ULL << 63), std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            e.name.store(name, std::memory_order_relaxed);
+            e.arg_name.store(arg_name, std::memory_order_relaxed);
+            e.arg.store(arg, std::memory_order_relaxed);
+            e.start.store(start, std::memory_order_relaxed);
+            e.duration.store(end - start, std::memory_order_relaxed);
+            head.store(h + 1, std::memory_order_release);
+        }
+    };
+
+    extern std::atomic<bool> trace_on;
+
+    // Whether the library was built with CHESS_TRACE (if not, a trace only has what the calling program records itself)
+    bool trace_compiled();
+
+    // Calling thread's ring, registered on first use. Rings outlive their thread, so spans of joined workers still get dumped
+    Trace_ring& trace_ring();
+
+    // Steady clock, ns
+    uint64_t trace_clock();
+
+    // Starts recording. Spans from before (an earlier start / stop) are left out of dumps, rings aren't touched
+    void trace_start();
+
+    void trace_stop();
+
+    inline bool tracing() {
+        return trace_on.load(std::memory_order_relaxed);
+    }
+
+    // Names the calling thread in the dump ("worker 3"), copied
+    void trace_thread_name(const std::string& name);
+
+    // Chrome trace JSON ("traceEvents" array, complete events with microsecond timestamps), whatever the rings still hold
+    std::string trace_json();
+
+    bool trace_dump(const std::string& path);
+
+    // Records its scope as one span, if tracing was on when it started
+    class Trace_span {
+        const char* name;
+        const char* arg_name;
+        int64_t arg;
+        uint64_t start;
+        bool active;
+    public:
+        Trace_span(const char* name, const char* arg_name = nullptr, int64_t arg = 0) : name(name), arg_name(arg_name), arg(arg),
+            start(0), active(tracing()) {
+            if (active)
+                start = trace_clock();
+        }
+
+        ~Trace_span() {
+            if (active)
+                trace_ring().record(name, start, trace_clock(), arg_name, arg);
+        }
+    };
+}
+
+#ifdef CHESS_TRACE
+    #define CHESS_TRACE_CONCAT2(a, b) a##b
+    #define CHESS_TRACE_CONCAT(a, b) CHESS_TRACE_CONCAT2(a, b)
+    #define CHESS_TRACE_SPAN(name) chess_ns::Trace_span CHESS_TRACE_CONCAT(trace_span_, __LINE__)(name)
+    #define CHESS_TRACE_SPAN_ARG(name, arg_name, arg) chess_ns::Trace_span CHESS_TRACE_CONCAT(trace_span_, __LINE__)(name, arg_name, arg)
+    #define CHESS_TRACE_THREAD(name) (chess_ns::tracing() ? chess_ns::trace_thread_name(name) : (void) 0)
+#else
+    #define CHESS_TRACE_SPAN(name) ((void) 0)
+    #define CHESS_TRACE_SPAN_ARG(name, arg_name, arg) ((void) 0)
+    #define CHESS_TRACE_THREAD(name) ((void) 0)
+#endif
+
+#endif
@@ -0,0 +1,121 @@
+#include "chess_tt.h"
+#include "chess_eval.h"
+#include "chess_trace.h"
+#include <algorithm>
+
+const int Transposition_table::BUCKET_SIZE = 4;
+
+static_assert(sizeof(TT_entry) == 16);
+
+// Mapped files from a build that stores other entries, or other keys, are stale
+static const uint32_t TT_FILE_KIND = 0x42415454;        // "TTAB"
+static const uint64_t TT_FILE_REVISION = 2;             // Bump when what entries mean changes (score scale, move encoding ...)
+
+static uint64_t tt_file_salt() {
+    Position start;
+    start.set_start();
+    return chess_ns::checksum64(&start.key, sizeof(start.key), (TT_FILE_REVISION << 32) | sizeof(TT_entry)) ^ eval_signature();
+}
+
+static size_t tt_buckets(size_t mb) {
+    return std::bit_floor(std::max<size_t>(1, (mb << 20) / (sizeof(TT_entry) * Transposition_table::BUCKET_SIZE)));
+}
+
+Transposition_table::Transposition_table(size_t mb) : table(nullptr), entry_count(0), bucket_mask(0), generation(0) {
+    resize(mb);
+}
+
+Transposition_table::~Transposition_table() {
+    close_file();
+}
+
+void Transposition_table::resize(size_t mb) {
+    CHESS_TRACE_SPAN_ARG("tt_resize", "mb", (int64_t) mb);
+    close_file();
+    size_t buckets = tt_buckets(mb);
+    memory.assign(buckets * BUCKET_SIZE, TT_entry());
+    table = memory.data();
+    entry_count = memory.size();
+    bucket_mask = buckets - 1;
+    clear();
+}
+
+Mapped_status Transposition_table::map_file(const std::string& path, size_t mb) {
+    CHESS_TRACE_SPAN_ARG("tt_map", "mb", (int64_t) mb);
+    close_file();
+    size_t buckets = tt_buckets(mb);
+    Mapped_status status = file.open(path, TT_FILE_KIND, tt_file_salt(), buckets * BUCKET_SIZE * sizeof(TT_entry));
+    if (!file.is_open()) {
+        resize(mb);
+        return status;
+    }
+    std::vector<TT_entry>().swap(memory);
+    table = static_cast<TT_entry*>(file.payload());
+    entry_count = buckets * BUCKET_SIZE;
+    bucket_mask = buckets - 1;
+    if (status == MAPPED_WARM)
+        generation = (uint8_t) file.user();
+    else
+        clear();
+    return status;
+}
+
+// Saves & unmaps the file, leaving table dangling : the caller points it at new storage, or is the destructor
+void Transposition_table::close_file() {
+    if (file.is_open())
+        file.close(generation);
+}
+
+// Back to an empty heap table of the same size
+void Transposition_table::unmap_file() {
+    if (!file.is_open())
+        return;
+    close_file();
+    memory.assign(entry_count, TT_entry());
+    table = memory.data();
+    generation = 0;
+}
+
+void Transposition_table::clear() {
+    std::fill(table, table + entry_count, TT_entry());
+    generation = 0;
+}
+
+const TT_entry* Transposition_table::probe(uint64_t key) const {
+    const TT_entry* bucket = &table[(key & bucket_mask) * BUCKET_SIZE];
+    for (int i = 0; i < BUCKET_SIZE; i++)
+        if (bucket[i].key == key && bucket[i].bound != BOUND_NONE)
+            return &bucket[i];
+    return nullptr;
+}
+
+void Transposition_table::store(uint64_t key, Move16 move, int score, int depth, Bound bound) {
+    TT_entry* bucket = &table[(key & bucket_mask) * BUCKET_SIZE];
+    TT_entry* replace = bucket;
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        if (bucket[i].key == key || bucket[i].bound == BOUND_NONE) {
+            replace = &bucket[i];
+            break;
+        }
+        // Prefer replacing entries from older searches, then shallower ones
+        auto worth = [&](const TT_entry& e) { return e.depth - 8 * (uint8_t) (generation - e.generation); };
+        if (worth(bucket[i]) < worth(*replace))
+            replace = &bucket[i];
+    }
+    // Keep the old move if we have none for this position
+    if (move.is_null() && replace->key == key)
+        move = replace->move;
+    replace->key = key;
+    replace->move = move;
+    replace->score = (int16_t) score;
+    replace->depth = (int8_t) std::clamp(depth, -128, 127);
+    replace->bound = (uint8_t) bound;
+    replace->generation = generation;
+}
+
+int Transposition_table::hashfull() const {
+    int used = 0, sample = std::min<int>(1000, (int) entry_count);
+    for (int i = 0; i < sample; i++)
+        used += table[i].bound != BOUND_NONE && table[i].generation == generation;
+    return used * 1000 / std::max(1, sample);
+}
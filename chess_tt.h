@@ -0,0 +1,76 @@
+#ifndef CHESS_TT_H
+#define CHESS_TT_H
+
+#include "chess_common.h"
+#include "chess_mapped.h"
+#include "chess_position.h"
+#include <cstdint>
+
+typedef enum bound {
+    BOUND_NONE,
+    BOUND_UPPER,            // Failed low, score is at most this
+    BOUND_LOWER,            // Failed high, score is at least this
+    BOUND_EXACT
+} Bound;
+
+struct TT_entry {
+    uint64_t key;
+    Move16 move;
+    int16_t score;
+    int8_t depth;
+    uint8_t bound;
+    uint8_t generation;
+    uint8_t padding;
+};
+
+// Transposition table : buckets of 4 entries (one cache line), always-replace within the bucket picking the shallowest / oldest entry.
+// Scores are stored relative to the node (mate distances are converted by the caller, see Search).
+// Entries live on the heap, or in a file (map_file()) so the table survives restarts.
+class Transposition_table {
+    TT_entry* table;                    // memory's or file's
+    uint64_t entry_count;
+    uint64_t bucket_mask;
+    uint8_t generation;
+    std::vector<TT_entry> memory;       // Storage when not mapped
+    Mapped_file file;
+
+    void close_file();
+
+public:
+    const static int BUCKET_SIZE;
+
+    Transposition_table(size_t mb = 16);
+
+    ~Transposition_table();
+
+    // Size in MB, rounded down to a power of 2 buckets. Clears the table, and moves it back to the heap if it was mapped
+    void resize(size_t mb);
+
+    // Backs the table with path (see chess_mapped.h), saved there by unmap_file() or the destructor. Entries from the last run are
+    // kept if the file is warm, else the table starts cleared ; on MAPPED_BUSY / MAPPED_FAILED it stays on the heap
+    Mapped_status map_file(const std::string& path, size_t mb);
+
+    // Saves the file & goes back to an empty heap table of the same size
+    void unmap_file();
+
+    bool is_mapped() const {
+        return file.is_open();
+    }
+
+    void clear();
+
+    // Called once per search, so entries from older searches get replaced first
+    void new_search() {
+        generation++;
+    }
+
+    // Entry with this key, or nullptr
+    const TT_entry* probe(uint64_t key) const;
+
+    void store(uint64_t key, Move16 move, int score, int depth, Bound bound);
+
+    // Permille of sampled entries used by the current search (UCI hashfull)
+    int hashfull() const;
+};
+
+#endif
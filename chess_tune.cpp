@@ -0,0 +1,232 @@
+#include "chess_tune.h"
+#include "chess_datagen.h"
+#include "chess_record.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+Tuning_set::Tuning_set() : offsets(1, 0) {}
+
+void Tuning_set::add(const Position& pos, float result) {
+    Eval_feature features[EVAL_PARAM_COUNT];
+    int n = eval_features(pos, features);
+#ifndef NDEBUG
+    // Features must add up to evaluate() under the current terms, or the tuner fits something else than what the engine plays
+    static const std::vector<int> current = [] {
+        std::vector<int> values(EVAL_PARAM_COUNT);
+        eval_params(values.data());
+        return values;
+    }();
+    int sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += current[features[i].param] * features[i].coef;
+    assert(sum == ((pos.turn == WHITE) ? 1 : -1) * evaluate(pos));
+#endif
+    for (int i = 0; i < n; i++) {
+        params.push_back(features[i].param);
+        coefs.push_back(features[i].coef);
+    }
+    offsets.push_back(params.size());
+    results.push_back(result);
+}
+
+uint64_t Tuning_set::load_epd(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    uint64_t added = 0;
+    Position pos;
+    while (std::getline(in, line)) {
+        // FEN is the first 4 fields, the result is looked for in what follows
+        std::istringstream fields(line);
+        std::string fen, field, tail;
+        for (int i = 0; i < 4 && fields >> field; i++)
+            fen += (i ? " " : "") + field;
+        std::getline(fields, tail);
+        float result;
+        size_t bracket = tail.find('[');
+        if (tail.find("1/2-1/2") != std::string::npos)
+            result = 0.5f;
+        else if (tail.find("1-0") != std::string::npos)
+            result = 1.0f;
+        else if (tail.find("0-1") != std::string::npos)
+            result = 0.0f;
+        else if (bracket != std::string::npos)
+            result = std::strtof(tail.c_str() + bracket + 1, nullptr);
+        else
+            continue;
+        if (!pos.set_fen(fen))
+            continue;
+        add(pos, result);
+        added++;
+    }
+    return added;
+}
+
+uint64_t Tuning_set::load_record(const std::string& path, int skip_plies) {
+    Record_reader reader;
+    if (!reader.open(path))
+        return 0;
+    Game_record game;
+    uint64_t added = 0;
+    Move16 list[MAX_MOVES];
+    while (reader.next_game(game)) {
+        if (game.result == RESULT_UNKNOWN)
+            continue;
+        float result = (game.result == WHITE_WINS) ? 1.0f : (game.result == BLACK_WINS) ? 0.0f : 0.5f;
+        Position pos;
+        if (!game.start_position(pos))
+            continue;
+        for (size_t ply = 0; ply < game.moves.size(); ply++) {
+            if ((int) ply >= skip_plies && !pos.in_check()) {
+                int n = pos.generate_moves(list);
+                bool quiet = true;
+                for (int i = 0; i < n && quiet; i++) {
+                    Move16 m = list[i];
+                    bool tactical = pos.piece_on(m.dst()) != PIECE_MAX || m.flag() == Move16::EN_PASSANT || m.flag() == Move16::PROMOTION;
+                    quiet = !tactical || see(pos, m) <= 0;
+                }
+                if (quiet) {
+                    add(pos, result);
+                    added++;
+                }
+            }
+            pos.play(game.moves[ply]);
+        }
+    }
+    return added;
+}
+
+uint64_t Tuning_set::load_packed(const std::string& path) {
+    std::vector<Packed_position> records;
+    read_shard(path, records);
+    uint64_t added = 0;
+    Position pos;
+    for (const Packed_position& p : records) {
+        if (!unpack_position(p, pos))
+            continue;
+        int white = (pos.turn == WHITE) ? p.result : -p.result;
+        add(pos, 0.5f * (white + 1));
+        added++;
+    }
+    return added;
+}
+
+Tune_options::Tune_options() : threads(std::max(1u, std::thread::hardware_concurrency())), max_epochs(2000), rate(1.0),
+    tolerance(1e-7), patience(20) {}
+
+namespace chess_ns {
+    // sigmoid(scale * eval) with the Texel convention : scale 1 maps +400 cp to 10:1 odds
+    inline double tuning_factor(double scale) {
+        return scale * std::log(10.0) / 400.0;
+    }
+
+    // Squared errors of positions [first, last), gradient (unscaled : sum of err * s * (1 - s) * coef) added to gradient
+    static double loss_range(const Tuning_set& set, const float* weights, double factor, size_t first, size_t last, double* gradient) {
+        const uint64_t* offsets = set.offsets.data();
+        const uint16_t* params = set.params.data();
+        const int8_t* coefs = set.coefs.data();
+        double loss = 0;
+        for (size_t i = first; i < last; i++) {
+            float eval = 0;
+            for (uint64_t j = offsets[i]; j < offsets[i + 1]; j++)
+                eval += weights[params[j]] * coefs[j];
+            double s = 1.0 / (1.0 + std::exp(-factor * eval));
+            double error = s - set.results[i];
+            loss += error * error;
+            if (gradient) {
+                double g = error * s * (1.0 - s);
+                for (uint64_t j = offsets[i]; j < offsets[i + 1]; j++)
+                    gradient[params[j]] += g * coefs[j];
+            }
+        }
+        return loss;
+    }
+}
+
+double tuning_loss(const Tuning_set& set, const double* weights, double scale, double* gradient, int threads) {
+    size_t n = set.size();
+    if (n == 0)
+        return 0;
+    threads = (int) std::max<size_t>(1, std::min<size_t>(threads, n / 4096 + 1));
+    std::vector<float> w(weights, weights + EVAL_PARAM_COUNT);
+    double factor = chess_ns::tuning_factor(scale);
+
+    // Each thread has a contiguous range & its own gradient, summed at the end
+    std::vector<double> losses(threads, 0.0);
+    std::vector<std::vector<double>> gradients(gradient ? threads : 0, std::vector<double>(EVAL_PARAM_COUNT, 0.0));
+    auto run = [&](int t) {
+        losses[t] = chess_ns::loss_range(set, w.data(), factor, n * t / threads, n * (t + 1) / threads,
+                                         gradient ? gradients[t].data() : nullptr);
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++)
+        pool.emplace_back(run, t);
+    run(0);
+    for (auto& thread : pool)
+        thread.join();
+
+    double loss = 0;
+    for (int t = 0; t < threads; t++)
+        loss += losses[t];
+    if (gradient) {
+        for (int p = 0; p < EVAL_PARAM_COUNT; p++) {
+            double sum = 0;
+            for (int t = 0; t < threads; t++)
+                sum += gradients[t][p];
+            gradient[p] = 2.0 * factor * sum / n;
+        }
+    }
+    return loss / n;
+}
+
+double fit_tuning_scale(const Tuning_set& set, const double* weights, int threads) {
+    const double RATIO = (std::sqrt(5.0) - 1) / 2;
+    double low = 0.01, high = 5.0;
+    double a = high - RATIO * (high - low), b = low + RATIO * (high - low);
+    double loss_a = tuning_loss(set, weights, a, nullptr, threads), loss_b = tuning_loss(set, weights, b, nullptr, threads);
+    for (int i = 0; i < 40; i++) {
+        if (loss_a < loss_b) {
+            high = b;
+            b = a;
+            loss_b = loss_a;
+            a = high - RATIO * (high - low);
+            loss_a = tuning_loss(set, weights, a, nullptr, threads);
+        }
+        else {
+            low = a;
+            a = b;
+            loss_a = loss_b;
+            b = low + RATIO * (high - low);
+            loss_b = tuning_loss(set, weights, b, nullptr, threads);
+        }
+    }
+    return (low + high) / 2;
+}
+
+double tune_eval(const Tuning_set& set, std::vector<double>& weights, double scale, const Tune_options& options) {
+    const double BETA1 = 0.9, BETA2 = 0.999, EPSILON = 1e-8;
+    std::vector<double> gradient(EVAL_PARAM_COUNT), m(EVAL_PARAM_COUNT, 0.0), v(EVAL_PARAM_COUNT, 0.0);
+    double last = 0, beta1_t = 1, beta2_t = 1;
+    int stalled = 0;
+    for (int epoch = 0; epoch < options.max_epochs; epoch++) {
+        double loss = tuning_loss(set, weights.data(), scale, gradient.data(), options.threads);
+        if (options.on_epoch)
+            options.on_epoch(epoch, loss);
+        stalled = (epoch > 0 && last - loss < options.tolerance * last) ? stalled + 1 : 0;
+        if (stalled >= options.patience)
+            return loss;
+        last = loss;
+
+        beta1_t *= BETA1;
+        beta2_t *= BETA2;
+        for (int p = 0; p < EVAL_PARAM_COUNT; p++) {
+            m[p] = BETA1 * m[p] + (1 - BETA1) * gradient[p];
+            v[p] = BETA2 * v[p] + (1 - BETA2) * gradient[p] * gradient[p];
+            weights[p] -= options.rate * (m[p] / (1 - beta1_t)) / (std::sqrt(v[p] / (1 - beta2_t)) + EPSILON);
+        }
+    }
+    return tuning_loss(set, weights.data(), scale, nullptr, options.threads);
+}
@@ -0,0 +1,65 @@
+#ifndef CHESS_TUNE_H
+#define CHESS_TUNE_H
+
+#include "chess_common.h"
+#include "chess_eval.h"
+#include "chess_position.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Texel tuning : fits the evaluation terms (chess_eval.h, eval_features()) to game results. A position's predicted score is
+// sigmoid(scale * eval), eval from white's point of view in centipawns, and the loss is the mean squared error against the result
+// of the game it comes from (1, 0.5, 0 for white). The eval is linear in its terms, so each position is stored once as its
+// nonzero features and every loss / gradient pass after that is a sparse dot product, no move generation or Position involved.
+
+// Labeled positions, as parallel arrays (features of all positions back to back, position i owning [offsets[i], offsets[i + 1]))
+struct Tuning_set {
+    std::vector<uint64_t> offsets;
+    std::vector<uint16_t> params;
+    std::vector<int8_t> coefs;
+    std::vector<float> results;         // White's : 1 win, 0.5 draw, 0 loss
+
+    Tuning_set();
+
+    size_t size() const {
+        return results.size();
+    }
+
+    void add(const Position& pos, float result);
+
+    // Text file, one position per line : FEN then the result anywhere after it, as "1-0" / "0-1" / "1/2-1/2" (quoted or not) or as
+    // a bracketed white score ("[0.5]"). Lines without a result are skipped. Returns positions added
+    uint64_t load_epd(const std::string& path);
+
+    // Positions of decided games in a game record file (chess_record.h), labeled with the game's result. The first skip_plies of
+    // every game (opening book) are left out, and so are positions that aren't quiet : side to move in check, or with a capture /
+    // promotion that SEE says wins material (the static eval is no good there). Returns positions added
+    uint64_t load_record(const std::string& path, int skip_plies = 8);
+
+    // Self-play shard (chess_datagen.h), labeled with the game result of each record. Returns positions added
+    uint64_t load_packed(const std::string& path);
+};
+
+struct Tune_options {
+    int threads;
+    int max_epochs;
+    double rate;                        // Adam step size, in centipawns
+    double tolerance;                   // Stop once an epoch improves the loss by less than this (relative), for patience epochs
+    int patience;
+    std::function<void(int epoch, double loss)> on_epoch;
+
+    Tune_options();
+};
+
+// Mean squared error of the set under weights (EVAL_PARAM_COUNT of them), on all threads. gradient (EVAL_PARAM_COUNT, may be
+// nullptr) gets d loss / d weight
+double tuning_loss(const Tuning_set& set, const double* weights, double scale, double* gradient, int threads);
+
+// Sigmoid scale that best fits the current weights (a golden section search), so tuning changes the terms, not the scale
+double fit_tuning_scale(const Tuning_set& set, const double* weights, int threads);
+
+// Full-batch Adam from weights (updated in place) until the loss stops improving. Returns the final loss
+double tune_eval(const Tuning_set& set, std::vector<double>& weights, double scale, const Tune_options& options = Tune_options());
+
+#endif
@@ -2,6 +2,8 @@
 #include "chess_piece.h"
 #include "chess_board.h"
 #include "chess_common.h"
+#include "chess_stats.h"
+#include "chess_arena.h"
 
 // To use custom hash and comparison functions internally for unordered_set usage, overloading definitions of 
 // template <> struct hash<Piece_type*> and template <> struct equal_to<Piece_type*> 
@@ -36,6 +38,10 @@ namespace chess_ns {
         bool operator()(const Piece_type* lhs, char rhs_shorthand) const {
             return lhs && lhs->shorthand == rhs_shorthand;       // Allow comparing Piece_type* with char
         }
+
+        bool operator()(char lhs_shorthand, const Piece_type* rhs) const {
+            return rhs && rhs->shorthand == lhs_shorthand;       // Same, but with operands swapped (libstdc++ calls it this way)
+        }
     };
 }
 
@@ -72,6 +78,7 @@ public:
 
 // DS to have push_back() and [] operator. Internally stores into and accesses a hashmap. However, push_back(val) is to store {key, val} in hashmap,
 // where key is the smallest available key (which is basically called piece_id here) So, appropriate name is Piece_map?
+template<int N>
 class PieceID_map {
     // Have to assign unique ids, not practical to store all available ids, but assume it is practical to store all assigned ids somehow
     // Say initially 1 to n is assigned, say we track in some map.
@@ -80,23 +87,30 @@ class PieceID_map {
     // Well we can store the "freed" ids in a heap, and assign from heap by default if empty. If heap is empty, we assign max assigned id so far (which is tracked) + 1.
     // It is easy to see that the map size will never exceed reasonable amount as it only stores currently assigned ids. 
     // Also, heap size < the largest id ever present in map. So, no issue!
-    std::unordered_map<int, Piece> pmap;
+    // Map nodes live in the map's own arena, a game's worth of pieces fits in one block. clear() (new game) releases them all at once,
+    // so resetting a game takes nothing from the heap once the first one is set up. Captured pieces' nodes get reused by promotions
+    typedef std::unordered_map<int, Piece<N>, std::hash<int>, std::equal_to<int>, Arena_allocator<std::pair<const int, Piece<N>>>> Piece_table;
+    Arena nodes;
+    Piece_table pmap;
     std::priority_queue<int, std::vector<int>, std::greater<int>> min_avl_id;
 
     int max_assigned_so_far;            // Not current max id, but max id ever assigned, as current max might be lower, as max ids can also be moved to heap
 
 public:
-    PieceID_map() {
+    PieceID_map() : nodes(4 << 10), pmap(Arena_allocator<std::pair<const int, Piece<N>>>(&nodes)) {
         clear();
     }
 
-    const Piece_ptr& operator[](int uid) {
+    PieceID_map(const PieceID_map&) = delete;
+    PieceID_map& operator=(const PieceID_map&) = delete;
+
+    const Piece_ptr<N>& operator[](int uid) {
         if (pmap.find(uid) == pmap.end())
             return nullptr;
         return &(pmap[uid]);
     }
 
-    int operator[](Piece_ptr p) {
+    int operator[](Piece_ptr<N> p) {
         if (p == nullptr) return -1;
         return p->id();
     }
@@ -110,13 +124,15 @@ public:
     }
 
     void clear() {
-        pmap.clear();
+        Piece_table(pmap.get_allocator()).swap(pmap);      // Destroys the pieces, and lets go of the buckets too, before the arena rewinds
+        nodes.reset();
         min_avl_id = std::priority_queue<int, std::vector<int>, std::greater<int>>();
         max_assigned_so_far = -1;
     }
 
     // Accept a Piece rvalue reference to store into piece map after assigning min avl id to it, place Piece_ptr on board (if exists)
-    void push_back(Piece&& in_p) {
+    void push_back(Piece<N>&& in_p) {
+        CHESS_STAT_TIMER(STAT_PIECE_PUSH_BACK);
         int id;
         if (min_avl_id.empty()) {
             id = max_assigned_so_far;
@@ -128,20 +144,24 @@ public:
         }
 
         in_p.id() = id;
-        Piece_ptr ptr;
-        Piece_ptr& ptr_ref = ptr;
+        Piece_ptr<N> ptr;
+        Piece_ptr<N>* cell = &ptr;
         if (in_p.board)
-            ptr_ref = in_p.board->operator[](in_p.rank())[in_p.file()];     // Reference now points to board[i][j] (static null, if invalid i,j)
+            cell = &(in_p.board->operator[](in_p.rank())[in_p.file()]);    // Now points to board[i][j] (static null, if invalid i,j)
 
         pmap[id] = std::move(in_p);
-        ptr_ref = &pmap[id];                // Reassign reference variable (hence modifying the original) to now contain value Piece_ptr(Piece*)
+        *cell = &pmap[id];                  // Store Piece_ptr(Piece*) into the cell (a reference can't be reseated, so pointer to it)
     }
 
     // Remove the Piece from pmap, and also set the pointer at *piece_ptr_ptr as null
-    void remove(Piece_ptr* piece_ptr_ptr) {
+    void remove(Piece_ptr<N>* piece_ptr_ptr) {
+        CHESS_STAT_TIMER(STAT_PIECE_REMOVE);
         if (piece_ptr_ptr == nullptr || *piece_ptr_ptr == nullptr)
             return;
-        int id = (*piece_ptr_ptr)->id();
+        Piece<N>& piece = **piece_ptr_ptr;
+        int id = piece.id();
+        if (piece.board)
+            piece.board->vacate(piece.rank(), piece.file());
         *piece_ptr_ptr = nullptr;
         pmap.erase(id);
         min_avl_id.push(id);
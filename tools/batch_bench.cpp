@@ -0,0 +1,108 @@
+// Throughput of Game_table::validate_batch() against validating the same moves one game at a time through Chess::play_move().
+// Every game follows its own pseudo-random line (fixed seed), one move per game per tick, with a share of bad / illegal moves mixed in.
+// Usage : batch_bench [--games N] [--plies N] [--bad-every N]
+#include "../chess.h"
+#include "../chess_batch.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int game_count = 4096, plies = 60, bad_every = 50;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--games")) game_count = std::max(1, std::atoi(argv[i + 1]));
+        else if (!std::strcmp(argv[i], "--plies")) plies = std::max(1, std::atoi(argv[i + 1]));
+        else if (!std::strcmp(argv[i], "--bad-every")) bad_every = std::max(0, std::atoi(argv[i + 1]));
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--games N] [--plies N] [--bad-every N]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Move streams : moves[tick][game], SAN. Games that end early just get no more moves
+    std::mt19937 rng(12345);
+    std::vector<std::vector<std::string>> lines(game_count);
+    for (auto& line : lines) {
+        Position pos;
+        pos.set_start();
+        for (int ply = 0; ply < plies; ply++) {
+            Move16 list[MAX_MOVES];
+            int n = pos.generate_moves(list);
+            if (!n)
+                break;
+            Move16 move = list[rng() % n];
+            std::string san = pos.san(move);
+            if (bad_every && rng() % bad_every == 0)
+                line.push_back((rng() % 2) ? "Qz9" : "Ke8");    // Bad notation, or (almost always) illegal, game stays put
+            line.push_back(san);
+            pos.play(move);
+        }
+    }
+    size_t total = 0;
+    for (auto& line : lines)
+        total += line.size();
+    std::printf("%d games, %zu moves\n", game_count, total);
+
+    // One at a time : a Chess per game, moves in tick order, game after game
+    std::vector<Chess> chess(game_count);
+    auto start = Clock::now();
+    size_t played_single = 0;
+    for (size_t tick = 0;; tick++) {
+        bool any = false;
+        for (int g = 0; g < game_count; g++) {
+            if (tick >= lines[g].size())
+                continue;
+            any = true;
+            played_single += chess[g].play_move(lines[g][tick]);
+        }
+        if (!any)
+            break;
+    }
+    double single = seconds_since(start);
+
+    // Batched : same ticks, one validate_batch() call per tick
+    Game_table table;
+    for (int g = 0; g < game_count; g++)
+        table.add();
+    std::vector<Game_ref> refs;
+    std::vector<Move_text> texts;
+    std::vector<Batch_result> results;
+    start = Clock::now();
+    size_t played_batch = 0;
+    for (size_t tick = 0;; tick++) {
+        refs.clear();
+        texts.clear();
+        for (int g = 0; g < game_count; g++) {
+            if (tick < lines[g].size()) {
+                refs.push_back((Game_ref) g);
+                texts.push_back(lines[g][tick]);
+            }
+        }
+        if (refs.empty())
+            break;
+        results.resize(refs.size());
+        table.validate_batch(refs, texts, results);
+        for (const Batch_result& r : results)
+            played_batch += r.status == MOVE_PLAYED;
+    }
+    double batch = seconds_since(start);
+
+    // Both must agree on every game
+    int mismatches = 0;
+    for (int g = 0; g < game_count; g++)
+        mismatches += chess[g].position().fen() != table.position((Game_ref) g).fen();
+
+    std::printf("%-12s %10s %12s %10s\n", "mode", "played", "moves/s", "ns/move");
+    std::printf("%-12s %10zu %12.0f %10.1f\n", "one-by-one", played_single, total / single, 1e9 * single / total);
+    std::printf("%-12s %10zu %12.0f %10.1f\n", "batch", played_batch, total / batch, 1e9 * batch / total);
+    std::printf("speedup %.2fx, %d mismatching games\n", single / batch, mismatches);
+    return mismatches ? 2 : 0;
+}
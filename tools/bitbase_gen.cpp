@@ -0,0 +1,134 @@
+// Endgame bitbase generator : writes the win / draw / loss tables of the given materials (and of every smaller one they lead to)
+// into a directory, for the engine to map (Search::use_bitbases, the UCI BitbaseDir option).
+// Second mode probes one position against a directory of tables.
+// Third mode checks a table against itself : every position's value must follow from its moves' (probed through the tables).
+// Usage : bitbase_gen <dir> <material>... [--threads N] [--scratch <dir>]
+//         bitbase_gen probe <dir> "<FEN>"
+//         bitbase_gen verify <dir> <material>
+#include "../chess_bitbase.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+static const char* WDL_NAME[4] = {"draw", "win", "loss", "illegal"};
+
+static int probe(const std::string& dir, const std::string& fen) {
+    Bitbases tables;
+    tables.load_dir(dir);
+    Position pos;
+    if (!pos.set_fen(fen)) {
+        std::fprintf(stderr, "bad FEN\n");
+        return 1;
+    }
+    Wdl v;
+    if (!tables.probe(pos, v)) {
+        std::printf("not covered (%s)\n", Bitbase_material::of(pos).name().c_str());
+        return 1;
+    }
+    std::printf("%s for %s\n", WDL_NAME[v], pos.turn == WHITE ? "white" : "black");
+    return 0;
+}
+
+static int verify(const std::string& dir, const std::string& material) {
+    Bitbase_material m;
+    if (!m.parse(material)) {
+        std::fprintf(stderr, "bad material %s\n", material.c_str());
+        return 1;
+    }
+    if (!m.is_canonical())
+        m = m.flipped();
+    Bitbases tables;
+    tables.load_dir(dir);
+    Bitbase table;
+    Mapped_status status = table.open(bitbase_path(dir, m), m);
+    if (status != MAPPED_WARM) {
+        std::fprintf(stderr, "%s : %s\n", bitbase_path(dir, m).c_str(), mapped_status_name(status));
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const chess_ns::Bitbase_layout& layout = table.index_layout();
+    uint64_t positions = 0, wtm_wins = 0, wtm = 0, errors = 0, uncovered = 0;
+    int squares[BITBASE_MAX_MEN];
+    Color turn;
+    Position pos;
+    for (uint64_t i = 0; i < layout.size; i++) {
+        Wdl stored = table.value(i);
+        if (stored == WDL_ILLEGAL)
+            continue;
+        layout.decode(i, squares, turn);
+        layout.set_position(pos, squares, turn);
+        positions++;
+        wtm += turn == WHITE;
+        wtm_wins += turn == WHITE && stored == WDL_WIN;
+
+        Move16 list[MAX_MOVES];
+        int n = pos.generate_moves(list);
+        Wdl expected = pos.in_check() ? WDL_LOSS : WDL_DRAW;
+        bool all_wins = n > 0;
+        for (int k = 0; k < n && expected != WDL_WIN; k++) {
+            Position child = pos;
+            child.play(list[k]);
+            Wdl v;
+            if (!tables.probe(child, v)) {
+                uncovered++;
+                v = WDL_DRAW;
+            }
+            if (v == WDL_LOSS)
+                expected = WDL_WIN;
+            all_wins &= v == WDL_WIN;
+        }
+        if (n > 0 && expected != WDL_WIN)
+            expected = all_wins ? WDL_LOSS : WDL_DRAW;
+        if (stored != expected && errors++ < 10)
+            std::printf("mismatch : %s stored %s, moves give %s\n", pos.fen().c_str(), WDL_NAME[stored], WDL_NAME[expected]);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%s : %llu positions, white to move wins %.2f%%, %llu mismatches, %llu moves not covered, %.1f s\n", m.name().c_str(),
+                (unsigned long long) positions, wtm ? 100.0 * wtm_wins / wtm : 0.0, (unsigned long long) errors,
+                (unsigned long long) uncovered, seconds);
+    return (errors || uncovered) ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 3 && std::string(argv[1]) == "probe")
+        return probe(argv[2], argv[3]);
+    if (argc > 3 && std::string(argv[1]) == "verify")
+        return verify(argv[2], argv[3]);
+    if (argc < 3) {
+        std::fprintf(stderr, "usage : bitbase_gen <dir> <material>... [--threads N] [--scratch <dir>]\n"
+                             "        bitbase_gen probe <dir> \"<FEN>\"\n"
+                             "        bitbase_gen verify <dir> <material>\n");
+        return 1;
+    }
+
+    std::string dir = argv[1];
+    Bitbase_options options;
+    std::vector<std::string> materials;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc)
+            options.threads = std::atoi(argv[++i]);
+        else if (arg == "--scratch" && i + 1 < argc)
+            options.scratch_dir = argv[++i];
+        else
+            materials.push_back(arg);
+    }
+    std::filesystem::create_directories(dir);
+    options.on_table = [](const Bitbase_stats& s) {
+        std::printf("%-8s %12llu positions  win %5.2f%%  draw %5.2f%%  loss %5.2f%%  %3d levels  %8.2f s\n", s.name.c_str(),
+                    (unsigned long long) s.positions, 100.0 * s.wins / s.positions, 100.0 * s.draws / s.positions,
+                    100.0 * s.losses / s.positions, s.levels, s.seconds);
+        std::fflush(stdout);
+    };
+    for (const std::string& material : materials) {
+        if (!generate_bitbase(material, dir, options)) {
+            std::fprintf(stderr, "%s : failed\n", material.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
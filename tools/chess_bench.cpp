@@ -0,0 +1,648 @@
+// Micro-benchmarks for the library's core primitives. Each benchmark is warmed up, then timed over a number of samples (batches of
+// operations sized to take ~min-time each) ; reports median and MAD (median absolute deviation) of ns per operation.
+// Results can be written as JSON lines and later passed back as a baseline to flag regressions between commits.
+// --allocs counts heap allocations instead (global operator new is hooked), per game / search, for the scopes meant to run
+// allocation-free once warm.
+// --perft checks move generation against the known leaf counts of the usual perft positions (every depth up to the given one), and
+// --roundtrip writes games to a game record file & reads them back (through seek() too), expecting them unchanged : the games of
+// a PGN file, or random games from the perft positions. Both exit non-zero on any mismatch.
+// Usage : chess_bench [--filter <substring>] [--samples N] [--min-time ms] [--json <out file>] [--baseline <json file>] [--threshold %]
+//         chess_bench --allocs
+//         chess_bench --perft [max depth]
+//         chess_bench --roundtrip [pgn file]
+#include "../chess.h"
+#include "../chess_utils.h"
+#include "../chess_position.h"
+#include "../chess_eval.h"
+#include "../chess_search.h"
+#include "../chess_record.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+
+typedef std::chrono::steady_clock Clock;
+
+// ------------------------------------------------------------------------- Allocation counting -------------------------------------------------------------------------
+
+// Every heap allocation of the process goes through here (single-threaded tool, a plain counter does)
+static uint64_t allocation_count = 0;
+
+void* operator new(size_t size) {
+    allocation_count++;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// Keeps the compiler from optimizing benchmarked work away
+static volatile uint64_t sink;
+
+struct Benchmark {
+    const char* name;
+    std::function<uint64_t(uint64_t)> run;          // Runs n operations, returns something derived from them (fed to sink)
+};
+
+struct Bench_result {
+    std::string name;
+    uint64_t batch;
+    int samples;
+    double median, mad, min;                        // ns per operation
+};
+
+struct Bench_options {
+    std::string filter;
+    int samples = 15;
+    double min_time_ms = 20;
+    std::string json_path, baseline_path;
+    double threshold = 5;                           // Percent
+};
+
+static double median_of(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return (n % 2) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+static double time_batch(const Benchmark& bench, uint64_t batch) {
+    auto start = Clock::now();
+    sink = sink + bench.run(batch);
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+static Bench_result measure(const Benchmark& bench, const Bench_options& options) {
+    // Calibrate : grow the batch until it takes min_time (this doubles as warm-up), then one more untimed batch
+    uint64_t batch = 1;
+    double min_ns = options.min_time_ms * 1e6;
+    while (time_batch(bench, batch) < min_ns && batch < (1ULL << 40))
+        batch *= 2;
+    time_batch(bench, batch);
+
+    std::vector<double> per_op;
+    for (int i = 0; i < options.samples; i++)
+        per_op.push_back(time_batch(bench, batch) / batch);
+
+    Bench_result r;
+    r.name = bench.name;
+    r.batch = batch;
+    r.samples = options.samples;
+    r.median = median_of(per_op);
+    r.min = *std::min_element(per_op.begin(), per_op.end());
+    std::vector<double> deviation;
+    for (double x : per_op)
+        deviation.push_back(std::fabs(x - r.median));
+    r.mad = median_of(deviation);
+    return r;
+}
+
+static std::string to_json(const Bench_result& r) {
+    char line[256];
+    std::snprintf(line, sizeof(line), "{\"name\":\"%s\",\"unit\":\"ns/op\",\"median\":%.3f,\"mad\":%.3f,\"min\":%.3f,\"samples\":%d,\"batch\":%llu}",
+                  r.name.c_str(), r.median, r.mad, r.min, r.samples, (unsigned long long) r.batch);
+    return line;
+}
+
+// Reads back what to_json() wrote, one result per line. Only name, median & mad are needed
+static std::map<std::string, Bench_result> read_baseline(const std::string& path) {
+    std::map<std::string, Bench_result> results;
+    std::ifstream in(path);
+    std::string line;
+    auto number = [&](const char* key) {
+        size_t at = line.find(key);
+        return (at == std::string::npos) ? 0.0 : std::atof(line.c_str() + at + std::strlen(key));
+    };
+    while (std::getline(in, line)) {
+        size_t at = line.find("\"name\":\"");
+        if (at == std::string::npos)
+            continue;
+        at += 8;
+        Bench_result r;
+        r.name = line.substr(at, line.find('"', at) - at);
+        r.median = number("\"median\":");
+        r.mad = number("\"mad\":");
+        results[r.name] = r;
+    }
+    return results;
+}
+
+// ------------------------------------------------------------------------------ Benchmarks ----------------------------------------------------------------------------
+
+static const char* SAN_MOVES[] = {"e4", "Nf3", "exd5", "Qxd8+", "O-O-O", "Nbd7", "R1e2", "exd8=Q#", "Kxf7", "Bb5+", "a3", "gxh8=N"};
+static const int SAN_COUNT = sizeof(SAN_MOVES) / sizeof(SAN_MOVES[0]);
+
+// Morphy vs Duke of Brunswick & Count Isouard, Paris 1858
+static const char* OPERA_GAME[] = {"e4", "e5", "Nf3", "d6", "d4", "Bg4", "dxe5", "Bxf3", "Qxf3", "dxe5", "Bc4", "Nf6", "Qb3", "Qe7", "Nc3",
+    "c6", "Bg5", "b5", "Nxb5", "cxb5", "Bxb5+", "Nbd7", "O-O-O", "Rd8", "Rxd7", "Rxd7", "Rd1", "Qe6", "Bxd7+", "Nxd7", "Qb8+", "Nxb8",
+    "Rd8#"};
+static const int OPERA_PLIES = sizeof(OPERA_GAME) / sizeof(OPERA_GAME[0]);
+
+static PType_set& piece_types() {
+    static PType_set* set = [] {
+        PType_set* s = new PType_set();
+        s->insert(new Knight());
+        s->insert(new Bishop());
+        s->insert(new Rook());
+        s->insert(new Queen());
+        s->insert(new King());
+        return s;
+    }();
+    return *set;
+}
+
+// Parsed SAN of OPERA_GAME[ply], to resolve against a position
+static San_move parse_opera_move(int ply) {
+    San_move move;
+    parse_san(OPERA_GAME[ply], move);
+    return move;
+}
+
+// Game of up to max_plies from fen (empty : standard start), moves picked by a fixed-seed generator, so that every kind of move
+// shows up (unlike in a single real game)
+static Game_record random_game(const std::string& fen, int max_plies, uint64_t& rng) {
+    Game_record game;
+    game.start_fen = fen;
+    Position pos;
+    game.start_position(pos);
+    Move16 list[MAX_MOVES];
+    for (int ply = 0; ply < max_plies; ply++) {
+        int n = pos.generate_moves(list);
+        if (n == 0)
+            break;
+        game.moves.push_back(list[chess_ns::splitmix64(rng) % n]);
+        pos.play(game.moves.back());
+    }
+    return game;
+}
+
+// Game record file for the decode benchmark, written once per run : 256 random games of up to 120 plies with a handful of tags each
+static const std::string& bench_record_path() {
+    static const std::string path = [] {
+        std::string p = (std::filesystem::temp_directory_path() / "chess_bench.cgr").string();
+        Record_writer writer;
+        writer.open(p);
+        uint64_t rng = 1;
+        for (int i = 0; i < 256; i++) {
+            Game_record game = random_game("", 120, rng);
+            game.tags = {{"Event", "chess_bench"}, {"Round", std::to_string(i + 1)}, {"White", "A"}, {"Black", "B"}};
+            writer.write_game(game);
+        }
+        writer.close();
+        return p;
+    }();
+    return path;
+}
+
+static std::vector<Benchmark> benchmarks() {
+    std::vector<Benchmark> list;
+
+    list.push_back({"parse_move", [](uint64_t n) {
+        Move<8> move(&piece_types());
+        std::string text[SAN_COUNT];
+        for (int i = 0; i < SAN_COUNT; i++)
+            text[i] = SAN_MOVES[i];
+        uint64_t valid = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            move = text[i % SAN_COUNT];                 // Assigning a string parses it
+            valid += move.is_valid();
+        }
+        return valid;
+    }});
+
+    list.push_back({"move_construct", [](uint64_t n) {
+        std::string text = "Nbd7";
+        uint64_t valid = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            Move<8> move(text, &piece_types());
+            valid += move.is_valid();
+        }
+        return valid;
+    }});
+
+    list.push_back({"move_copy", [](uint64_t n) {
+        std::string text = "exd8=Q#";
+        Move<8> from(text, &piece_types()), to(&piece_types());
+        uint64_t valid = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            to = from;
+            valid += to.is_valid();
+        }
+        return valid;
+    }});
+
+    // One push_back + one remove per operation, on a board holding a full army so the map has realistic size
+    list.push_back({"piece_map_push_remove", [](uint64_t n) {
+        Board<8> board;
+        PieceID_map<8> map;
+        Piece_type* knight = piece_types()['N'];
+        for (int file = 0; file < 8; file++)
+            for (int rank : {0, 1, 6, 7})
+                map.push_back(Piece<8>(knight, (rank < 4) ? WHITE : BLACK, {rank, file}, &board));
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            int rank = 2 + (i & 3), file = (i >> 2) & 7;
+            map.push_back(Piece<8>(knight, WHITE, {rank, file}, &board));
+            sum += board[rank][file]->id();
+            map.remove(&board[rank][file]);
+        }
+        return sum;
+    }});
+
+    // One operation = reading one cell through Board::operator[] and Row_reference::operator[]
+    list.push_back({"board_cell_access", [](uint64_t n) {
+        Board<8> board;
+        PieceID_map<8> map;
+        Piece_type* rook = piece_types()['R'];
+        for (int file = 0; file < 8; file++)
+            map.push_back(Piece<8>(rook, WHITE, {file, file}, &board));
+        uint64_t occupied = 0;
+        for (uint64_t i = 0; i < n; i++)
+            occupied += board[(i >> 3) & 7][i & 7] != nullptr;
+        return occupied;
+    }});
+
+    list.push_back({"reset_game", [](uint64_t n) {
+        Chess game;
+        uint64_t ongoing = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            game.reset_game();
+            ongoing += game.ongoing();
+        }
+        return ongoing;
+    }});
+
+    // One operation = going back to a saved game state & trying a move from it, the way analysis explores candidate lines
+    list.push_back({"snapshot_restore_move", [](uint64_t n) {
+        Chess game;
+        for (int ply = 0; ply < 20; ply++)
+            game.play_move(std::string(OPERA_GAME[ply]));
+        Chess_snapshot saved = game.snapshot();
+        Move16 candidates[MAX_MOVES];
+        int count = game.position().generate_moves(candidates);
+        uint64_t played = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            game.restore(saved);
+            played += game.play_move(candidates[i % count]);
+        }
+        return played;
+    }});
+
+    // One operation = an independent copy of a game in progress, dropped right away
+    list.push_back({"chess_fork", [](uint64_t n) {
+        Chess game;
+        for (int ply = 0; ply < 20; ply++)
+            game.play_move(std::string(OPERA_GAME[ply]));
+        uint64_t ongoing = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            Chess other = game.fork();
+            ongoing += other.ongoing();
+        }
+        return ongoing;
+    }});
+
+    // One operation = static eval of one position, pawn structure worked out every time vs. looked up in a pawn hash table. Positions
+    // are those of a real game, so consecutive evals share pawn structures about as often as search nodes do
+    for (bool cached : {false, true}) {
+        list.push_back({cached ? "evaluate_pawn_table" : "evaluate", [cached](uint64_t n) {
+            Position positions[OPERA_PLIES];
+            Position pos;
+            pos.set_start();
+            Move<8> move(&piece_types());
+            for (int ply = 0; ply < OPERA_PLIES; ply++) {
+                positions[ply] = pos;
+                move = std::string(OPERA_GAME[ply]);
+                pos.play(pos.find_move(move));
+            }
+            Pawn_table pawns;
+            uint64_t sum = 0;
+            for (uint64_t i = 0; i < n; i++)
+                sum += evaluate(positions[i % OPERA_PLIES], cached ? &pawns : nullptr);
+            return sum;
+        }});
+    }
+
+    // One operation = SAN of one legal move (cycling through all moves of a busy middlegame position), as PGN export writes them
+    list.push_back({"write_san", [](uint64_t n) {
+        Position pos;
+        pos.set_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+        Move16 moves[MAX_MOVES];
+        int count = pos.generate_moves(moves);
+        char text[SAN_MAX];
+        uint64_t length = 0;
+        for (uint64_t i = 0; i < n; i++)
+            length += pos.write_san(moves[i % count], text);
+        return length;
+    }});
+
+    // One operation = one whole game played into a Chess object (back to the start position through a snapshot each time) : SAN
+    // moves through play_move(), vs. the same moves as Move16 through replay(), checked and trusted (with every key written out)
+    list.push_back({"chess_play_game_san", [](uint64_t n) {
+        Chess game;
+        Chess_snapshot start = game.snapshot();
+        std::string text[OPERA_PLIES];
+        for (int i = 0; i < OPERA_PLIES; i++)
+            text[i] = OPERA_GAME[i];
+        uint64_t played = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            game.restore(start);
+            for (int ply = 0; ply < OPERA_PLIES; ply++)
+                played += game.play_move(text[ply]);
+        }
+        return played;
+    }});
+
+    for (bool trusted : {false, true}) {
+        list.push_back({trusted ? "chess_replay_trusted" : "chess_replay_checked", [trusted](uint64_t n) {
+            Chess game;
+            Chess_snapshot start = game.snapshot();
+            Move16 moves[OPERA_PLIES];
+            for (int ply = 0; ply < OPERA_PLIES; ply++) {
+                moves[ply] = game.position().find_move(parse_opera_move(ply));
+                game.play_move(moves[ply]);
+            }
+            uint64_t keys[OPERA_PLIES], sum = 0;
+            for (uint64_t i = 0; i < n; i++) {
+                game.restore(start);
+                sum += game.replay(std::span<const Move16>(moves, OPERA_PLIES), trusted, keys);
+                sum ^= keys[OPERA_PLIES - 1];
+            }
+            return sum;
+        }});
+    }
+
+    // One operation = one game read back from a game record file : block decompression, tags, and every move recovered from its
+    // index & played (games/s is 1e9 / ns)
+    list.push_back({"record_decode_game", [path = bench_record_path()](uint64_t n) {
+        Record_reader reader;
+        if (!reader.open(path))
+            return (uint64_t) 0;
+        Game_record game;
+        uint64_t plies = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            if (!reader.next_game(game)) {
+                reader.seek(0);
+                reader.next_game(game);
+            }
+            plies += game.moves.size();
+        }
+        return plies;
+    }});
+
+    // One operation = one whole game : parse every SAN move, resolve it against the legal moves, play it
+    list.push_back({"game_replay", [](uint64_t n) {
+        Move<8> move(&piece_types());
+        std::string text[OPERA_PLIES];
+        for (int i = 0; i < OPERA_PLIES; i++)
+            text[i] = OPERA_GAME[i];
+        uint64_t keys = 0;
+        for (uint64_t i = 0; i < n; i++) {
+            Position pos;
+            pos.set_start();
+            for (int ply = 0; ply < OPERA_PLIES; ply++) {
+                move = text[ply];
+                Move16 m = pos.find_move(move);
+                if (m.is_null())
+                    return keys;                        // Can't happen, but never play a null move
+                pos.play(m);
+            }
+            keys ^= pos.key;
+        }
+        return keys;
+    }});
+    return list;
+}
+
+// Allocations per operation, once warm (one untimed run first : a fresh object's first use is set-up, not steady state)
+static void allocation_report() {
+    struct Alloc_case {
+        const char* name;
+        std::function<void()> run;
+    };
+    Chess game;
+    Search search(16);
+    Position start;
+    start.set_start();
+    std::string pgn_text = "[Event \"Paris Opera, casual game between the Duke of Brunswick & Count Isouard and Paul Morphy\"]\n"
+                           "[White \"Paul Morphy\"]\n[Black \"Duke of Brunswick and Count Isouard\"]\n[Result \"1-0\"]\n\n";
+    for (int ply = 0; ply < OPERA_PLIES; ply++)
+        pgn_text += std::string(OPERA_GAME[ply]) + " ";
+    pgn_text += "1-0\n\n";
+    std::string pgn_games;
+    for (int i = 0; i < 101; i++)
+        pgn_games += pgn_text;
+    std::istringstream pgn_in(pgn_games);
+    Pgn_reader pgn(pgn_in);
+    Game_record record;
+
+    std::vector<Alloc_case> cases = {
+        {"reset_game", [&] { game.reset_game(); }},
+        {"play_game_san", [&] {
+            game.reset_game();
+            for (int ply = 0; ply < OPERA_PLIES; ply++)
+                game.play_move(std::string(OPERA_GAME[ply]));
+        }},
+        {"pgn_read_game", [&] { pgn.next_game(record); }},
+        {"search_depth_5", [&] {
+            Search_limits limits;
+            limits.depth = 5;
+            search.search(start, limits);
+        }},
+    };
+    const int runs = 100;
+    std::printf("%-24s %12s\n", "scope", "allocs/op");
+    for (Alloc_case& c : cases) {
+        c.run();
+        uint64_t before = allocation_count;
+        for (int i = 0; i < runs; i++)
+            c.run();
+        std::printf("%-24s %12.2f\n", c.name, (double) (allocation_count - before) / runs);
+    }
+}
+
+// ------------------------------------------------------------------------------ Checks --------------------------------------------------------------------------------
+
+// The usual perft positions (start, "Kiwipete", and positions 3 to 6 of the Chess Programming Wiki page), with their leaf counts at
+// depth 1, 2, ... (0 ends the list)
+struct Perft_position {
+    const char* fen;
+    uint64_t nodes[7];
+};
+
+static const Perft_position PERFT_SUITE[] = {
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", {20, 400, 8902, 197281, 4865609} },
+    { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", {48, 2039, 97862, 4085603} },
+    { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", {14, 191, 2812, 43238, 674624, 11030083} },
+    { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", {6, 264, 9467, 422333, 15833292} },
+    { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", {44, 1486, 62379, 2103487} },
+    { "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", {46, 2079, 89890, 3894594} }
+};
+
+static uint64_t perft(const Position& pos, int depth) {
+    Move16 list[MAX_MOVES];
+    int n = pos.generate_moves(list);
+    if (depth == 1)
+        return n;
+    uint64_t nodes = 0;
+    for (int i = 0; i < n; i++) {
+        Position next = pos;
+        next.play(list[i]);
+        nodes += perft(next, depth - 1);
+    }
+    return nodes;
+}
+
+// Leaf counts of the suite, every depth up to max_depth, against the known ones. Returns the number of mismatches
+static int perft_check(int max_depth) {
+    int failures = 0;
+    std::printf("%-5s %-5s %12s %12s %10s %8s\n", "pos", "depth", "nodes", "expected", "ms", "Mnps");
+    for (size_t i = 0; i < sizeof(PERFT_SUITE) / sizeof(PERFT_SUITE[0]); i++) {
+        Position pos;
+        pos.set_fen(PERFT_SUITE[i].fen);
+        for (int depth = 1; depth <= max_depth && depth <= 7 && PERFT_SUITE[i].nodes[depth - 1]; depth++) {
+            auto start = Clock::now();
+            uint64_t nodes = perft(pos, depth), expected = PERFT_SUITE[i].nodes[depth - 1];
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            failures += nodes != expected;
+            std::printf("%-5zu %-5d %12llu %12llu %10.1f %8.2f%s\n", i + 1, depth, (unsigned long long) nodes, (unsigned long long) expected,
+                        ms, ms > 0 ? nodes / ms / 1000 : 0.0, (nodes == expected) ? "" : "  MISMATCH");
+        }
+    }
+    std::printf("%s\n", failures ? "perft FAILED" : "perft OK");
+    return failures;
+}
+
+static bool same_game(const Game_record& a, const Game_record& b) {
+    return a.tags == b.tags && a.start_fen == b.start_fen && a.result == b.result && a.moves == b.moves;
+}
+
+// Games written to a game record file & read back must come out identical, in file order and through seek(). Games are those of a
+// PGN file, or else random ones from the perft positions (castling, en passant, promotions & checks all over). Returns mismatches
+static uint64_t roundtrip_check(const std::string& pgn_path) {
+    std::vector<Game_record> games;
+    if (!pgn_path.empty()) {
+        std::ifstream in(pgn_path);
+        Pgn_reader pgn(in);
+        Game_record game;
+        std::string error;
+        while (pgn.next_game(game, &error))
+            if (error.empty())
+                games.push_back(game);
+    }
+    else {
+        uint64_t rng = 1;
+        for (int i = 0; i < 3000; i++) {
+            const char* fen = PERFT_SUITE[i % (sizeof(PERFT_SUITE) / sizeof(PERFT_SUITE[0]))].fen;
+            games.push_back(random_game((i % 6) ? fen : "", 200, rng));
+            games.back().result = (Game_result) (i % 4);
+            games.back().tags = {{"Round", std::to_string(i + 1)}};
+        }
+    }
+
+    // Small blocks, so that seeking crosses many of them
+    std::string path = (std::filesystem::temp_directory_path() / "chess_bench_roundtrip.cgr").string();
+    Record_writer writer;
+    uint64_t written = 0, plies = 0, mismatches = 0;
+    if (!writer.open(path, 4096)) {
+        std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return 1;
+    }
+    for (const Game_record& game : games) {
+        written += writer.write_game(game);
+        plies += game.moves.size();
+    }
+    writer.close();
+
+    Record_reader reader;
+    Game_record back;
+    uint64_t read = 0;
+    if (!reader.open(path) || reader.game_count() != written)
+        mismatches++;
+    for (; reader.next_game(back); read++)
+        mismatches += read >= games.size() || !same_game(back, games[read]);
+    mismatches += read != written;
+    for (uint64_t id = 0; id < written; id += 97)
+        mismatches += !reader.seek(id) || !reader.next_game(back) || !same_game(back, games[id]);
+    std::filesystem::remove(path);
+
+    std::printf("%llu games, %llu plies written, %llu read back : %llu mismatches\n%s\n", (unsigned long long) written,
+                (unsigned long long) plies, (unsigned long long) read, (unsigned long long) mismatches,
+                mismatches ? "round-trip FAILED" : "round-trip OK");
+    return mismatches;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 2 && std::string(argv[1]) == "--allocs") {
+        allocation_report();
+        return 0;
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--perft")
+        return perft_check((argc > 2) ? std::atoi(argv[2]) : 7) ? 1 : 0;
+    if (argc >= 2 && std::string(argv[1]) == "--roundtrip")
+        return roundtrip_check((argc > 2) ? argv[2] : "") ? 1 : 0;
+    Bench_options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--filter" && has_value) options.filter = argv[++i];
+        else if (arg == "--samples" && has_value) options.samples = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--min-time" && has_value) options.min_time_ms = std::atof(argv[++i]);
+        else if (arg == "--json" && has_value) options.json_path = argv[++i];
+        else if (arg == "--baseline" && has_value) options.baseline_path = argv[++i];
+        else if (arg == "--threshold" && has_value) options.threshold = std::atof(argv[++i]);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--filter <substring>] [--samples N] [--min-time ms] [--json <out file>]"
+                      << " [--baseline <json file>] [--threshold %]\n       " << argv[0] << " --allocs | --perft [max depth]"
+                      << " | --roundtrip [pgn file]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::map<std::string, Bench_result> baseline;
+    if (!options.baseline_path.empty())
+        baseline = read_baseline(options.baseline_path);
+    std::ofstream json;
+    if (!options.json_path.empty()) {
+        json.open(options.json_path);
+        if (!json) {
+            std::cerr << "Cannot write " << options.json_path << std::endl;
+            return 1;
+        }
+    }
+
+    int regressions = 0;
+    std::printf("%-24s %12s %10s %10s %10s %s\n", "benchmark", "median ns", "mad", "min", "batch", baseline.empty() ? "" : "  vs baseline");
+    for (const Benchmark& bench : benchmarks()) {
+        if (!options.filter.empty() && std::string(bench.name).find(options.filter) == std::string::npos)
+            continue;
+        Bench_result r = measure(bench, options);
+        std::printf("%-24s %12.2f %10.2f %10.2f %10llu", r.name.c_str(), r.median, r.mad, r.min, (unsigned long long) r.batch);
+        auto base = baseline.find(r.name);
+        if (base != baseline.end() && base->second.median > 0) {
+            double change = 100 * (r.median / base->second.median - 1);
+            // Slower beyond the threshold, and by more than the noise of both runs
+            bool regressed = change > options.threshold && r.median - base->second.median > 3 * (r.mad + base->second.mad);
+            regressions += regressed;
+            std::printf("  %+7.1f%%%s", change, regressed ? "  REGRESSION" : "");
+        }
+        std::printf("\n");
+        if (json)
+            json << to_json(r) << "\n";
+    }
+    return regressions ? 2 : 0;
+}
@@ -0,0 +1,45 @@
+// PGN <-> binary game record (.cgr) converter
+// Usage : chess_convert pgn2cgr <in.pgn> <out.cgr> [--trace <out.json>]
+//         chess_convert cgr2pgn <in.cgr> <out.pgn> [--trace <out.json>]
+// --trace : Chrome trace of the conversion (PGN chunks parsed, record blocks written), needs a -DCHESS_TRACE build.
+#include "../chess_record.h"
+#include "../chess_trace.h"
+#include <iostream>
+
+static int convert(const std::string& mode, const char* input, const char* output) {
+    if (mode == "pgn2cgr") {
+        uint64_t skipped = 0;
+        uint64_t count = pgn_to_record(input, output, &skipped);
+        std::cout << "Converted " << count << " games, skipped " << skipped << " with illegal / unparseable moves" << std::endl;
+        return count ? 0 : 1;
+    }
+    if (mode == "cgr2pgn") {
+        uint64_t count = record_to_pgn(input, output);
+        std::cout << "Converted " << count << " games" << std::endl;
+        return count ? 0 : 1;
+    }
+    std::cerr << "Unknown mode " << mode << std::endl;
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    bool trace = (argc == 6 && std::string(argv[4]) == "--trace");
+    if (argc != 4 && !trace) {
+        std::cerr << "Usage: " << argv[0] << " pgn2cgr|cgr2pgn <input> <output> [--trace <out.json>]" << std::endl;
+        return 1;
+    }
+    if (trace) {
+        if (!chess_ns::trace_compiled())
+            std::cerr << "Built without CHESS_TRACE, the trace will be empty" << std::endl;
+        chess_ns::trace_start();
+    }
+    int status = convert(argv[1], argv[2], argv[3]);
+    if (trace) {
+        chess_ns::trace_stop();
+        if (!chess_ns::trace_dump(argv[5])) {
+            std::cerr << "Cannot write " << argv[5] << std::endl;
+            return 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,54 @@
+// Position search index over a game-record archive
+// Usage : chess_index build <in.cgr> <out.idx> [threads] [memory MB]
+//         chess_index query <in.idx> "<FEN>" [limit]
+#include "../chess_index.h"
+#include <chrono>
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " build <in.cgr> <out.idx> [threads] [memory MB]" << std::endl;
+        std::cerr << "       " << argv[0] << " query <in.idx> \"<FEN>\" [limit]" << std::endl;
+        return 1;
+    }
+    std::string mode = argv[1];
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed_ms = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    if (mode == "build") {
+        Index_build_options options;
+        if (argc > 4) options.threads = std::atoi(argv[4]);
+        if (argc > 5) options.memory_budget = (uint64_t) std::atoll(argv[5]) << 20;
+        uint64_t entries = build_position_index(argv[2], argv[3], options);
+        if (!entries) {
+            std::cerr << "Index build failed" << std::endl;
+            return 1;
+        }
+        std::cout << "Indexed " << entries << " positions in " << elapsed_ms() << " ms" << std::endl;
+        return 0;
+    }
+    if (mode == "query") {
+        Position pos;
+        Position_index index;
+        if (!pos.set_fen(argv[3])) {
+            std::cerr << "Bad FEN" << std::endl;
+            return 1;
+        }
+        if (!index.open(argv[2])) {
+            std::cerr << "Cannot open index " << argv[2] << std::endl;
+            return 1;
+        }
+        start = std::chrono::steady_clock::now();
+        std::vector<Index_entry> matches;
+        uint64_t found = index.find(pos, matches, (argc > 4) ? std::atoll(argv[4]) : 0);
+        double ms = elapsed_ms();
+        for (auto& entry : matches)
+            std::cout << "game " << entry.game << " ply " << entry.ply << std::endl;
+        std::cout << found << " matches in " << ms << " ms" << std::endl;
+        return 0;
+    }
+    std::cerr << "Unknown mode " << mode << std::endl;
+    return 1;
+}
@@ -0,0 +1,295 @@
+// Engine-vs-engine tournament between two search configurations, games played concurrently (one game per worker thread), each
+// opening played twice with colors swapped. Results feed an SPRT, which stops the run as soon as either hypothesis is accepted.
+// Usage : chess_tournament <openings file> [--threads N] [--games N] [--a <config>] [--b <config>] [--elo0 E] [--elo1 E] [--alpha A]
+//                          [--beta B] [--max-plies N] [--trace <out.json>]
+// Openings file : one opening per line, either a FEN or SAN moves from the start position ("e4 e5 Nf3"), # starts a comment.
+// Engine config : comma separated key=value among depth, nodes, movetime (ms), tc (ms, "time+increment"), hash (MB), quiescence,
+//                 see, delta (0 / 1). Default is depth=6. Engine b is the one under test, Elo is b's gain over a.
+// --trace : Chrome trace of the run (workers, games, searches & iterations, waits on the results lock), needs a -DCHESS_TRACE build.
+#include "../chess.h"
+#include "../chess_search.h"
+#include "../chess_trace.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+struct Engine_config {
+    Search_limits limits;
+    Search_options options;
+    size_t hash_mb = 16;
+    int64_t time = 0, increment = 0;            // Game clock (tc), 0 = none
+
+    Engine_config() {
+        limits.depth = 6;
+    }
+};
+
+static bool parse_config(const std::string& text, Engine_config& config) {
+    std::stringstream in(text);
+    std::string item;
+    bool depth_set = false;
+    while (std::getline(in, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos)
+            return false;
+        std::string key = item.substr(0, eq), value = item.substr(eq + 1);
+        long long n = std::atoll(value.c_str());
+        if (key == "depth") {
+            config.limits.depth = std::max(1LL, std::min<long long>(n, MAX_PLY - 1));
+            depth_set = true;
+        }
+        else if (key == "nodes") config.limits.nodes = n;
+        else if (key == "movetime") config.limits.clock.move_time = n;
+        else if (key == "tc") {
+            config.time = n;
+            size_t plus = value.find('+');
+            config.increment = (plus == std::string::npos) ? 0 : std::atoll(value.c_str() + plus + 1);
+        }
+        else if (key == "hash") config.hash_mb = std::max(1LL, n);
+        else if (key == "quiescence") config.options.quiescence = n != 0;
+        else if (key == "see") config.options.see_pruning = n != 0;
+        else if (key == "delta") config.options.delta_pruning = n != 0;
+        else return false;
+    }
+    // With a clock, depth is only a cap if given
+    if ((config.time || config.limits.clock.move_time) && !depth_set)
+        config.limits.depth = MAX_PLY - 1;
+    return true;
+}
+
+// ------------------------------------------------------------------------------ SPRT ----------------------------------------------------------------------------------
+
+// Log-likelihood ratio of elo1 vs elo0 (logistic Elo) for a W / D / L count, using the normal approximation of the score distribution
+// (GSPRT, as in Fishtest's trinomial model)
+static double sprt_llr(int wins, int draws, int losses, double elo0, double elo1) {
+    int n = wins + draws + losses;
+    if (!n)
+        return 0;
+    double score = (wins + 0.5 * draws) / n;
+    double var = (wins * std::pow(1 - score, 2) + draws * std::pow(0.5 - score, 2) + losses * std::pow(score, 2)) / n;
+    if (var <= 0)
+        return 0;                                   // All results identical so far, no spread to judge from
+    auto expected = [](double elo) { return 1 / (1 + std::pow(10.0, -elo / 400)); };
+    double s0 = expected(elo0), s1 = expected(elo1);
+    return n * (s1 - s0) * (2 * score - s0 - s1) / (2 * var);
+}
+
+static double elo_of(double score) {
+    score = std::min(std::max(score, 1e-3), 1 - 1e-3);
+    return -400 * std::log10(1 / score - 1);
+}
+
+// ---------------------------------------------------------------------------- Tournament -------------------------------------------------------------------------------
+
+struct Tournament {
+    std::vector<std::string> openings;
+    Engine_config engine[2];                        // a, b
+    int max_plies = 400;                            // Adjudicated a draw past this
+    int max_games;
+    double elo0, elo1, lower, upper;
+
+    std::atomic<int> next_game{0};
+    std::atomic<bool> stop{false};
+    std::mutex lock;                                // Guards the results below
+    int wins = 0, draws = 0, losses = 0;            // From b's point of view
+    int played = 0;
+    double llr = 0;
+    std::chrono::steady_clock::time_point start;
+
+    // Plays game number id on game, returns b's result (1, 0.5, 0), or -1 if the opening couldn't be set up
+    double play(Chess& game, Search* search[2], int id) {
+        const std::string& opening = openings[(id / 2) % openings.size()];
+        int b_color = (id % 2) ? WHITE : BLACK;                 // Each opening twice, b gets both colors
+
+        game.reset_game();
+        if (opening.find('/') != std::string::npos) {
+            if (!game.set_fen(opening))
+                return -1;
+        }
+        else {
+            std::stringstream moves(opening);
+            std::string san;
+            while (moves >> san)
+                if (!game.play_move(san))
+                    return -1;
+        }
+        for (int side = 0; side < 2; side++)
+            search[side]->clear();
+
+        // Clocks per color
+        int64_t time[Color::MAX], increment[Color::MAX];
+        for (int c = WHITE; c < Color::MAX; c++) {
+            const Engine_config& config = engine[(c == b_color) ? 1 : 0];
+            time[c] = config.time;
+            increment[c] = config.increment;
+        }
+
+        for (int ply = 0; game.ongoing() && ply < max_plies; ply++) {
+            Color turn = game.position().turn;
+            int side = (turn == b_color) ? 1 : 0;
+            Search_limits limits = engine[side].limits;
+            if (time[turn]) {
+                for (int c = WHITE; c < Color::MAX; c++) {
+                    limits.clock.time[c] = time[c];
+                    limits.clock.increment[c] = increment[c];
+                }
+            }
+            auto move_start = std::chrono::steady_clock::now();
+            Key_history keys = game.history();
+            Search_result result = search[side]->search(game.position(), limits, &keys);
+            if (time[turn]) {
+                time[turn] -= std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - move_start).count();
+                if (time[turn] <= 0)
+                    return (side == 1) ? 0 : 1;                 // Lost on time
+                time[turn] += increment[turn];
+            }
+            if (!game.play_move(result.best_move))
+                return (side == 1) ? 0 : 1;                     // Illegal move (can't happen short of a bug) loses
+        }
+        if (!game.has_winner())
+            return 0.5;                                         // Draw, or adjudicated one
+        Color loser = game.position().turn;                     // Side to move is the one that's mated
+        return (loser == b_color) ? 0 : 1;
+    }
+
+    void report(bool final) {
+        int n = wins + draws + losses;
+        double hours = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 3600;
+        double score = n ? (wins + 0.5 * draws) / n : 0.5;
+        std::printf("%s%d games  +%d =%d -%d  score %.3f  elo %+.1f  llr %.2f [%.2f, %.2f]  %.0f games/h\n", final ? "Final: " : "",
+                    n, wins, draws, losses, score, elo_of(score), llr, lower, upper, hours > 0 ? n / hours : 0.0);
+        std::fflush(stdout);
+    }
+
+    void record(double result) {
+        std::unique_lock<std::mutex> guard(lock, std::defer_lock);
+        {
+            CHESS_TRACE_SPAN("wait results lock");
+            guard.lock();
+        }
+        if (stop)
+            return;                                 // Decided already, games that were still running don't count
+        if (result == 1) wins++;
+        else if (result == 0) losses++;
+        else draws++;
+        played++;
+        llr = sprt_llr(wins, draws, losses, elo0, elo1);
+        if (llr >= upper || llr <= lower)
+            stop = true;
+        if (played % 100 == 0)
+            report(false);
+    }
+
+    // One worker : own Chess instance & searches, reused through reset_game() / clear() for every game it plays
+    void worker([[maybe_unused]] int index) {
+        CHESS_TRACE_THREAD("worker " + std::to_string(index));
+        CHESS_TRACE_SPAN("worker");
+        Chess game;
+        Search a(engine[0].hash_mb), b(engine[1].hash_mb);
+        a.options = engine[0].options;
+        b.options = engine[1].options;
+        Search* search[2] = {&a, &b};
+        while (!stop) {
+            int id = next_game++;
+            if (id >= max_games)
+                break;
+            double result;
+            {
+                CHESS_TRACE_SPAN_ARG("game", "id", id);
+                result = play(game, search, id);
+            }
+            if (result < 0) {
+                std::lock_guard<std::mutex> guard(lock);
+                std::cerr << "Skipping bad opening : " << openings[(id / 2) % openings.size()] << std::endl;
+                continue;
+            }
+            record(result);
+        }
+    }
+};
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <openings file> [--threads N] [--games N] [--a <config>] [--b <config>]"
+                  << " [--elo0 E] [--elo1 E] [--alpha A] [--beta B] [--max-plies N] [--trace <out.json>]" << std::endl;
+        return 1;
+    }
+    Tournament t;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    t.max_games = 20000;
+    double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+    std::string trace_path;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        bool ok = true;
+        if (arg == "--threads") threads = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--games") t.max_games = std::atoi(value.c_str());
+        else if (arg == "--a") ok = parse_config(value, t.engine[0]);
+        else if (arg == "--b") ok = parse_config(value, t.engine[1]);
+        else if (arg == "--elo0") elo0 = std::atof(value.c_str());
+        else if (arg == "--elo1") elo1 = std::atof(value.c_str());
+        else if (arg == "--alpha") alpha = std::atof(value.c_str());
+        else if (arg == "--beta") beta = std::atof(value.c_str());
+        else if (arg == "--max-plies") t.max_plies = std::atoi(value.c_str());
+        else if (arg == "--trace") trace_path = value;
+        else ok = false;
+        if (!ok) {
+            std::cerr << "Bad argument " << arg << " " << value << std::endl;
+            return 1;
+        }
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        while (!line.empty() && std::isspace((unsigned char) line.back()))
+            line.pop_back();
+        if (!line.empty())
+            t.openings.push_back(line);
+    }
+    if (t.openings.empty()) {
+        std::cerr << "No openings in " << argv[1] << std::endl;
+        return 1;
+    }
+
+    t.elo0 = elo0;
+    t.elo1 = elo1;
+    t.lower = std::log(beta / (1 - alpha));
+    t.upper = std::log((1 - beta) / alpha);
+    t.start = std::chrono::steady_clock::now();
+    std::printf("%zu openings, %d threads, SPRT elo0 %.1f elo1 %.1f alpha %.3f beta %.3f\n", t.openings.size(), threads, elo0, elo1,
+                alpha, beta);
+
+    if (!trace_path.empty()) {
+        if (!chess_ns::trace_compiled())
+            std::cerr << "Built without CHESS_TRACE, the trace will be empty" << std::endl;
+        chess_ns::trace_start();
+    }
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++)
+        pool.emplace_back(&Tournament::worker, &t, i);
+    for (auto& thread : pool)
+        thread.join();
+    if (!trace_path.empty()) {
+        chess_ns::trace_stop();
+        if (!chess_ns::trace_dump(trace_path))
+            std::cerr << "Cannot write " << trace_path << std::endl;
+    }
+
+    t.report(true);
+    if (t.llr >= t.upper) std::printf("H1 accepted : b is stronger by elo1 or more\n");
+    else if (t.llr <= t.lower) std::printf("H0 accepted : b is not stronger by elo1\n");
+    else std::printf("Inconclusive\n");
+    return 0;
+}
@@ -0,0 +1,171 @@
+// Minimal UCI front end for Search : enough for GUIs & match runners (position, go, options), searches run synchronously, so "stop"
+// isn't supported (limit searches with depth / nodes / movetime / clock instead).
+// Options : Hash (MB), MultiPV (best moves reported, one "info ... multipv k" line each), CacheFile (path : hash table & pawn cache are
+//           kept in path.tt / path.pawns across restarts, and ucinewgame no longer clears them, older entries just age out)
+//           BitbaseDir (directory of endgame tables written by bitbase_gen, probed by the search)
+// Usage : chess_uci, then UCI on stdin
+#include "../chess_search.h"
+#include "../chess_bitbase.h"
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+struct Uci_state {
+    Position pos;
+    Key_history history;
+    Search search;
+    int multi_pv = 1;
+    size_t hash_mb = 16;
+    std::string cache_path;
+    std::unique_ptr<Bitbases> bitbases;
+
+    Uci_state() : search(16) {
+        pos.set_start();
+        history.reset(pos.key);
+    }
+};
+
+static Move16 parse_uci_move(const Position& pos, const std::string& text) {
+    Move16 list[MAX_MOVES];
+    int n = pos.generate_moves(list);
+    for (int i = 0; i < n; i++)
+        if (pos.uci(list[i]) == text)
+            return list[i];
+    return Move16();
+}
+
+// position [startpos | fen <6 fields>] [moves ...]
+static void set_position(Uci_state& state, std::istringstream& in) {
+    std::string token, fen;
+    in >> token;
+    if (token == "startpos") {
+        state.pos.set_start();
+        in >> token;
+    }
+    else if (token == "fen") {
+        while (in >> token && token != "moves")
+            fen += token + " ";
+        if (!state.pos.set_fen(fen))
+            state.pos.set_start();
+    }
+    state.history.reset(state.pos.key);
+    if (token != "moves")
+        return;
+    while (in >> token) {
+        Move16 move = parse_uci_move(state.pos, token);
+        if (move.is_null())
+            break;
+        state.pos.play(move);
+        state.history.push(state.pos.key);
+    }
+}
+
+static std::string score_text(int score) {
+    if (score >= MATE_BOUND) return "mate " + std::to_string((MATE_SCORE - score + 1) / 2);
+    if (score <= -MATE_BOUND) return "mate -" + std::to_string((MATE_SCORE + score) / 2);
+    return "cp " + std::to_string(score);
+}
+
+static void go(Uci_state& state, std::istringstream& in) {
+    Search_limits limits;
+    limits.multi_pv = state.multi_pv;
+    std::string token;
+    while (in >> token) {
+        long long value = 0;
+        if (token == "infinite") continue;
+        in >> value;
+        if (token == "depth") limits.depth = (int) std::max(1LL, std::min<long long>(value, MAX_PLY - 1));
+        else if (token == "nodes") limits.nodes = value;
+        else if (token == "movetime") limits.clock.move_time = value;
+        else if (token == "wtime") limits.clock.time[WHITE] = value;
+        else if (token == "btime") limits.clock.time[BLACK] = value;
+        else if (token == "winc") limits.clock.increment[WHITE] = value;
+        else if (token == "binc") limits.clock.increment[BLACK] = value;
+        else if (token == "movestogo") limits.clock.moves_to_go = (int) value;
+    }
+
+    Search_result result = state.search.search(state.pos, limits, &state.history);
+    for (size_t k = 0; k < result.lines.size(); k++) {
+        const Pv_line& line = result.lines[k];
+        // Coordinate notation only depends on the move itself, so the whole line can be written from the root position
+        std::string pv;
+        for (Move16 move : line.pv)
+            pv += " " + state.pos.uci(move);
+        std::printf("info depth %d multipv %zu score %s nodes %llu pv%s\n", result.depth, k + 1, score_text(line.score).c_str(),
+                    (unsigned long long) line.nodes, pv.c_str());
+    }
+    std::printf("bestmove %s\n", result.best_move.is_null() ? "0000" : state.pos.uci(result.best_move).c_str());
+    std::fflush(stdout);
+}
+
+static void map_caches(Uci_state& state) {
+    Search::Cache_status status = state.search.map_caches(state.cache_path, state.hash_mb);
+    std::printf("info string cache %s : hash table %s, pawn cache %s\n", state.cache_path.c_str(), mapped_status_name(status.tt),
+                mapped_status_name(status.pawns));
+}
+
+int main() {
+    Uci_state state;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream in(line);
+        std::string command;
+        in >> command;
+        if (command == "uci") {
+            std::printf("id name chess\nid author chess contributors\n");
+            std::printf("option name Hash type spin default 16 min 1 max 4096\n");
+            std::printf("option name MultiPV type spin default 1 min 1 max %d\n", MAX_MOVES);
+            std::printf("option name CacheFile type string default <empty>\n");
+            std::printf("option name BitbaseDir type string default <empty>\n");
+            std::printf("uciok\n");
+        }
+        else if (command == "isready")
+            std::printf("readyok\n");
+        else if (command == "setoption") {
+            std::string token, name, value;
+            in >> token;                            // "name"
+            while (in >> token && token != "value")
+                name += (name.empty() ? "" : " ") + token;
+            in >> value;
+            if (name == "Hash") {
+                state.hash_mb = std::max(1, std::atoi(value.c_str()));
+                if (state.cache_path.empty())
+                    state.search.resize_tt(state.hash_mb);
+                else
+                    map_caches(state);
+            }
+            else if (name == "MultiPV") state.multi_pv = std::max(1, std::min(std::atoi(value.c_str()), MAX_MOVES));
+            else if (name == "CacheFile") {
+                state.cache_path = (value == "<empty>") ? "" : value;
+                if (state.cache_path.empty())
+                    state.search.unmap_caches();
+                else
+                    map_caches(state);
+            }
+            else if (name == "BitbaseDir") {
+                state.search.use_bitbases(nullptr);
+                state.bitbases.reset();
+                if (value != "<empty>") {
+                    state.bitbases = std::make_unique<Bitbases>();
+                    int loaded = state.bitbases->load_dir(value);
+                    std::printf("info string bitbases %s : %d tables, up to %d men\n", value.c_str(), loaded, state.bitbases->max_men());
+                    state.search.use_bitbases(state.bitbases.get());
+                }
+            }
+        }
+        else if (command == "ucinewgame") {
+            if (state.cache_path.empty())
+                state.search.clear();
+        }
+        else if (command == "position")
+            set_position(state, in);
+        else if (command == "go")
+            go(state, in);
+        else if (command == "quit")
+            break;
+        std::fflush(stdout);
+    }
+    return 0;
+}
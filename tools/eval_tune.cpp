@@ -0,0 +1,119 @@
+// Texel tuner for the evaluation terms : loads labeled positions, fits the sigmoid scale to the current terms, then runs Adam on
+// all of them until the loss stops improving, and prints the tuned tables in chess_eval.cpp's own form (to paste over the old ones).
+// Files ending in .cgr are game records (quiet positions of decided games, labeled with the result), .pack files are self-play shards
+// (tools/datagen), anything else is read as lines of FEN + result (see Tuning_set::load_epd).
+// Second mode times loss + gradient passes over the loaded set copied up to a given number of positions.
+// Usage : eval_tune <file>... [--epochs N] [--threads N] [--rate R] [--skip plies] [--out <file>]
+//         eval_tune bench <positions> <file>... [--threads N]
+#include "../chess_tune.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+static bool ends_with(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Copies of the set's positions until it has count of them
+static void grow(Tuning_set& set, size_t count) {
+    size_t original = set.size();
+    for (size_t i = 0; set.size() < count; i = (i + 1) % original) {
+        for (uint64_t j = set.offsets[i]; j < set.offsets[i + 1]; j++) {
+            set.params.push_back(set.params[j]);
+            set.coefs.push_back(set.coefs[j]);
+        }
+        set.offsets.push_back(set.params.size());
+        set.results.push_back(set.results[i]);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool bench = argc > 2 && std::string(argv[1]) == "bench";
+    size_t bench_positions = bench ? std::strtoull(argv[2], nullptr, 10) : 0;
+    Tune_options options;
+    int skip = 8;
+    std::string out_path;
+    std::vector<std::string> files;
+    for (int i = bench ? 3 : 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--epochs" && i + 1 < argc) options.max_epochs = std::atoi(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) options.threads = std::atoi(argv[++i]);
+        else if (arg == "--rate" && i + 1 < argc) options.rate = std::atof(argv[++i]);
+        else if (arg == "--skip" && i + 1 < argc) skip = std::atoi(argv[++i]);
+        else if (arg == "--out" && i + 1 < argc) out_path = argv[++i];
+        else files.push_back(arg);
+    }
+    if (files.empty()) {
+        std::fprintf(stderr, "usage : eval_tune <file>... [--epochs N] [--threads N] [--rate R] [--skip plies] [--out <file>]\n"
+                             "        eval_tune bench <positions> <file>... [--threads N]\n");
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Tuning_set set;
+    for (const std::string& file : files) {
+        uint64_t added = ends_with(file, ".cgr") ? set.load_record(file, skip) : ends_with(file, ".pack") ? set.load_packed(file)
+                       : set.load_epd(file);
+        std::printf("%s : %llu positions\n", file.c_str(), (unsigned long long) added);
+    }
+    if (set.size() == 0) {
+        std::fprintf(stderr, "no positions\n");
+        return 1;
+    }
+    std::printf("%zu positions, %.1f features each, loaded in %.1f s\n", set.size(), (double) set.params.size() / set.size(),
+                seconds_since(start));
+
+    std::vector<int> current(EVAL_PARAM_COUNT);
+    eval_params(current.data());
+    std::vector<double> weights(current.begin(), current.end());
+
+    if (bench) {
+        grow(set, bench_positions);
+        std::vector<double> gradient(EVAL_PARAM_COUNT);
+        for (int threads = 1; threads <= options.threads; threads *= 2) {
+            const int PASSES = 5;
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < PASSES; i++)
+                tuning_loss(set, weights.data(), 1.0, gradient.data(), threads);
+            double s = seconds_since(start) / PASSES;
+            std::printf("%2d threads : %8.3f s per epoch, %6.1f M positions/s\n", threads, s, set.size() / s / 1e6);
+        }
+        return 0;
+    }
+
+    start = std::chrono::steady_clock::now();
+    double scale = fit_tuning_scale(set, weights.data(), options.threads);
+    double initial = tuning_loss(set, weights.data(), scale, nullptr, options.threads);
+    std::printf("scale %.4f, initial loss %.6f (%.1f s)\n", scale, initial, seconds_since(start));
+
+    start = std::chrono::steady_clock::now();
+    int epochs = 0;
+    options.on_epoch = [&](int epoch, double loss) {
+        epochs = epoch + 1;
+        if (epoch % 50 == 0) {
+            std::printf("epoch %5d  loss %.6f\n", epoch, loss);
+            std::fflush(stdout);
+        }
+    };
+    double loss = tune_eval(set, weights, scale, options);
+    double s = seconds_since(start);
+    std::printf("final loss %.6f after %d epochs, %.1f s (%.3f s per epoch)\n", loss, epochs, s, s / std::max(1, epochs));
+
+    std::vector<int> tuned(EVAL_PARAM_COUNT);
+    for (int p = 0; p < EVAL_PARAM_COUNT; p++)
+        tuned[p] = (int) std::lround(weights[p]);
+    std::string source = eval_params_source(tuned.data());
+    if (out_path.empty())
+        std::fputs(source.c_str(), stdout);
+    else
+        std::ofstream(out_path) << source;
+    return 0;
+}
@@ -0,0 +1,165 @@
+// Live game publication (Chess::view()) under concurrent readers.
+// stress : one thread plays random games, reader threads keep taking views and check each one is a consistent position (keys
+//          recomputed from scratch match, one king each, last move's piece stands on its target). Any torn read fails it.
+// latency : writer's play_move() latency (median / p99 / p99.9 / max) with 0, 1, 8 and 64 readers spinning on view(), plus the
+//           cost of a bare publication. Readers can pause between views (microseconds), like spectator feeds polling at some rate.
+// Usage : feed_bench stress [readers] [moves]
+//         feed_bench latency [moves] [reader pause us]
+#include "../chess.h"
+#include "../chess_seqlock.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Random legal move player, restarting games as they end (or drag on)
+struct Random_player {
+    uint64_t state;
+
+    Random_player(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    Move16 pick(Chess& game) {
+        if (!game.ongoing() || game.position().fullmove > 150)
+            game.reset_game();
+        Move16 list[MAX_MOVES];
+        int n = game.position().generate_moves(list);
+        return list[next() % n];
+    }
+};
+
+// Whether v could have been published : position internally consistent, last move played by the side not to move
+static bool consistent(const Game_view& v) {
+    Position fresh;
+    if (!fresh.set_fen(v.position.fen()) || fresh.key != v.position.key || fresh.pawn_key != v.position.pawn_key)
+        return false;
+    if (popcount(v.position.pieces(WHITE, KING)) != 1 || popcount(v.position.pieces(BLACK, KING)) != 1)
+        return false;
+    if (v.ply == 0)
+        return v.last_move.is_null();
+    int dst = v.last_move.dst();
+    return v.position.piece_on(dst) != PIECE_MAX && v.position.color_on(dst) != v.position.turn;
+}
+
+static int stress(int readers, uint64_t moves) {
+    Chess game;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> views{0}, failures{0};
+    std::vector<std::thread> pool;
+    for (int r = 0; r < readers; r++) {
+        pool.emplace_back([&] {
+            uint64_t seen = 0, bad = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                Game_view v = game.view();
+                seen++;
+                if (!consistent(v))
+                    bad++;
+            }
+            views += seen;
+            failures += bad;
+        });
+    }
+
+    Random_player player(0x9E3779B97F4A7C15ULL);
+    auto start = Clock::now();
+    for (uint64_t i = 0; i < moves; i++)
+        game.play_move(player.pick(game));
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    done = true;
+    for (auto& thread : pool)
+        thread.join();
+
+    std::printf("%llu moves in %.2f s with %d readers : %llu views, %llu inconsistent\n", (unsigned long long) moves, seconds, readers,
+                (unsigned long long) views.load(), (unsigned long long) failures.load());
+    return failures ? 1 : 0;
+}
+
+static double percentile(std::vector<double>& sorted, double p) {
+    return sorted[std::min(sorted.size() - 1, (size_t) (p * sorted.size()))];
+}
+
+static void latency(uint64_t moves, int pause_us) {
+    // Bare publication, no readers : what play_move pays for the feed
+    {
+        Seqlock<Game_view> feed;
+        Game_view v{};
+        v.position.set_start();
+        const int n = 1000000;
+        auto start = Clock::now();
+        for (int i = 0; i < n; i++) {
+            v.ply = (uint16_t) i;
+            feed.store(v);
+        }
+        std::printf("publish (seqlock store of %zu bytes) : %.1f ns\n\n", sizeof(Game_view),
+                    std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n);
+    }
+
+    std::printf("%-8s %10s %10s %10s %10s %10s %14s\n", "readers", "mean ns", "median", "p99", "p99.9", "max", "views/s");
+    for (int readers : {0, 1, 8, 64}) {
+        Chess game;
+        std::atomic<bool> done{false};
+        std::atomic<uint64_t> views{0};
+        std::vector<std::thread> pool;
+        for (int r = 0; r < readers; r++) {
+            pool.emplace_back([&] {
+                uint64_t seen = 0, sum = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    sum += game.view().position.key;
+                    seen++;
+                    if (pause_us)
+                        std::this_thread::sleep_for(std::chrono::microseconds(pause_us));
+                }
+                views += seen + (sum == 1);             // Keep the reads from being optimized out
+            });
+        }
+
+        Random_player player(0x2545F4914F6CDD1DULL);
+        std::vector<double> ns;
+        ns.reserve(moves);
+        auto run_start = Clock::now();
+        for (uint64_t i = 0; i < moves; i++) {
+            Move16 move = player.pick(game);
+            auto start = Clock::now();
+            game.play_move(move);
+            ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - run_start).count();
+        done = true;
+        for (auto& thread : pool)
+            thread.join();
+
+        double mean = 0;
+        for (double x : ns)
+            mean += x;
+        mean /= ns.size();
+        std::sort(ns.begin(), ns.end());
+        std::printf("%-8d %10.0f %10.0f %10.0f %10.0f %10.0f %14.0f\n", readers, mean, percentile(ns, 0.5), percentile(ns, 0.99),
+                    percentile(ns, 0.999), ns.back(), views / seconds);
+    }
+    std::printf("\n%u hardware threads : with more readers than cores, tail latencies include the writer being descheduled\n",
+                std::thread::hardware_concurrency());
+}
+
+int main(int argc, char* argv[]) {
+    std::string mode = (argc > 1) ? argv[1] : "";
+    if (mode == "stress")
+        return stress((argc > 2) ? std::max(1, std::atoi(argv[2])) : 64, (argc > 3) ? std::atoll(argv[3]) : 200000);
+    if (mode == "latency") {
+        latency((argc > 2) ? std::atoll(argv[2]) : 200000, (argc > 3) ? std::atoi(argv[3]) : 0);
+        return 0;
+    }
+    std::cerr << "Usage: " << argv[0] << " stress [readers] [moves]" << std::endl;
+    std::cerr << "       " << argv[0] << " latency [moves] [reader pause us]" << std::endl;
+    return 1;
+}
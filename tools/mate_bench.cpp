@@ -0,0 +1,98 @@
+// Mate solving benchmark : the df-pn mate solver (chess_mate.h) against the general alpha-beta search on a suite of forced mates,
+// both asked for a mate within the suite's N moves. Reports nodes & time per position, and positions solved per second.
+// Usage : mate_bench [node limit per position] [table / hash MB]
+#include "../chess_mate.h"
+#include "../chess_search.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+struct Mate_position {
+    const char* fen;
+    int mate_in;
+};
+
+// Classic patterns first, then mates that came up in engine self-play games (checked with both solvers)
+static const Mate_position SUITE[] = {
+    { "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", 1 },                                             // Back rank
+    { "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4", 1 },           // Scholar's mate
+    { "r1bq2rk/pp3pbp/2p1p1pQ/7P/3P4/2PB1N2/PP3PPR/2KR4 w - - 0 1", 2 },                    // WAC.004
+    { "r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 1", 2 },             // Legal's mate
+    { "1k5r/pP3ppp/3p2b1/1BN1n3/1Q2P3/P1B5/KP3P1P/7q w - - 1 1", 3 },
+    { "3r1r1k/1p3p1p/p2p4/4n1NN/6bQ/1BPq4/P3p1PP/1R5K w - - 0 1", 3 },
+    { "r1b1kb1r/pppp1ppp/5q2/4n3/3KP3/2N3PN/PPP4P/R1BQ1B1R b kq - 0 1", 3 },                // King hunt
+    { "r5k1/ppp3pp/8/3q2P1/bP1p1r2/3P2K1/5nP1/8 b - - 0 28", 3 },
+    { "Q7/4k1p1/8/7p/1p1P3P/7R/6Q1/6K1 w - - 1 48", 3 },
+    { "k7/2p5/p4ppp/8/1Q1P1b2/6PP/PB2KP2/5B1R w - - 0 32", 3 },
+    { "3Q4/5k2/8/8/4P3/p6R/P1P2KPB/R4B2 w - - 1 47", 3 },
+    { "2b5/rp1R1pkB/pR2pn2/4Q1N1/4p3/6P1/P1P2P1P/6K1 w - - 1 25", 4 },
+    { "2r3k1/8/p7/2p3p1/4bq2/2p1P3/1P1R3P/2K5 b - - 0 45", 4 },
+    { "r1b3kr/p1pp2b1/p3p2p/3n4/P5P1/3K4/1PP2q2/R1B5 b - - 1 25", 4 },
+    { "r1bq1b1r/p3ppp1/2P1kn1p/1N6/1P1P1B2/P4Q2/2P2P1P/R3KB1R w KQ - 1 13", 4 },
+    { "3r1rk1/pp3ppp/qb3p2/8/5PP1/P6P/6K1/6NR b - - 0 26", 5 },
+    { "4k2r/N1Q1p3/5p1b/3p4/3Pb3/4rPK1/Pq4PP/R5R1 b k - 0 22", 5 },
+    { "8/8/5B1k/8/3PBP2/8/P1P4P/1K1R2R1 w - - 9 55", 5 },
+    { "2B3k1/1p2r2p/p7/P7/1p6/7P/2P1pKP1/8 b - - 3 43", 5 }
+};
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char* argv[]) {
+    uint64_t node_limit = (argc > 1) ? std::atoll(argv[1]) : 20000000;
+    size_t mb = (argc > 2) ? std::atoi(argv[2]) : 64;
+    const int positions = sizeof(SUITE) / sizeof(SUITE[0]);
+
+    Mate_solver solver(mb);
+    Search search(mb);
+    int solved[2] = {0, 0};
+    double total_ms[2] = {0, 0};
+    uint64_t total_nodes[2] = {0, 0};
+
+    std::printf("%-3s %-5s %12s %10s %12s %10s  %s\n", "#", "mate", "df-pn nodes", "ms", "a-b nodes", "ms", "df-pn line");
+    for (int i = 0; i < positions; i++) {
+        Position pos;
+        pos.set_fen(SUITE[i].fen);
+
+        // df-pn, table cleared so each position starts cold like the search does
+        solver.clear();
+        Mate_limits mate_limits(SUITE[i].mate_in);
+        mate_limits.nodes = node_limit;
+        auto start = Clock::now();
+        Mate_result mate = solver.solve(pos, mate_limits);
+        double mate_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        bool mate_ok = mate.outcome == MATE_PROVEN && mate.mate_in == SUITE[i].mate_in;
+
+        // Alpha-beta : deep enough to see the mate, stops by itself once it has (chess_search.cpp)
+        search.clear();
+        Search_limits limits;
+        limits.depth = 2 * SUITE[i].mate_in - 1;
+        limits.nodes = node_limit;
+        start = Clock::now();
+        Search_result result = search.search(pos, limits);
+        double search_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        bool search_ok = result.score >= MATE_SCORE - (2 * SUITE[i].mate_in - 1);
+
+        solved[0] += mate_ok;
+        solved[1] += search_ok;
+        total_ms[0] += mate_ms;
+        total_ms[1] += search_ms;
+        total_nodes[0] += mate.nodes;
+        total_nodes[1] += result.nodes;
+
+        std::string line;
+        Position replay = pos;
+        for (Move16 move : mate.line) {
+            line += replay.san(move) + " ";
+            replay.play(move);
+        }
+        std::printf("%-3d %-5d %12llu %9.1f%s %12llu %9.1f%s  %s\n", i + 1, SUITE[i].mate_in, (unsigned long long) mate.nodes, mate_ms,
+                    mate_ok ? " " : "!", (unsigned long long) result.nodes, search_ms, search_ok ? " " : "!", line.c_str());
+    }
+
+    std::printf("\n%-12s %8s %14s %10s %14s\n", "solver", "solved", "nodes", "ms", "solved/s");
+    const char* names[2] = {"df-pn", "alpha-beta"};
+    for (int s = 0; s < 2; s++)
+        std::printf("%-12s %5d/%-2d %14llu %10.1f %14.1f\n", names[s], solved[s], positions, (unsigned long long) total_nodes[s],
+                    total_ms[s], 1000.0 * solved[s] / std::max(total_ms[s], 1e-3));
+    return 0;
+}
@@ -0,0 +1,211 @@
+// Fixed-depth search benchmark over a built-in suite of positions, comparing search configurations : plain alpha-beta (static eval
+// at the horizon), quiescence search, and quiescence with SEE / delta pruning
+// Second mode runs the suite under a clock instead, and reports how the time manager keeps to its limits.
+// Third mode ranks the K best moves of every position (MultiPV) for K = 1..max, and reports what each extra line costs.
+// Fourth mode searches the suite with the hash table & pawn cache mapped to files : run it twice, the second run starts warm.
+// Usage : search_bench [depth] [hash MB]
+//         search_bench clock <time ms> <increment ms> [deadline ms] [rounds]
+//         search_bench multipv [depth] [max K]
+//         search_bench warm <cache path> [depth] [hash MB]
+#include "../chess.h"
+#include "../chess_search.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+struct Bench_position {
+    const char* fen;
+    const char* best;                   // Expected best move (SAN, without check marks), nullptr if none
+};
+
+// A few quiet positions, then the first positions of Win At Chess (tactics, mostly captures and checks)
+static const Bench_position SUITE[] = {
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", nullptr },
+    { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", nullptr },
+    { "r1bqkb1r/pp3ppp/2nppn2/8/3NP3/2N5/PPP2PPP/R1BQKB1R w KQkq - 0 6", nullptr },
+    { "r2q1rk1/ppp2ppp/2np1n2/2b1p1B1/2B1P1b1/2NP1N2/PPP2PPP/R2Q1RK1 w - - 0 8", nullptr },
+    { "2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - 0 1", "Qg6" },
+    { "8/7p/5k2/5p2/p1p2P2/Pr1pPK2/1P1R3P/8 b - - 0 1", "Rxb2" },
+    { "5rk1/1ppb3p/p1pb4/6q1/3P1p1r/2P1R2P/PP1BQ1P1/5RKN w - - 0 1", "Rg3" },
+    { "r1bq2rk/pp3pbp/2p1p1pQ/7P/3P4/2PB1N2/PP3PPR/2KR4 w - - 0 1", "Qxh7" },
+    { "5k2/6pp/p1qN4/1p1p4/3P4/2PKP2Q/PP3r2/3R4 b - - 0 1", "Qc4" },
+    { "7k/p7/1R5K/6r1/6p1/6P1/8/8 w - - 0 1", "Rb7" },
+    { "rnbqkb1r/pppp1ppp/8/4P3/6n1/7P/PPPNPPP1/R1BQKBNR b KQkq - 0 1", "Ne3" },
+    { "r4q1k/p2bR1rp/2p2Q1N/5p2/5p2/2P5/PP3PPP/R5K1 w - - 0 1", "Rf7" },
+    { "3q1rk1/p4pp1/2pb3p/3p4/6Pr/1PNQ4/P1PB1PP1/4RRK1 b - - 0 1", "Bh2" },
+    { "2br2k1/2q3rn/p2NppQ1/2p1P3/Pp5R/4P3/1P3PPP/3R2K1 w - - 0 1", "Rxh7" }
+};
+
+struct Bench_mode {
+    const char* name;
+    bool quiescence, see_pruning, delta_pruning;
+};
+
+static const Bench_mode MODES[] = {
+    { "alpha-beta",     false, false, false },
+    { "quiescence",     true,  false, false },
+    { "qs+see",         true,  true,  false },
+    { "qs+see+delta",   true,  true,  true  }
+};
+
+static std::string strip_check(std::string san) {
+    while (!san.empty() && (san.back() == '+' || san.back() == '#'))
+        san.pop_back();
+    return san;
+}
+
+// Every suite position searched rounds times as if it were white's move with the given clock, overshoot of the soft & hard
+// limits recorded by the time manager
+static int clock_bench(int64_t time, int64_t increment, int64_t deadline, int rounds) {
+    const int positions = sizeof(SUITE) / sizeof(SUITE[0]);
+    Search search(64);
+    Search_limits limits;
+    limits.clock.time[WHITE] = limits.clock.time[BLACK] = time;
+    limits.clock.increment[WHITE] = limits.clock.increment[BLACK] = increment;
+    limits.clock.deadline = deadline;
+
+    double worst = 0;
+    uint64_t searches = 0;
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < positions; i++) {
+            Position pos;
+            pos.set_fen(SUITE[i].fen);
+            pos.turn = WHITE;                       // Side to move is irrelevant to the timing, keep one clock
+            auto start = std::chrono::steady_clock::now();
+            Search_result result = search.search(pos, limits);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            worst = std::max(worst, ms);
+            searches++;
+            if (result.best_move.is_null())
+                std::cerr << "No move returned for " << SUITE[i].fen << std::endl;
+        }
+    }
+    const Time_manager& timer = search.time_manager();
+    std::printf("%llu searches, soft limit %.1f ms, hard limit %.1f ms, slowest search %.3f ms\n", (unsigned long long) searches,
+                timer.soft_limit(), timer.hard_limit(), worst);
+    std::printf("Soft limit overshoot :\n%s", timer.soft_overshoot.to_string().c_str());
+    std::printf("Hard limit overshoot :\n%s", timer.hard_overshoot.to_string().c_str());
+    return 0;
+}
+
+// Whole suite at fixed depth for each K, tables cleared per position. Marginal cost of line k is what the search spent on that slot,
+// against the naive way of getting K lines (K separate searches, about K times the single-PV cost)
+static int multipv_bench(int depth, int max_k) {
+    const int positions = sizeof(SUITE) / sizeof(SUITE[0]);
+    Search search(64);
+    uint64_t single = 0;
+    std::printf("%-3s %12s %10s %10s %12s   %s\n", "K", "nodes", "ms", "vs K=1", "vs K runs", "nodes per line (slot 1, 2, ...)");
+    for (int k = 1; k <= max_k; k++) {
+        Search_limits limits;
+        limits.depth = depth;
+        limits.multi_pv = k;
+        uint64_t nodes = 0;
+        std::vector<uint64_t> per_slot(k, 0);
+        double ms = 0;
+        for (int i = 0; i < positions; i++) {
+            Position pos;
+            pos.set_fen(SUITE[i].fen);
+            search.clear();
+            auto start = std::chrono::steady_clock::now();
+            Search_result result = search.search(pos, limits);
+            ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            nodes += result.nodes;
+            for (size_t slot = 0; slot < result.lines.size(); slot++)
+                per_slot[slot] += result.lines[slot].nodes;
+        }
+        if (k == 1)
+            single = nodes;
+        std::string slots;
+        for (uint64_t n : per_slot)
+            slots += " " + std::to_string(n);
+        std::printf("%-3d %12llu %10.0f %9.2fx %11.2fx  %s\n", k, (unsigned long long) nodes, ms, (double) nodes / single,
+                    (double) nodes / (k * single), slots.c_str());
+    }
+    return 0;
+}
+
+// Suite searched once, tables kept between positions and saved to path.tt / path.pawns on the way out
+static int warm_bench(const std::string& path, int depth, size_t hash_mb) {
+    const int positions = sizeof(SUITE) / sizeof(SUITE[0]);
+    Search search(1);
+    auto start = std::chrono::steady_clock::now();
+    Search::Cache_status status = search.map_caches(path, hash_mb);
+    double map_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("hash table %s, pawn cache %s (%.0f ms to map & verify)\n", mapped_status_name(status.tt),
+                mapped_status_name(status.pawns), map_ms);
+
+    Search_limits limits;
+    limits.depth = depth;
+    uint64_t nodes = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < positions; i++) {
+        Position pos;
+        pos.set_fen(SUITE[i].fen);
+        nodes += search.search(pos, limits).nodes;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("depth %d : %llu nodes, %.0f ms, pawn cache hits %.1f%%\n", depth, (unsigned long long) nodes, ms,
+                100.0 * search.pawn_table().hit_count() / std::max<uint64_t>(search.pawn_table().probe_count(), 1));
+
+    start = std::chrono::steady_clock::now();
+    search.unmap_caches();
+    std::printf("saved in %.0f ms\n", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 2 && std::string(argv[1]) == "warm")
+        return warm_bench(argv[2], (argc > 3) ? std::atoi(argv[3]) : 8, (argc > 4) ? std::atoi(argv[4]) : 64);
+    if (argc > 1 && std::string(argv[1]) == "multipv")
+        return multipv_bench((argc > 2) ? std::atoi(argv[2]) : 6, (argc > 3) ? std::atoi(argv[3]) : 4);
+    if (argc > 3 && std::string(argv[1]) == "clock")
+        return clock_bench(std::atoll(argv[2]), std::atoll(argv[3]), (argc > 4) ? std::atoll(argv[4]) : 0,
+                           (argc > 5) ? std::atoi(argv[5]) : 5);
+
+    int depth = (argc > 1) ? std::atoi(argv[1]) : 6;
+    size_t hash_mb = (argc > 2) ? std::atoi(argv[2]) : 64;
+    const int positions = sizeof(SUITE) / sizeof(SUITE[0]);
+
+    uint64_t baseline_nodes = 0;
+    std::printf("%-14s %12s %10s %10s %8s %7s %8s %9s\n", "mode", "nodes", "ms", "knps", "ratio", "solved", "1st-cut", "pawn-hit");
+    for (const Bench_mode& mode : MODES) {
+        Search search(hash_mb);
+        search.options.quiescence = mode.quiescence;
+        search.options.see_pruning = mode.see_pruning;
+        search.options.delta_pruning = mode.delta_pruning;
+
+        Search_limits limits;
+        limits.depth = depth;
+        Ordering_stats ordering;
+        uint64_t nodes = 0, pawn_probes = 0, pawn_hits = 0;
+        int solved = 0, tactics = 0;
+        double ms = 0;
+        for (int i = 0; i < positions; i++) {
+            Position pos;
+            pos.set_fen(SUITE[i].fen);
+            search.clear();                         // Each position starts cold, so the run doesn't depend on suite order
+            auto start = std::chrono::steady_clock::now();
+            Search_result result = search.search(pos, limits);
+            ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            nodes += result.nodes;
+            ordering.cutoffs += search.ordering_stats().cutoffs;
+            ordering.first_move_cutoffs += search.ordering_stats().first_move_cutoffs;
+            pawn_probes += search.pawn_table().probe_count();
+            pawn_hits += search.pawn_table().hit_count();
+            if (SUITE[i].best) {
+                tactics++;
+                solved += strip_check(pos.san(result.best_move)) == SUITE[i].best;
+            }
+        }
+        if (!baseline_nodes)
+            baseline_nodes = nodes;
+        std::printf("%-14s %12llu %10.0f %10.0f %8.3f %4d/%-2d %8.3f %8.1f%%\n", mode.name, (unsigned long long) nodes, ms,
+                    nodes / std::max(ms, 1e-3), (double) nodes / baseline_nodes, solved, tactics, ordering.first_move_rate(),
+                    100.0 * pawn_hits / std::max<uint64_t>(pawn_probes, 1));
+    }
+    Chess_stats stats = Chess::stats();
+    if (stats.enabled)
+        std::printf("\n%s", stats.to_text().c_str());
+    return 0;
+}